@@ -0,0 +1,521 @@
+#
+/*
+ *    Copyright (C) 2020
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of channelScanner
+ *
+ *    channelScanner is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    channelScanner is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with channelScanner; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *	A simple benchmark for the kernels in the OFDM and FIC path.
+ *	Each kernel is fed with fixed (pseudo random, fixed seed) input,
+ *	the results - ns per call and samples per second - are written
+ *	as JSON on stdout.
+ */
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	<unistd.h>
+#include	<string>
+#include	<vector>
+#include	<chrono>
+#include	<complex>
+#include	<thread>
+#include	<atomic>
+#include	<algorithm>
+#include	"dab-constants.h"
+#include	"dab-api.h"
+#include	"dab-params.h"
+#include	"ringbuffer.h"
+#include	"fft_handler.h"
+#include	"phasereference.h"
+#include	"ofdm-decoder.h"
+#include	"fic-handler.h"
+#include	"tii_detector.h"
+#include	"sample-reader.h"
+#include	"sample-convert.h"
+#include	"resampler.h"
+#include	"front-end.h"
+#include	"compact-buffer.h"
+#include	"device-handler.h"
+#include	"viterbi-spiral.h"
+
+#if defined(SSE_AVAILABLE)
+#define	SPIRAL_VARIANT	"spiral-sse"
+#elif defined(NEON_AVAILABLE)
+#define	SPIRAL_VARIANT	"spiral-neon"
+#else
+#define	SPIRAL_VARIANT	"spiral-no-sse"
+#endif
+
+class	benchResult {
+public:
+	std::string	kernel;
+	std::string	unit;
+	int		samplesPerCall;
+	int64_t		calls;
+	double		totalNs;
+};
+
+static
+std::vector<benchResult> results;
+
+static
+uint32_t	seed	= 12345;
+static inline
+float	nextRandom	() {
+	seed	= seed * 1103515245 + 12345;
+	return ((seed >> 8) & 0xFFFF) / 32768.0 - 1.0;
+}
+
+static
+void	fillRandom	(std::complex<float> *v, int n) {
+	for (int i = 0; i < n; i ++)
+	   v [i] = std::complex<float> (nextRandom (), nextRandom ());
+}
+//
+//	prepare () is called outside of the timed region, kernel () inside
+template <typename P, typename F>
+static
+void	measure		(const std::string &kernel,
+	                 const std::string &unit,
+	                 int samplesPerCall, int calls,
+	                 P prepare, F f) {
+benchResult r;
+	for (int i = 0; i < 10; i ++) {		// warming up
+	   prepare ();
+	   f ();
+	}
+	r. kernel		= kernel;
+	r. unit			= unit;
+	r. samplesPerCall	= samplesPerCall;
+	r. calls		= calls;
+	r. totalNs		= 0;
+	for (int i = 0; i < calls; i ++) {
+	   prepare ();
+	   auto start	= std::chrono::steady_clock::now ();
+	   f ();
+	   auto stop	= std::chrono::steady_clock::now ();
+	   r. totalNs	+= std::chrono::duration<double, std::nano>
+	                                             (stop - start). count ();
+	}
+	results. push_back (r);
+}
+
+static
+void	nothing		() {}
+
+static
+void	syncsignalHandler	(bool b, void *ctx) {
+	(void)b; (void)ctx;
+}
+
+static
+void	ensembleHandler		(std::string s, int32_t id, void *ctx) {
+	(void)s; (void)id; (void)ctx;
+}
+
+static
+void	programnameHandler	(std::string s, int32_t id, void *ctx) {
+	(void)s; (void)id; (void)ctx;
+}
+
+//
+//	one writer thread, the reader (this thread) waits for whole
+//	blocks, the time per block includes the hand over. T_s does not
+//	divide the buffer size, so the plain buffer splits now and then
+static
+void	streamRing	(int blockSize, int blocks, bool mirrored) {
+RingBuffer<std::complex<float>> ring (16 * 32768, mirrored);
+std::vector<std::complex<float>> in (blockSize), out (blockSize);
+benchResult r;
+	fillRandom (in. data (), blockSize);
+	auto start	= std::chrono::steady_clock::now ();
+	std::thread writer ([&] () {
+	   for (int i = 0; i < blocks; i ++) {
+	      ring. WaitForWriteAvailable (blockSize, 1000);
+	      ring. putDataIntoBuffer (in. data (), blockSize);
+	   }
+	});
+	for (int i = 0; i < blocks; i ++) {
+	   ring. WaitForReadAvailable (blockSize, 1000);
+	   ring. getDataFromBuffer (out. data (), blockSize);
+	}
+	auto stop	= std::chrono::steady_clock::now ();
+	writer. join ();
+	r. kernel		= ring. isMirrored () ?
+	                            "RingBuffer::stream/mirrored" :
+	                            "RingBuffer::stream";
+	r. unit			= "iq";
+	r. samplesPerCall	= blockSize;
+	r. calls		= blocks;
+	r. totalNs		= std::chrono::duration<double, std::nano>
+	                                             (stop - start). count ();
+	results. push_back (r);
+}
+//
+//	the time from the writer putting a block in the buffer to
+//	the waiting reader having it, with the blocking wait and with
+//	the polling (usleep (100)) the sampleReader used to do
+static
+void	wakeupRing	(int blockSize, int calls, bool polling) {
+RingBuffer<std::complex<float>> ring (16 * 32768);
+std::vector<std::complex<float>> in (blockSize), out (blockSize);
+std::atomic<int64_t> sent (0);
+benchResult r;
+	r. kernel		= polling ? "RingBuffer::wakeup/poll" :
+	                                    "RingBuffer::wakeup/wait";
+	r. unit			= "wakeup";
+	r. samplesPerCall	= 1;
+	r. calls		= calls;
+	r. totalNs		= 0;
+	std::thread reader ([&] () {
+	   for (int i = 0; i < calls; i ++) {
+	      if (polling) {
+	         while (ring. GetRingBufferReadAvailable () < blockSize)
+	            usleep (100);
+	      }
+	      else
+	      while (!ring. WaitForReadAvailable (blockSize, 1000));
+	      int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>
+	                (std::chrono::steady_clock::now (). time_since_epoch ()).
+	                                                          count ();
+	      r. totalNs	+= now - sent. load ();
+	      ring. getDataFromBuffer (out. data (), blockSize);
+	   }
+	});
+	for (int i = 0; i < calls; i ++) {
+//	give the reader time to go to sleep
+	   usleep (500);
+	   sent. store (std::chrono::duration_cast<std::chrono::nanoseconds>
+	                (std::chrono::steady_clock::now (). time_since_epoch ()).
+	                                                          count ());
+	   ring. putDataIntoBuffer (in. data (), blockSize);
+	}
+	reader. join ();
+	results. push_back (r);
+}
+
+static
+void	printResults	(uint8_t dabMode) {
+	fprintf (stdout, "{\n  \"mode\": %d,\n  \"viterbi\": \"%s\",\n",
+	                                     dabMode, SPIRAL_VARIANT);
+	fprintf (stdout, "  \"results\": [\n");
+	for (int i = 0; i < (int)results. size (); i ++) {
+	   benchResult &r	= results [i];
+	   double nsPerCall	= r. totalNs / r. calls;
+	   fprintf (stdout,
+	            "    {\"kernel\": \"%s\", \"unit\": \"%s\", \"calls\": %lld, \"ns_per_call\": %.1f, \"samples_per_call\": %d, \"samples_per_sec\": %.0f}%s\n",
+	            r. kernel. c_str (), r. unit. c_str (),
+	            (long long)r. calls, nsPerCall, r. samplesPerCall,
+	            r. samplesPerCall * 1.0e9 / nsPerCall,
+	            i < (int)results. size () - 1 ? "," : "");
+	}
+	fprintf (stdout, "  ]\n}\n");
+}
+
+int	main (int argc, char **argv) {
+uint8_t	dabMode		= 1;
+int	calls		= 1000;
+unsigned planFlags	= FFTW_ESTIMATE;
+std::string wisdomName	= "";
+int	opt;
+
+	while ((opt = getopt (argc, argv, "M:n:E:w:")) != -1) {
+	   switch (opt) {
+	      case 'M':
+	         dabMode	= atoi (optarg);
+	         if (!((dabMode == 1) || (dabMode == 2) || (dabMode == 4)))
+	            dabMode = 1;
+	         break;
+
+	      case 'n':
+	         calls		= atoi (optarg);
+	         if (calls < 1)
+	            calls = 1;
+	         break;
+
+	      case 'E':
+	         planFlags	= std::string (optarg) == "patient" ?
+	                                             FFTW_PATIENT :
+	                          std::string (optarg) == "measure" ?
+	                                             FFTW_MEASURE : FFTW_ESTIMATE;
+	         break;
+
+	      case 'w':
+	         wisdomName	= optarg;
+	         break;
+
+	      default:
+	         fprintf (stderr, "usage: bench [-M mode] [-n calls] "
+	                          "[-E estimate|measure|patient] [-w wisdom]\n");
+	         exit (1);
+	   }
+	}
+
+	fft_handler::setPlanning (planFlags, wisdomName);
+dabParams	params (dabMode);
+int	T_u		= params. get_T_u ();
+int	T_s		= params. get_T_s ();
+int	T_g		= T_s - T_u;
+int	T_null		= params. get_T_null ();
+int	carriers	= params. get_carriers ();
+callbacks	the_callBacks;
+	the_callBacks. signalHandler		= syncsignalHandler;
+	the_callBacks. ensembleHandler		= ensembleHandler;
+	the_callBacks. programnameHandler	= programnameHandler;
+	the_callBacks. tiiHandler		= nullptr;
+	the_callBacks. completeHandler		= nullptr;
+
+std::vector<std::complex<float>> input (T_null);
+std::vector<std::complex<float>> work  (T_null);
+	fillRandom (input. data (), T_null);
+
+//	the first handler plans (-E, -w), the others find the plans
+	auto planStart	= std::chrono::steady_clock::now ();
+	fft_handler	fft (dabMode);
+benchResult plan;
+	plan. kernel		= "fft_handler::plan";
+	plan. unit		= "iq";
+	plan. samplesPerCall	= T_u;
+	plan. calls		= 1;
+	plan. totalNs		= std::chrono::duration<double, std::nano>
+	                  (std::chrono::steady_clock::now () - planStart). count ();
+	results. push_back (plan);
+	measure ("fft_handler::create", "iq", T_u, calls,
+	         nothing,
+	         [&] () { fft_handler f (dabMode); });
+std::complex<float> *fftVector	= fft. getVector ();
+	measure ("fft_handler::do_FFT", "iq", T_u, calls,
+	         [&] () { std::copy (input. begin (), input. begin () + T_u,
+	                                                   fftVector); },
+	         [&] () { fft. do_FFT (); });
+	measure ("fft_handler::do_iFFT", "iq", T_u, calls,
+	         [&] () { std::copy (input. begin (), input. begin () + T_u,
+	                                                   fftVector); },
+	         [&] () { fft. do_iFFT (); });
+
+	phaseReference	phaseSynchronizer (dabMode, DIFF_LENGTH);
+	measure ("phaseReference::findIndex", "iq", T_u, calls,
+	         [&] () { work = input; },
+	         [&] () { phaseSynchronizer. findIndex (work. data (),
+	                                                      THRESHOLD); });
+	measure ("phaseReference::estimateOffset", "iq", T_u, calls,
+	         [&] () { work = input; },
+	         [&] () { phaseSynchronizer. estimateOffset (work. data ()); });
+
+	ofdmDecoder	decoder (dabMode);
+std::vector<int16_t> ibits (2 * carriers);
+	work	= input;
+	decoder. processBlock_0 (work. data ());
+	measure ("ofdmDecoder::decode", "iq", T_s, calls,
+	         [&] () { work = input; },
+	         [&] () { decoder. decode (work. data (), 1, ibits. data ()); });
+//	the FIC symbols of a frame, with one (batched) transform
+	measure ("ofdmDecoder::decodeBatch", "iq", FIC_SYMBOLS * T_s, calls,
+	         [&] () { for (int k = 0; k < FIC_SYMBOLS; k ++)
+	                     std::copy (input. begin () + T_g,
+	                                input. begin () + T_g + T_u,
+	                                decoder. batchInput (k)); },
+	         [&] () { decoder. transformBatch ();
+	                  for (int k = 0; k < FIC_SYMBOLS; k ++)
+	                     decoder. decodeBatch (k, ibits. data ()); });
+
+	viterbiSpiral	viterbi (768);
+std::vector<int16_t> softBits (3072 + 24);
+std::vector<uint8_t> bits (768);
+	for (int i = 0; i < (int)softBits. size (); i ++)
+	   softBits [i] = (int16_t)(nextRandom () * 127);
+	measure (std::string ("viterbiSpiral::deconvolve/") + SPIRAL_VARIANT,
+	         "softbits", 3072 + 24, calls,
+	         nothing,
+	         [&] () { viterbi. deconvolve (softBits. data (),
+	                                       bits. data ()); });
+	measure ("viterbiSpiral::deconvolve/generic",
+	         "softbits", 3072 + 24, calls,
+	         nothing,
+	         [&] () { viterbi. deconvolve (softBits. data (),
+	                                       bits. data (), false); });
+//
+//	process_ficInput is reached through process_ficBlock, one
+//	call with the three FIC blocks of a frame gives (2 * carriers * 3) /
+//	2304 calls of process_ficInput
+	ficHandler	fic (dabMode, &the_callBacks, nullptr);
+std::vector<std::vector<int16_t>> ficBlocks (3);
+	for (int b = 0; b < 3; b ++) {
+	   ficBlocks [b]. resize (2 * carriers);
+	   for (int i = 0; i < 2 * carriers; i ++)
+	      ficBlocks [b][i] = (int16_t)(nextRandom () * 127);
+	}
+int	ficInputs	= 3 * 2 * carriers / 2304;
+	measure ("ficHandler::process_ficInput", "softbits",
+	         2304, calls,
+	         nothing,
+	         [&] () { for (int b = 0; b < 3; b ++)
+	                     fic. process_ficBlock (ficBlocks [b], b + 1); });
+	results. back (). calls	*= ficInputs;
+
+	tiiDetector	tii (dabMode);
+	measure ("tiiDetector::addBuffer", "iq", T_u, calls,
+	         nothing,
+	         [&] () { tii. addBuffer (input); });
+int16_t	mainId, subId;
+	measure ("tiiDetector::processNULL", "iq", T_u, calls,
+	         nothing,
+	         [&] () { tii. processNULL (&mainId, &subId); });
+
+RingBuffer<std::complex<float>> ring (16 * 32768);
+	sampleReader	reader (nullptr, &ring);
+	measure ("sampleReader::getSamples", "iq", T_s, calls,
+	         [&] () { ring. putDataIntoBuffer (input. data (), T_s); },
+	         [&] () { reader. getSamples (work. data (), T_s, 1234); });
+
+	ring. FlushRingBuffer ();
+	measure ("RingBuffer::putDataIntoBuffer", "iq", 2048, calls,
+	         [&] () { ring. FlushRingBuffer (); },
+	         [&] () { ring. putDataIntoBuffer (input. data (), 2048); });
+	measure ("RingBuffer::getDataFromBuffer", "iq", 2048, calls,
+	         [&] () { ring. putDataIntoBuffer (input. data (), 2048); },
+	         [&] () { ring. getDataFromBuffer (work. data (), 2048); });
+	streamRing (T_s, 64 * calls, false);
+	streamRing (T_s, 64 * calls, true);
+	wakeupRing (2048, std::min (calls, 1000), false);
+	wakeupRing (2048, std::min (calls, 1000), true);
+
+//	the sample conversion of the device callbacks, for each of
+//	the variants this machine supports
+std::vector<uint8_t>	raw8	(2 * 32768);
+std::vector<int16_t>	raw16	(2 * 32768);
+std::vector<std::complex<float>> conv (32768);
+	for (int i = 0; i < 2 * 32768; i ++) {
+	   raw8 [i]	= seed >> 24;
+	   raw16 [i]	= (int16_t)(seed >> 16) >> 4;
+	   nextRandom ();
+	}
+	for (auto v: { "generic", "sse2", "avx2", "neon" }) {
+	   if (!convert_select (v))
+	      continue;
+	   std::string variant	= v;
+	   measure ("convert_uint8/" + variant, "iq", 32768, calls,
+	            nothing,
+	            [&] () { convert_uint8 (raw8. data (), conv. data (),
+	                                    32768, 1 / 128.0f); });
+	   measure ("convert_int16/" + variant, "iq", 32768, calls,
+	            nothing,
+	            [&] () { convert_int16 (raw16. data (), conv. data (),
+	                                    32768, 1 / 2048.0f); });
+	}
+	convert_select (nullptr);
+
+//	the resampling of the airspy (2500000) and the pluto (2112000),
+//	10 msec of input per call
+	for (auto v: { "generic", "sse2", "avx2", "neon" }) {
+	   if (!resampler_select_variant (v))
+	      continue;
+	   std::string variant	= v;
+	   for (int32_t rate: { 2500000, 2112000 }) {
+	      polyphaseFilter f (rate, INPUT_RATE,
+	                         DAB_PASSBAND, DAB_STOPBAND);
+	      int32_t n	= rate / 100;
+	      std::vector<std::complex<float>> in (n);
+	      std::vector<std::complex<float>> out (f. maxOutput (n));
+	      fillRandom (in. data (), n);
+	      measure ("polyphaseFilter/" + std::to_string (rate) +
+	                                              "/" + variant,
+	               "iq", n, calls / 10 + 1,
+	               nothing,
+	               [&] () { f. process (in. data (), n, out. data ()); });
+	   }
+	}
+	resampler_select_variant (nullptr);
+
+//	the way from the device to the OFDM decoder, for an rtlsdr
+//	(uint8, 2048000) and an airspy (int16, 2500000), 10 msec per call:
+//	conversion, resampling, buffer and correction in separate passes,
+//	and with the (fused) front end
+	for (int32_t rate: { INPUT_RATE, 2500000 }) {
+	   int32_t n	= rate / 100;
+	   std::string name	= "frontEnd/" + std::to_string (rate);
+	   RingBuffer<std::complex<float>> sRing (16 * 32768);
+	   sampleReader	sReader (nullptr, &sRing);
+	   resampler	sResampler (rate, INPUT_RATE);
+	   std::vector<std::complex<float>> sIn (n);
+	   std::vector<std::complex<float>> sOut (sResampler. maxOutput (n));
+	   measure (name + "/separate", "iq", n, calls / 10 + 1,
+	            nothing,
+	            [&] () {
+	               int32_t m	= n;
+	               if (rate == INPUT_RATE) {
+	                  void	*data1, *data2;
+	                  int32_t	size1, size2;
+	                  sRing. GetRingBufferWriteRegions (n, &data1, &size1,
+	                                                    &data2, &size2);
+	                  convert_uint8 (raw8. data (),
+	                           static_cast<std::complex<float> *>(data1),
+	                           size1, 1 / 128.0f);
+	                  convert_uint8 (raw8. data () + 2 * size1,
+	                           static_cast<std::complex<float> *>(data2),
+	                           size2, 1 / 128.0f);
+	                  sRing. AdvanceRingBufferWriteIndex (n);
+	               }
+	               else {
+	                  convert_int16 (raw16. data (), sIn. data (),
+	                                                n, 1 / 2048.0f);
+	                  m = sResampler. process (sIn. data (), n,
+	                                                sOut. data ());
+	                  sRing. putDataIntoBuffer (sOut. data (), m);
+	               }
+	               sReader. getSamples (sOut. data (), m, 1234); });
+
+	   RingBuffer<std::complex<float>> fRing (16 * 32768);
+	   frontEnd	fFront (&fRing, rate);
+	   sampleReader	fReader (nullptr, &fRing, &fFront);
+	   std::vector<std::complex<float>> fOut (fFront. maxOutput (n));
+	   measure (name + "/fused", "iq", n, calls / 10 + 1,
+	            nothing,
+	            [&] () {
+	               if (rate == INPUT_RATE)
+	                  fFront. putUint8 (raw8. data (), n, 1 / 128.0f);
+	               else
+	                  fFront. putInt16 (raw16. data (), n, 1 / 2048.0f);
+	               fReader. getSamples (fOut. data (),
+	                          fRing. GetRingBufferReadAvailable (), 1234); });
+
+	   RingBuffer<std::complex<float>> cRing (STANDIN_BUFFER);
+	   compactBuffer	cBuffer (DEVICE_BUFFER, rate == INPUT_RATE ?
+	                                   compactBuffer::COMPACT_INT8 :
+	                                   compactBuffer::COMPACT_INT16,
+	                                 rate == INPUT_RATE ?
+	                                   1 / 128.0f : 1 / 8192.0f);
+	   sampleReader	cReader (nullptr, &cRing, nullptr, &cBuffer);
+	   measure (name + "/compact", "iq", n, calls / 10 + 1,
+	            nothing,
+	            [&] () {
+	               int32_t m	= n;
+	               if (rate == INPUT_RATE)
+	                  cBuffer. putUint8 (raw8. data (), n);
+	               else {
+	                  convert_int16 (raw16. data (), sIn. data (),
+	                                                n, 1 / 2048.0f);
+	                  m = sResampler. process (sIn. data (), n,
+	                                                sOut. data ());
+	                  cBuffer. putFloat (sOut. data (), m);
+	               }
+	               cReader. getSamples (sOut. data (), m, 1234); });
+	}
+
+	printResults (dabMode);
+	return 0;
+}
@@ -0,0 +1,284 @@
+#
+/*
+ *    Copyright (C) 2020
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of channelScanner
+ *
+ *    channelScanner is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    channelScanner is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with channelScanner; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *	sync-bench runs the receiver on a synthetic signal (or a recorded
+ *	uff file) with a range of impairments, and reports for each
+ *	impairment how acquisition went: the number of timeSyncer attempts
+ *	and findIndex failures, and the amount of signal (in ms) needed
+ *	to get time sync, FIC sync and the ensemble name.
+ *	Results are written as JSON on stdout.
+ */
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	<unistd.h>
+#include	<string>
+#include	<vector>
+#include	<atomic>
+#include	"dab-constants.h"
+#include	"dab-api.h"
+#include	"ringbuffer.h"
+#include	"dab-processor.h"
+#include	"dab-transmitter.h"
+#include	"channel-simulator.h"
+#include	"uff-handler.h"
+
+class	scenario {
+public:
+	std::string	name;
+	impairments	imp;
+};
+
+class	runContext {
+public:
+	dabProcessor	*theRadio;
+	std::atomic<int64_t>	ensembleSample;
+};
+
+static
+void	syncsignalHandler	(bool b, void *ctx) {
+	(void)b; (void)ctx;
+}
+
+static
+void	ensembleHandler		(std::string s, int32_t id, void *ctx) {
+runContext *c	= static_cast<runContext *>(ctx);
+	(void)s; (void)id;
+	if (c -> ensembleSample. load () < 0)
+	   c -> ensembleSample. store (c -> theRadio -> get_sampleCount ());
+}
+
+static
+void	programnameHandler	(std::string s, int32_t id, void *ctx) {
+	(void)s; (void)id; (void)ctx;
+}
+
+static
+scenario	makeScenario	(const std::string &name,
+	                         float snr, float freqOffset,
+	                         float ppm, int bits, bool echoes) {
+scenario s;
+	s. name			= name;
+	s. imp. snr		= snr;
+	s. imp. freqOffset	= freqOffset;
+	s. imp. ppm		= ppm;
+	s. imp. bits		= bits;
+	if (echoes) {		// a nearby reflection and a second transmitter
+	   s. imp. echoes. push_back (echoPath (40,  0.5, 1.0));
+	   s. imp. echoes. push_back (echoPath (300, 0.7, 2.5));
+	}
+	return s;
+}
+
+static
+std::vector<scenario>	defaultMatrix	() {
+std::vector<scenario> m;
+	m. push_back (makeScenario ("clean",	200,      0,   0, 0, false));
+	m. push_back (makeScenario ("awgn-20dB",	 20,      0,   0, 0, false));
+	m. push_back (makeScenario ("awgn-10dB",	 10,      0,   0, 0, false));
+	m. push_back (makeScenario ("awgn-6dB",	  6,      0,   0, 0, false));
+	m. push_back (makeScenario ("awgn-3dB",	  3,      0,   0, 0, false));
+	m. push_back (makeScenario ("awgn-0dB",	  0,      0,   0, 0, false));
+	m. push_back (makeScenario ("cfo+5kHz",	200,   5000,   0, 0, false));
+	m. push_back (makeScenario ("cfo-20kHz",	200, -20000,   0, 0, false));
+	m. push_back (makeScenario ("cfo+34kHz",	200,  34000,   0, 0, false));
+	m. push_back (makeScenario ("cfo-34kHz",	200, -34000,   0, 0, false));
+	m. push_back (makeScenario ("clock+20ppm", 200,     0,  20, 0, false));
+	m. push_back (makeScenario ("clock-100ppm", 200,    0, -100, 0, false));
+	m. push_back (makeScenario ("multipath",	200,      0,   0, 0, true));
+	m. push_back (makeScenario ("8bit",	200,      0,   0, 8, false));
+	m. push_back (makeScenario ("combined",	  6,  12000,  30, 8, true));
+	return m;
+}
+//
+//	the signal source, either the transmitter or a uff file
+class	signalSource {
+public:
+	signalSource	(uint8_t dabMode, const std::string &fileName):
+	                   fileBuffer (16 * 32768) {
+	   theTransmitter	= nullptr;
+	   theFile		= nullptr;
+	   if (fileName == "")
+	      theTransmitter	= new dabTransmitter (dabMode,
+	                                              defaultEnsemble ());
+	   else {
+	      theFile		= new uffFileHandler (&fileBuffer,
+	                                              fileName, false);
+	      theFile		-> restartReader (0);
+	   }
+	   frameSize		= dabParams (dabMode). get_T_F ();
+	}
+	~signalSource	() {
+	   if (theFile != nullptr) {
+	      theFile	-> stopReader ();
+	      delete theFile;
+	   }
+	   delete theTransmitter;
+	}
+//	returns false when there is no more data
+	bool	nextFrame	(std::vector<std::complex<float>> &v) {
+	   v. resize (frameSize);
+	   if (theTransmitter != nullptr) {
+	      theTransmitter -> nextFrame (v. data ());
+	      return true;
+	   }
+	   int filled	= 0;
+	   while (filled < frameSize) {
+	      int n = fileBuffer. getDataFromBuffer (&v [filled],
+	                                             frameSize - filled);
+	      filled += n;
+	      if (n == 0) {
+	         if (theFile -> endReached () &&
+	             (fileBuffer. GetRingBufferReadAvailable () == 0))
+	            break;
+	         usleep (100);
+	      }
+	   }
+	   v. resize (filled);
+	   return filled > 0;
+	}
+private:
+	dabTransmitter	*theTransmitter;
+	uffFileHandler	*theFile;
+	RingBuffer<std::complex<float>> fileBuffer;
+	int32_t		frameSize;
+};
+
+static
+double	toMs	(int64_t samples) {
+	return samples < 0 ? -1 : samples * 1000.0 / INPUT_RATE;
+}
+
+static
+void	runScenario	(const scenario &s, uint8_t dabMode,
+	                 const std::string &fileName, int maxFrames,
+	                 bool last) {
+RingBuffer<std::complex<float>> _I_Buffer (16 * 32768, true);
+callbacks	the_callBacks;
+runContext	ctx;
+syncStatistics	stats;
+std::vector<std::complex<float>> frame;
+std::vector<std::complex<float>> impaired;
+int		frames	= 0;
+
+	the_callBacks. signalHandler		= syncsignalHandler;
+	the_callBacks. ensembleHandler		= ensembleHandler;
+	the_callBacks. programnameHandler	= programnameHandler;
+	the_callBacks. tiiHandler		= nullptr;
+	the_callBacks. completeHandler		= nullptr;
+	ctx. ensembleSample. store (-1);
+
+	signalSource	source (dabMode, fileName);
+	channelSimulator theChannel (s. imp);
+	dabProcessor	theRadio (&_I_Buffer, dabMode, &the_callBacks, &ctx);
+	ctx. theRadio	= &theRadio;
+	theRadio. start ();
+
+	while ((frames < maxFrames) && (ctx. ensembleSample. load () < 0)) {
+	   if (!source. nextFrame (frame))
+	      break;
+	   frames ++;
+	   impaired. resize (0);
+	   theChannel. process (frame. data (), frame. size (), impaired);
+	   int written	= 0;
+	   while (written < (int)impaired. size ()) {
+	      int n = std::min ((int)impaired. size () - written,
+	                        _I_Buffer. GetRingBufferWriteAvailable ());
+	      if (n <= 0) {
+	         if (ctx. ensembleSample. load () >= 0)
+	            break;
+	         usleep (100);
+	         continue;
+	      }
+	      _I_Buffer. putDataIntoBuffer (&impaired [written], n);
+	      written += n;
+	   }
+	}
+//	let the processor consume what is still in the buffer
+	for (int i = 0; (i < 1000) && (ctx. ensembleSample. load () < 0) &&
+	         (_I_Buffer. GetRingBufferReadAvailable () > 8192); i ++)
+	   usleep (1000);
+
+	theRadio. get_syncStatistics (&stats);
+	theRadio. stop ();
+
+	fprintf (stdout,
+	         "    {\"scenario\": \"%s\", \"snr_db\": %.1f, \"cfo_hz\": %.0f, \"ppm\": %.1f, \"echoes\": %d, \"bits\": %d, \"frames_sent\": %d, \"sync_attempts\": %d, \"no_dip\": %d, \"no_end_of_dip\": %d, \"findIndex_failures\": %d, \"time_to_sync_ms\": %.1f, \"time_to_fic_ms\": %.1f, \"time_to_ensemble_ms\": %.1f}%s\n",
+	         s. name. c_str (), s. imp. snr, s. imp. freqOffset, s. imp. ppm,
+	         (int)s. imp. echoes. size (), s. imp. bits, frames,
+	         stats. syncAttempts, stats. noDipFound,
+	         stats. noEndofDipFound, stats. indexFailures,
+	         toMs (stats. firstSyncSample),
+	         toMs (stats. ficSyncSample),
+	         toMs (ctx. ensembleSample. load ()),
+	         last ? "" : ",");
+	fflush (stdout);
+}
+
+int	main (int argc, char **argv) {
+uint8_t		dabMode		= 1;
+int		maxFrames	= 50;
+std::string	fileName	= "";
+std::vector<scenario> matrix	= defaultMatrix ();
+int		opt;
+
+	while ((opt = getopt (argc, argv, "M:n:i:")) != -1) {
+	   switch (opt) {
+	      case 'M':
+	         dabMode	= atoi (optarg);
+	         if (!((dabMode == 1) || (dabMode == 2) || (dabMode == 4)))
+	            dabMode = 1;
+	         break;
+
+	      case 'n':
+	         maxFrames	= atoi (optarg);
+	         if (maxFrames < 1)
+	            maxFrames = 1;
+	         break;
+
+	      case 'i':
+	         fileName	= std::string (optarg);
+	         break;
+
+	      default:
+	         fprintf (stderr,
+	                  "usage: sync-bench [-M mode] [-n frames] [-i uff file]\n");
+	         exit (1);
+	   }
+	}
+
+	fprintf (stdout, "{\n  \"mode\": %d,\n  \"source\": \"%s\",\n",
+	                 dabMode, fileName == "" ? "synthetic" :
+	                                           fileName. c_str ());
+	fprintf (stdout, "  \"max_frames\": %d,\n  \"results\": [\n", maxFrames);
+	try {
+	   for (int i = 0; i < (int)matrix. size (); i ++)
+	      runScenario (matrix [i], dabMode, fileName, maxFrames,
+	                   i == (int)matrix. size () - 1);
+	}
+	catch (int e) {
+	   fprintf (stderr, "cannot open %s (%d)\n", fileName. c_str (), e);
+	   exit (2);
+	}
+	fprintf (stdout, "  ]\n}\n");
+	return 0;
+}
+
@@ -0,0 +1,57 @@
+#
+/*
+ *    Copyright (C) 2020
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of channelScanner
+ *
+ *    channelScanner is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    channelScanner is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with channelScanner; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include	"channel-events.h"
+#include	<chrono>
+
+	channelEvents::channelEvents	() {
+	reset ();
+}
+
+	channelEvents::~channelEvents	() {
+}
+
+void	channelEvents::reset		() {
+std::unique_lock<std::mutex> lck (locker);
+	for (int i = 0; i < NR_EVENTS; i ++)
+	   counts [i] = 0;
+}
+
+void	channelEvents::signal		(int event) {
+	{  std::unique_lock<std::mutex> lck (locker);
+	   counts [event] ++;
+	}
+	changed. notify_all ();
+}
+
+int32_t	channelEvents::count		(int event) {
+std::unique_lock<std::mutex> lck (locker);
+	return counts [event];
+}
+
+bool	channelEvents::waitFor		(int event, int32_t seen, int32_t ms) {
+std::unique_lock<std::mutex> lck (locker);
+	return changed. wait_for (lck, std::chrono::milliseconds (ms),
+	                          [&] { return counts [event] != seen; });
+}
+
@@ -0,0 +1,59 @@
+#
+/*
+ *    Copyright (C) 2020
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of channelScanner
+ *
+ *    channelScanner is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    channelScanner is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with channelScanner; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *	The callbacks from the processor (running in its own thread)
+ *	signal events, the scanner waits for them. Each event has a
+ *	counter, a waiter passes the count it has seen and is woken up
+ *	as soon as the count differs.
+ */
+#ifndef	__CHANNEL_EVENTS__
+#define	__CHANNEL_EVENTS__
+
+#include	<stdint.h>
+#include	<mutex>
+#include	<condition_variable>
+
+#define	EVENT_TIMESYNC		0
+#define	EVENT_ENSEMBLE		1
+#define	EVENT_SERVICE		2
+#define	EVENT_TII		3
+#define	EVENT_COMPLETE		4
+#define	NR_EVENTS		5
+
+class	channelEvents {
+public:
+			channelEvents	();
+			~channelEvents	();
+	void		reset		();
+	void		signal		(int event);
+	int32_t		count		(int event);
+//	returns true if the count of the event differs from "seen"
+//	within "ms" milliseconds
+	bool		waitFor		(int event, int32_t seen, int32_t ms);
+private:
+	std::mutex	locker;
+	std::condition_variable	changed;
+	int32_t		counts	[NR_EVENTS];
+};
+
+#endif
+
@@ -64,6 +64,23 @@ typedef	struct {
 	int16_t	programType;
 	bool	is_madePublic;
 } audiodata;
+//
+//	The state of the ensemble database, as built from the FIGs.
+//	An announced service (FIG 0/2) is complete when it has a label
+//	and its primary component is bound to a subchannel. The counts
+//	are compared at each repetition of the ensemble label (FIG 1/0),
+//	stableCycles tells for how many repetitions they did not change.
+typedef	struct {
+	int16_t	announced;
+	int16_t	labelled;
+	int16_t	complete;
+	int16_t	subChannels;
+	int16_t	stableCycles;
+	int16_t	confidence;	// 0 .. 100
+	bool	databaseComplete;
+	uint32_t fig0Seen;	// bit i: FIG 0/i was seen
+	uint8_t	fig1Seen;	// bit i: FIG 1/i was seen
+} ensembleStatus;
 
 //////////////////////// C A L L B A C K F U N C T I O N S ///////////////
 //
@@ -91,6 +108,10 @@ typedef	struct {
 //	Each programname in the ensemble is sent once
 	typedef	void (*programname_t)(std::string, int32_t, void *);
 //
+//	at each repetition of the ensemble label, as long as each
+//	announced service is complete, the confidence (50 .. 100) is sent
+	typedef	void (*ensembleComplete_t)(int16_t, void *);
+//
 //	after selecting an audio program, the audiooutput, packed
 //	as PCM data (always two channels) is sent back
 	typedef void (*audioOut_t)(int16_t *,		// buffer
@@ -213,6 +234,8 @@ typedef struct {
         syncsignal_t    signalHandler;
         ensemblename_t  ensembleHandler;
         programname_t   programnameHandler;
+	tii_t		tiiHandler;
+	ensembleComplete_t completeHandler;
 } callbacks;
 
 }
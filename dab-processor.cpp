@@ -34,9 +34,12 @@
 	dabProcessor::dabProcessor	(RingBuffer<std::complex<float>> *buffer,
 	                                 uint8_t	dabMode,
 	                                 callbacks	*the_callBacks,
-	                                 void		*userData):
+	                                 void		*userData,
+	                                 frontEnd	*theFrontEnd,
+	                                 compactBuffer	*theCompact):
 	                                    params (dabMode),
-	                                    myReader (this, buffer),
+	                                    myReader (this, buffer,
+	                                              theFrontEnd, theCompact),
 	                                    phaseSynchronizer (dabMode,
 	                                                       DIFF_LENGTH),
 	                                    my_ofdmDecoder (dabMode),
@@ -58,6 +61,8 @@
 	snr				= 0;
 	mainId				= -1;
 	subId				= -1;
+	frameCount. store (0);
+	clearStatistics ();
 	running. store (false);
 }
 
@@ -79,6 +84,7 @@ float		fineOffset		= 0;
 float		coarseOffset		= 0;
 bool		correctionNeeded	= true;
 std::vector<complex<float>>	ofdmBuffer (T_null);
+std::complex<float>	*fftInput	= my_ofdmDecoder. fftInput ();
 int		dip_attempts		= 0;
 int		index_attempts		= 0;
 int		startIndex		= -1;
@@ -87,6 +93,9 @@ int		tii_delay		= 4;
 
 	isSynced	= false;
 	snr		= 0;
+	frameCount. store (0);
+	clearStatistics ();
+	stageTimes. reset ();
 	running. store (true);
 	my_ficHandler. reset ();
 	myReader. setRunning (true);
@@ -99,11 +108,16 @@ int		tii_delay		= 4;
 
 notSynced:
 //Initing:
-           switch (myTimeSyncer. sync (T_null, T_F)) {
+	   syncAttempts. fetch_add (1);
+	   stageTimes. start (STAGE_TIMESYNC, myReader. get_waitTime ());
+	   int syncResult = myTimeSyncer. sync (T_null, T_F);
+	   stageTimes. stop (STAGE_TIMESYNC, myReader. get_waitTime ());
+           switch (syncResult) {
               case TIMESYNC_ESTABLISHED:
                  break;                 // yes, we are ready
 
               case NO_DIP_FOUND:
+	         noDipFound. fetch_add (1);
                  if  (++ dip_attempts >= 10) {
                     the_callBacks -> signalHandler (false, userData);
                     dip_attempts = 0;
@@ -112,16 +126,20 @@ notSynced:
 
               default:                  // does not happen
               case NO_END_OF_DIP_FOUND:
+	         noEndofDipFound. fetch_add (1);
                  goto notSynced;
            }
 
 	   myReader. getSamples (ofdmBuffer. data (),
 	                         T_u, coarseOffset + fineOffset);
 
+	   stageTimes. start (STAGE_FINDINDEX);
 	   startIndex = phaseSynchronizer.
 	                        findIndex (ofdmBuffer. data (), THRESHOLD);
+	   stageTimes. stop (STAGE_FINDINDEX);
 	   if (startIndex < 0) { // no sync, try again
 	      isSynced	= false;
+	      indexFailures. fetch_add (1);
 	      if (++index_attempts > 10) {
 	         the_callBacks -> signalHandler (false, userData);
 	         index_attempts	= 0;
@@ -140,10 +158,13 @@ Check_endofNull:
 
 	   myReader. getSamples (ofdmBuffer. data (),
 	                         T_u, coarseOffset + fineOffset);
+	   stageTimes. start (STAGE_FINDINDEX);
 	   startIndex = phaseSynchronizer.
 	                       findIndex (ofdmBuffer. data (), 4 * THRESHOLD);
+	   stageTimes. stop (STAGE_FINDINDEX);
 	   if (startIndex < 0) { // no sync, try again
 	      isSynced	= false;
+	      indexFailures. fetch_add (1);
 	      goto notSynced;
 	   }
 
@@ -151,28 +172,35 @@ SyncOnPhase:
 	   index_attempts	= 0;
 	   dip_attempts		= 0;
 	   isSynced		= true;
+	   if (firstSyncSample. load () < 0)
+	      firstSyncSample. store (myReader. get_totalSamples ());
 	   the_callBacks -> signalHandler (isSynced, userData);
 
 //	Once here, we are synchronized, we need to copy the data we
-//	used for synchronization for block 0
-
-	   memmove (ofdmBuffer. data (),
-	            &((ofdmBuffer. data ()) [startIndex]),
+//	used for synchronization for block 0, it goes straight into
+//	the input of the FFT
+	   memcpy (fftInput,
+	           &((ofdmBuffer. data ()) [startIndex]),
 	                  (T_u - startIndex) * sizeof (std::complex<float>));
 	   int ofdmBufferIndex	= T_u - startIndex;
 
 //	Block 0 is special in that it is used for coarse time synchronization
 //	and its content is used as a reference for decoding the
 //	first datablock.
-//	We read the missing samples in the ofdm buffer
-	   myReader. getSamples (&((ofdmBuffer. data ()) [ofdmBufferIndex]),
+//	We read the missing samples in the FFT input
+	   myReader. getSamples (&fftInput [ofdmBufferIndex],
 	                  T_u - ofdmBufferIndex,
 	                  coarseOffset + fineOffset);
-	   my_ofdmDecoder. processBlock_0	(ofdmBuffer. data ());
+	   stageTimes. start (STAGE_BLOCK_0);
 //
 //	if correction is needed (known by the fic handler)
-//	we compute the coarse offset in the phaseSynchronizer
+//	we compute the coarse offset in the phaseSynchronizer,
+//	from the time domain samples, the FFT is in place
 	   correctionNeeded = !my_ficHandler. syncReached ();
+	   if (correctionNeeded)
+	      memcpy (ofdmBuffer. data (), fftInput,
+	                       T_u * sizeof (std::complex<float>));
+	   my_ofdmDecoder. processBlock_0	();
 	   if (correctionNeeded) {
 	      int correction  = phaseSynchronizer.
 	                                  estimateOffset (ofdmBuffer. data ());
@@ -182,6 +210,7 @@ SyncOnPhase:
 	            coarseOffset = 0;
 	      }
 	   }
+	   stageTimes. stop (STAGE_BLOCK_0);
 //
 //	after block 0, we will just read in the other (params -> L - 1) blocks
 //	The first ones are the FIC blocks. We immediately
@@ -193,18 +222,37 @@ SyncOnPhase:
 	   std::vector<int16_t> ibits (2 * params. get_carriers ());
 	   for (int ofdmSymbolCount = 1;
 	        ofdmSymbolCount < (uint16_t)nrBlocks; ofdmSymbolCount ++) {	
+	      stageTimes. start (STAGE_SYMBOLS, myReader. get_waitTime ());
+//	the cyclic prefix goes into the ofdmBuffer, the T_u samples
+//	of the symbol itself into the FFT input, for the FIC symbols
+//	that is their place in the batch
+	      std::complex<float> *symbol =
+	                       ofdmSymbolCount <= FIC_SYMBOLS ?
+	                       my_ofdmDecoder. batchInput (ofdmSymbolCount - 1) :
+	                       fftInput;
 	      myReader. getSamples (ofdmBuffer. data (),
-	                               T_s, coarseOffset + fineOffset);
-	      for (i = (int)T_u; i < (int)T_s; i ++) 
-	         FreqCorr += ofdmBuffer [i] * conj (ofdmBuffer [i - T_u]);
+	                               T_g, coarseOffset + fineOffset);
+	      myReader. getSamples (symbol,
+	                               T_u, coarseOffset + fineOffset);
+	      for (i = 0; i < (int)T_g; i ++) 
+	         FreqCorr += symbol [T_u - T_g + i] * conj (ofdmBuffer [i]);
+	      stageTimes. stop (STAGE_SYMBOLS, myReader. get_waitTime ());
 //
 //	Note that only the first few blocks are handled locally
 //	The FIC/FIB handling is in this thread, so that there is
-//	no delay is "knowing" that we are synchronized
-	      if (ofdmSymbolCount < 4) {
-	         my_ofdmDecoder. decode (ofdmBuffer. data (),
-	                                 ofdmSymbolCount, ibits. data ());
-	         my_ficHandler. process_ficBlock (ibits, ofdmSymbolCount);
+//	no delay is "knowing" that we are synchronized.
+//	The FIC symbols are transformed together, when the last one is in
+	      if (ofdmSymbolCount == FIC_SYMBOLS) {
+	         stageTimes. start (STAGE_FIC);
+	         my_ofdmDecoder. transformBatch ();
+	         for (int k = 0; k < FIC_SYMBOLS; k ++) {
+	            my_ofdmDecoder. decodeBatch (k, ibits. data ());
+	            my_ficHandler. process_ficBlock (ibits, k + 1);
+	         }
+	         stageTimes. stop (STAGE_FIC);
+	         if ((ficSyncSample. load () < 0) &&
+	                                 my_ficHandler. syncReached ())
+	            ficSyncSample. store (myReader. get_totalSamples ());
 	      }
 	   }
 
@@ -224,12 +272,16 @@ SyncOnPhase:
 	   snr	= 0.9 * snr + 0.1 * 20 * log10 ((sum2 + 0.005) / sum);
 
 	   if (wasSecond (my_ficHandler. get_CIFcount(), &params)) {
+	      stageTimes. start (STAGE_TII);
 	      my_tiiDetector. addBuffer (ofdmBuffer);
 	      if (++tii_counter >= tii_delay) {
 	         my_tiiDetector. processNULL (&mainId, &subId);
+	         if ((mainId >= 0) && (the_callBacks -> tiiHandler != nullptr))
+	            the_callBacks -> tiiHandler (mainId, subId, 0, userData);
 	         tii_counter = 0;
 	         my_tiiDetector. reset ();
 	      }
+	      stageTimes. stop (STAGE_TII);
 	   }
 
 	   if (fineOffset > carrierDiff / 2) {
@@ -241,6 +293,16 @@ SyncOnPhase:
 	      coarseOffset -= carrierDiff;
 	      fineOffset += carrierDiff;
 	   }
+	   if (my_ficHandler. has_CIFcount ()) {
+	      int32_t cif	= my_ficHandler. get_CIFcount ();
+	      if (firstCIF. load () < 0)
+	         firstCIF. store (cif);
+	      lastCIF. store (cif);
+	      cifFrames. fetch_add (1);
+	   }
+	   frameCount. fetch_add (1);
+	   stageTimes. add (STAGE_WAIT, myReader. get_waitTime ());
+	   stageTimes. endFrame ();
 	   goto Check_endofNull;
 	}
 	
@@ -260,7 +322,6 @@ void	dabProcessor::stop	(void) {
 	if (running. load ()) {
 	   running. store (false);
 	   myReader. setRunning (false);
-	   sleep (1);
 	   threadHandle. join ();
 	}
 }
@@ -283,6 +344,10 @@ int32_t	dabProcessor::get_SId		(std::string s) {
 	return my_ficHandler. SIdFor (s);
 }
 
+void	dabProcessor::get_ensembleStatus	(ensembleStatus *s) {
+	my_ficHandler. get_ensembleStatus (s);
+}
+
 uint16_t	dabProcessor::get_tiiData	() {
 	if ((subId == -1) || (mainId == -1))
 	   return 0;
@@ -293,6 +358,49 @@ uint16_t	dabProcessor::get_snr	() {
 	return snr;
 }
 
+int32_t	dabProcessor::get_frameCount	() {
+	return frameCount. load ();
+}
+
+int64_t	dabProcessor::get_sampleCount	() {
+	return myReader. get_totalSamples ();
+}
+
+void	dabProcessor::get_syncStatistics	(syncStatistics *s) {
+	s -> syncAttempts	= syncAttempts. load ();
+	s -> noDipFound		= noDipFound. load ();
+	s -> noEndofDipFound	= noEndofDipFound. load ();
+	s -> indexFailures	= indexFailures. load ();
+	s -> firstSyncSample	= firstSyncSample. load ();
+	s -> ficSyncSample	= ficSyncSample. load ();
+}
+
+void	dabProcessor::get_cifRange	(cifRange *r) {
+	r -> first	= firstCIF. load ();
+	r -> last	= lastCIF. load ();
+	r -> frames	= cifFrames. load ();
+}
+
+void	dabProcessor::get_stageStatistics	(stageStatistics *s) {
+	stageTimes. get (s);
+}
+
+int32_t	dabProcessor::get_frameDuration	() {
+	return (int64_t)T_F * 1000000 / INPUT_RATE;
+}
+
+void	dabProcessor::clearStatistics	() {
+	syncAttempts.		store (0);
+	noDipFound.		store (0);
+	noEndofDipFound.	store (0);
+	indexFailures.		store (0);
+	firstSyncSample.	store (-1);
+	ficSyncSample.		store (-1);
+	firstCIF.		store (-1);
+	lastCIF.		store (-1);
+	cifFrames.		store (0);
+}
+
 void    dabProcessor::clearEnsemble     (void) {
 	my_ficHandler. reset ();
 }
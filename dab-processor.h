@@ -39,15 +39,39 @@
 #include	"dab-api.h"
 #include	"sample-reader.h"
 #include	"tii_detector.h"
+#include	"stage-timer.h"
 //
 class	deviceHandler;
+//
+//	counters for the acquisition of time sync, the sample counts
+//	are -1 as long as the event did not occur
+class	syncStatistics {
+public:
+	int32_t		syncAttempts;		// calls of timeSyncer::sync
+	int32_t		noDipFound;
+	int32_t		noEndofDipFound;
+	int32_t		indexFailures;		// findIndex found nothing
+	int64_t		firstSyncSample;	// first frame in sync
+	int64_t		ficSyncSample;		// first FIB with a correct crc
+};
+//
+//	the CIF counts (from FIG 0/0) of the first and the last frame
+//	decoded, -1 if no frame with a CIF count was decoded
+class	cifRange {
+public:
+	int32_t		first;
+	int32_t		last;
+	int32_t		frames;			// frames with a CIF count
+};
 
 class dabProcessor {
 public:
 		dabProcessor  	(RingBuffer<std::complex<float>> *,
 	                         uint8_t,		// Mode
 	                         callbacks	*,
-	                         void		*);
+	                         void		*,
+	                         frontEnd	*theFrontEnd = nullptr,
+	                         compactBuffer	*theCompact = nullptr);
 	virtual ~dabProcessor	(void);
 	void		reset			(void);
 	void		stop			(void);
@@ -55,6 +79,12 @@ public:
 	void		clearEnsemble           (void);
 	uint16_t	get_tiiData		();
 	uint16_t	get_snr			();
+	int32_t		get_frameCount		();
+	int64_t		get_sampleCount		();
+	void		get_syncStatistics	(syncStatistics *);
+	void		get_cifRange		(cifRange *);
+	void		get_stageStatistics	(stageStatistics *);
+	int32_t		get_frameDuration	();	// in microseconds
 	void		startDumping		(SNDFILE *, int);
 	void		stopDumping		();
 	void		dataforAudioService	(std::string,   audiodata *);
@@ -64,6 +94,7 @@ public:
         void            dataforDataService      (std::string,
                                                      packetdata *, int16_t);
 	int32_t		get_SId			(std::string);
+	void		get_ensembleStatus	(ensembleStatus *);
 private:
 //
 	RingBuffer<std::complex<float>>	*_I_Buffer;
@@ -78,6 +109,18 @@ private:
 	std::thread	threadHandle;
 	void		*userData;
 	std::atomic<bool>	running;
+	std::atomic<int32_t>	frameCount;
+	std::atomic<int32_t>	syncAttempts;
+	std::atomic<int32_t>	noDipFound;
+	std::atomic<int32_t>	noEndofDipFound;
+	std::atomic<int32_t>	indexFailures;
+	std::atomic<int64_t>	firstSyncSample;
+	std::atomic<int64_t>	ficSyncSample;
+	std::atomic<int32_t>	firstCIF;
+	std::atomic<int32_t>	lastCIF;
+	std::atomic<int32_t>	cifFrames;
+	void		clearStatistics	();
+	stageTimer	stageTimes;
 	bool		isSynced;
 	int		snr;
 	int32_t		T_null;
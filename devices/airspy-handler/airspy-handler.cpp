@@ -23,23 +23,29 @@
 
 #include	"airspy-handler.h"
 #include	"xml-filewriter.h"
+#include	"sample-convert.h"
+#include	"resampler.h"
+#include	"front-end.h"
+#include	"compact-buffer.h"
+#include	"channelizer.h"
+#include	<vector>
 #include	<unistd.h>
 static
 const	int	EXTIO_NS	=  8192;
 static
 const	int	EXTIO_BASE_TYPE_SIZE = sizeof (float);
-
+//	the callback hands over blocks of this many int16 IQ samples
 static
-std::complex<float> cmul (std::complex<float> x, float y) {
-	return std::complex<float> (real (x) * y, imag (x) * y);
-}
+const	int	BLOCK_SAMPLES	= EXTIO_NS * EXTIO_BASE_TYPE_SIZE * 2 /
+	                                           (2 * sizeof (int16_t));
 
 	airspyHandler::airspyHandler (RingBuffer<std::complex<float>> *b,
 	                              const std::string &recorderVersion,
 	                              int32_t	frequency,
 	                              int16_t	ppmCorrection,
 	                              int16_t	theGain,
-	                              bool	biasTee):
+	                              bool	biasTee,
+	                              int	sampleMode):
 	                                 deviceHandler (b) {
 int	result, i;
 int	distance	= 10000000;
@@ -115,12 +121,19 @@ uint32_t samplerate_count;
 	my_airspy_get_samplerates (device, myBuffer, samplerate_count);
 
 	selectedRate	= 0;
+	wideRate	= 0;
 	for (i = 0; i < (int)samplerate_count; i ++) {
 	   if (abs ((int)myBuffer [i] - 2048000) < distance) {
 	      distance	= abs ((int)myBuffer [i] - 2048000);
 	      selectedRate = myBuffer [i];
 	   }
+	   if ((int32_t)myBuffer [i] > wideRate)
+	      wideRate	= myBuffer [i];
 	}
+	if (wideRate <= 2048000)
+	   wideRate	= 0;
+	theChannelizer	= nullptr;
+	theResampler	= nullptr;
 
 	if (selectedRate == 0) {
 	   fprintf (stderr, "Sorry. cannot help you\n");
@@ -146,18 +159,19 @@ uint32_t samplerate_count;
 	   throw (45);
 	}
 
-//	The sizes of the mapTable and the convTable are
-//	predefined and follow from the input and output rate
-//	(selectedRate / 1000) vs (2048000 / 1000)
-	convBufferSize		= selectedRate / 1000;
-	for (i = 0; i < 2048; i ++) {
-	   float inVal	= float (selectedRate / 1000);
-	   mapTable_int [i] =  int (floor (i * (inVal / 2048.0)));
-	   mapTable_float [i] = i * (inVal / 2048.0) - mapTable_int [i];
-	}
-
-	convIndex		= 0;
-	convBuffer		= new std::complex<float> [convBufferSize + 1];
+	theResampler		= new resampler (selectedRate, 2048000);
+//	sized once, the callback (also the wideband one) does not allocate
+	inBuffer. resize (BLOCK_SAMPLES);
+	outBuffer. resize (theResampler -> maxOutput (BLOCK_SAMPLES));
+	theFrontEnd		= nullptr;
+	theCompact		= nullptr;
+	if (sampleMode == SAMPLES_FRONTEND)
+	   theFrontEnd		= new frontEnd (_I_Buffer, selectedRate);
+	else
+	if (sampleMode == SAMPLES_COMPACT)	// resampled, so int16 with 2 bits extra
+	   theCompact		= new compactBuffer (DEVICE_BUFFER,
+	                                     compactBuffer::COMPACT_INT16,
+	                                     1 / 8192.0f);
 	dumping. store (false);
 	running. store (false);
 	xmlFile		= nullptr;
@@ -188,6 +202,9 @@ uint32_t samplerate_count;
 	   }
 	}
 	my_airspy_exit ();
+	delete theResampler;
+	delete theFrontEnd;
+	delete theCompact;
 	if (Handle != NULL) 
 #ifdef __MINGW32__
 	   FreeLibrary (Handle);
@@ -198,13 +215,25 @@ err:;
 }
 
 bool	airspyHandler::restartReader	(int32_t frequency) {
-int	result;
-int32_t	bufSize	= EXTIO_NS * EXTIO_BASE_TYPE_SIZE * 2;
-
 	if (running. load ())
 	   return true;
 
+	if (theChannelizer != nullptr) {	// back from wideband
+	   theChannelizer	= nullptr;
+	   (void)my_airspy_set_samplerate (device, selectedRate);
+	}
+	return startReader (frequency);
+}
+
+bool	airspyHandler::startReader	(int32_t frequency) {
+int	result;
+int32_t	bufSize	= BLOCK_SAMPLES * 2 * sizeof (int16_t);
+
 	_I_Buffer	-> FlushRingBuffer ();
+	if (theFrontEnd != nullptr)
+	   theFrontEnd -> reset ();
+	if (theCompact != nullptr)
+	   theCompact -> flush ();
 
 	this	-> frequency = frequency;
 	result = my_airspy_set_freq (device, frequency);
@@ -241,6 +270,32 @@ int32_t	bufSize	= EXTIO_NS * EXTIO_BASE_TYPE_SIZE * 2;
 	return true;
 }
 
+//
+//	In wideband mode the airspy runs at its highest rate, the
+//	samples are passed to the channelizer without conversion
+int32_t	airspyHandler::widebandRate	(void) {
+	return wideRate;
+}
+
+bool	airspyHandler::restartWideband	(int32_t frequency,
+	                                 channelizer *c) {
+	if (running. load () || (wideRate == 0))
+	   return false;
+	int result = my_airspy_set_samplerate (device, wideRate);
+	if (result != AIRSPY_SUCCESS) {
+	   printf ("airspy_set_samplerate() failed: %s (%d)\n",
+	             my_airspy_error_name((enum airspy_error)result), result);
+	   return false;
+	}
+	theChannelizer	= c;
+	if (!startReader (frequency)) {
+	   theChannelizer	= nullptr;
+	   (void)my_airspy_set_samplerate (device, selectedRate);
+	   return false;
+	}
+	return true;
+}
+
 void	airspyHandler::stopReader (void) {
 
 	if (!running. load ())
@@ -298,30 +353,24 @@ airspyHandler *p;
 int 	airspyHandler::data_available (void *buf, int buf_size) {	
 int16_t	*sbuf	= (int16_t *)buf;
 int nSamples	= buf_size / (sizeof (int16_t) * 2);
-std::complex<float> temp [2048];
-int32_t  i, j;
 
 	if (dumping. load ())
 	   xmlWriter -> add ((std::complex<int16_t> *)sbuf, nSamples);
-	for (i = 0; i < nSamples; i ++) {
-	   convBuffer [convIndex ++] = std::complex<float> (sbuf [2 * i] / (float)2048,
-	                                           sbuf [2 * i + 1] / (float)2048);
-	   if (convIndex > convBufferSize) {
-	      for (j = 0; j < 2048; j ++) {
-	         int16_t  inpBase	= mapTable_int [j];
-	         float    inpRatio	= mapTable_float [j];
-	         temp [j]	= cmul (convBuffer [inpBase + 1], inpRatio) + 
-	                          cmul (convBuffer [inpBase], 1 - inpRatio);
-	      }
-
-	      _I_Buffer	-> putDataIntoBuffer (temp, 2048);
-//
-//	shift the sample at the end to the beginning, it is needed
-//	as the starting sample for the next time
-	      convBuffer [0] = convBuffer [convBufferSize];
-	      convIndex = 1;
-	   }
+	if ((theFrontEnd != nullptr) && (theChannelizer == nullptr)) {
+	   theFrontEnd -> putInt16 (sbuf, nSamples, 1 / 2048.0f);
+	   return 0;
 	}
+	convert_int16 (sbuf, inBuffer. data (), nSamples, 1 / 2048.0f);
+	if (theChannelizer != nullptr) {
+	   theChannelizer -> put (inBuffer. data (), nSamples);
+	   return 0;
+	}
+int	n	= theResampler -> process (inBuffer. data (), nSamples,
+	                                   outBuffer. data ());
+	if (theCompact != nullptr)
+	   theCompact	-> putFloat (outBuffer. data (), n);
+	else
+	   _I_Buffer	-> putDataIntoBuffer (outBuffer. data (), n);
 	return 0;
 }
 //
@@ -357,6 +406,10 @@ int result = my_airspy_open (&device);
 //
 void	airspyHandler::resetBuffer (void) {
 	_I_Buffer	-> FlushRingBuffer ();
+	if (theFrontEnd != nullptr)
+	   theFrontEnd -> reset ();
+	if (theCompact != nullptr)
+	   theCompact -> flush ();
 }
 
 int16_t	airspyHandler::bitDepth (void) {
@@ -375,7 +428,8 @@ void	airspyHandler::startDumping	(const std::string &fileName) {
 	xmlWriter	= new xml_fileWriter (xmlFile,
 	                                      12,
 	                                      "int16",
-	                                      selectedRate,
+	                                      theChannelizer != nullptr ?
+	                                           wideRate : selectedRate,
 	                                      frequency,
 	                                      "AIRspy",
 	                                      "old",
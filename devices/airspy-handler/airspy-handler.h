@@ -21,6 +21,7 @@
 #include	"device-handler.h"
 #include	<complex>
 #include	<atomic>
+#include	<vector>
 
 #ifdef  __MINGW32__
 #include        "windows.h"
@@ -39,6 +40,9 @@ typedef void    *HINSTANCE;
 #endif
 
 class	xml_fileWriter;
+class	resampler;
+class	frontEnd;
+class	compactBuffer;
 
 extern "C"  {
 typedef	int (*pfn_airspy_init) (void);
@@ -93,9 +97,12 @@ public:
 			airspyHandler		(RingBuffer<std::complex<float>>*,
 	                                         const std::string &,
 	                                         int32_t, int16_t,
-	                                         int16_t, bool);
+	                                         int16_t, bool,
+	                                         int sampleMode = SAMPLES_FLOAT);
 			~airspyHandler		(void);
 	bool		restartReader		(int32_t);
+	bool		restartWideband		(int32_t, channelizer *);
+	int32_t		widebandRate		(void);
 	void		stopReader		(void);
 	void		resetBuffer		(void);
 	int16_t		bitDepth		(void);
@@ -104,6 +111,7 @@ public:
 	std::string	deviceName		();
 private:
 	bool		load_airspyFunctions	(void);
+	bool		startReader		(int32_t);
 //	The functions to be extracted from the dll/.so file
 	pfn_airspy_init		   my_airspy_init;
 	pfn_airspy_exit		   my_airspy_exit;
@@ -142,11 +150,11 @@ private:
 	std::atomic<bool>	running;
 const	char*		board_id_name (void);
 	int32_t		selectedRate;
-	std::complex<float>	*convBuffer;
-	int16_t		convBufferSize;
-	int16_t		convIndex;
-	int16_t		mapTable_int   [4 * 512];
-	float		mapTable_float [4 * 512];
+	int32_t		wideRate;
+	channelizer	*theChannelizer;
+	resampler	*theResampler;
+	std::vector<std::complex<float>>	inBuffer;
+	std::vector<std::complex<float>>	outBuffer;
 	RingBuffer<std::complex<float>> *theBuffer;
 	struct airspy_device* device;
 	uint64_t 	serialNumber;
@@ -0,0 +1,225 @@
+#
+/*
+ *    Copyright (C) 2020
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of channelScanner
+ *
+ *    channelScanner is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    channelScanner is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with channelScanner; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include	"compact-buffer.h"
+#include	"sample-convert.h"
+#include	<string.h>
+
+#if defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))
+#define	COMPACT_X86
+#include	<immintrin.h>
+#endif
+//
+//	n elements into the write regions of b, fill (dst, from, count)
+//	writes the elements from .. from + count - 1 of the input
+template <typename T, typename F>
+static
+void	put	(RingBuffer<T> *b, int32_t n, F fill) {
+void	*data1, *data2;
+int32_t	size1, size2;
+	n	= b -> GetRingBufferWriteRegions (n, &data1, &size1,
+	                                         &data2, &size2);
+	fill (static_cast<T *>(data1), 0, size1);
+	fill (static_cast<T *>(data2), size1, size2);
+	b -> AdvanceRingBufferWriteIndex (n);
+}
+//
+//	rounded and clipped, n is the number of floats. On x86 the
+//	conversion rounds to nearest and the packing saturates
+template <typename T>
+static
+void	quantize_generic	(const float *x, T *z, int32_t n,
+	                         float factor, float low, float high) {
+	for (int32_t i = 0; i < n; i ++) {
+	   float t	= x [i] * factor;
+	   t	= t < low ? low : t > high ? high : t;
+	   z [i]	= (T)(t + (t >= 0 ? 0.5f : -0.5f));
+	}
+}
+
+static
+void	quantize	(const std::complex<float> *in, int8_t *out,
+	                 int32_t n, float factor) {
+const float *x	= reinterpret_cast<const float *>(in);
+int32_t	i	= 0;
+#ifdef	COMPACT_X86
+const __m128 f	= _mm_set1_ps (factor);
+	for (; i + 16 <= 2 * n; i += 16) {
+	   __m128i a = _mm_cvtps_epi32 (_mm_mul_ps (_mm_loadu_ps (x + i), f));
+	   __m128i b = _mm_cvtps_epi32 (_mm_mul_ps (_mm_loadu_ps (x + i + 4), f));
+	   __m128i c = _mm_cvtps_epi32 (_mm_mul_ps (_mm_loadu_ps (x + i + 8), f));
+	   __m128i d = _mm_cvtps_epi32 (_mm_mul_ps (_mm_loadu_ps (x + i + 12), f));
+	   _mm_storeu_si128 ((__m128i *)(out + i),
+	                     _mm_packs_epi16 (_mm_packs_epi32 (a, b),
+	                                      _mm_packs_epi32 (c, d)));
+	}
+#endif
+	quantize_generic (x + i, out + i, 2 * n - i, factor, -128, 127);
+}
+
+static
+void	quantize	(const std::complex<float> *in, int16_t *out,
+	                 int32_t n, float factor) {
+const float *x	= reinterpret_cast<const float *>(in);
+int32_t	i	= 0;
+#ifdef	COMPACT_X86
+const __m128 f	= _mm_set1_ps (factor);
+	for (; i + 8 <= 2 * n; i += 8) {
+	   __m128i a = _mm_cvtps_epi32 (_mm_mul_ps (_mm_loadu_ps (x + i), f));
+	   __m128i b = _mm_cvtps_epi32 (_mm_mul_ps (_mm_loadu_ps (x + i + 4), f));
+	   _mm_storeu_si128 ((__m128i *)(out + i), _mm_packs_epi32 (a, b));
+	}
+#endif
+	quantize_generic (x + i, out + i, 2 * n - i, factor, -32768, 32767);
+}
+
+	compactBuffer::compactBuffer	(int32_t size,
+	                                 sampleType t, float scale) {
+	this	-> theType	= t;
+	this	-> scale	= scale;
+	buffer8		= nullptr;
+	buffer16	= nullptr;
+	if (t == COMPACT_INT8)
+	   buffer8	= new RingBuffer<std::complex<int8_t>> (size, true);
+	else
+	   buffer16	= new RingBuffer<std::complex<int16_t>> (size, true);
+}
+
+	compactBuffer::~compactBuffer	() {
+	delete buffer8;
+	delete buffer16;
+}
+
+compactBuffer::sampleType	compactBuffer::type	() {
+	return theType;
+}
+
+void	compactBuffer::putUint8	(const uint8_t *p, int32_t n) {
+	if (buffer8 == nullptr)
+	   return;
+	put (buffer8, n, [&] (std::complex<int8_t> *d, int32_t from, int32_t k) {
+	        const uint8_t *__restrict x	= &p [2 * from];
+	        uint8_t *__restrict z	= reinterpret_cast<uint8_t *>(d);
+	        for (int32_t i = 0; i < 2 * k; i ++)
+	           z [i]	= x [i] ^ 0x80;
+	     });
+}
+
+void	compactBuffer::putInt8	(const int8_t *p, int32_t n) {
+	if (buffer8 == nullptr)
+	   return;
+	put (buffer8, n, [&] (std::complex<int8_t> *d, int32_t from, int32_t k) {
+	        memcpy ((void *)d, &p [2 * from], 2 * k);
+	     });
+}
+
+void	compactBuffer::putInt16	(const int16_t *p, int32_t n) {
+	if (buffer16 == nullptr)
+	   return;
+	put (buffer16, n, [&] (std::complex<int16_t> *d, int32_t from, int32_t k) {
+	        memcpy ((void *)d, &p [2 * from], 4 * k);
+	     });
+}
+
+void	compactBuffer::putInt16	(const int16_t *xi, const int16_t *xq,
+	                                 int32_t n) {
+	if (buffer16 == nullptr)
+	   return;
+	put (buffer16, n, [&] (std::complex<int16_t> *d, int32_t from, int32_t k) {
+	        int16_t *__restrict z	= reinterpret_cast<int16_t *>(d);
+	        for (int32_t i = 0; i < k; i ++) {
+	           z [2 * i]	= xi [from + i];
+	           z [2 * i + 1] = xq [from + i];
+	        }
+	     });
+}
+
+void	compactBuffer::putFloat	(const std::complex<float> *v, int32_t n) {
+	if (buffer8 != nullptr)
+	   put (buffer8, n,
+	        [&] (std::complex<int8_t> *d, int32_t from, int32_t k) {
+	           quantize (&v [from], reinterpret_cast<int8_t *>(d),
+	                                                 k, 1 / scale);
+	        });
+	else
+	   put (buffer16, n,
+	        [&] (std::complex<int16_t> *d, int32_t from, int32_t k) {
+	           quantize (&v [from], reinterpret_cast<int16_t *>(d),
+	                                                 k, 1 / scale);
+	        });
+}
+
+bool	compactBuffer::waitForWriteAvailable	(int32_t n, int32_t ms) {
+	if (buffer8 != nullptr)
+	   return buffer8 -> WaitForWriteAvailable (n, ms);
+	return buffer16 -> WaitForWriteAvailable (n, ms);
+}
+
+void	compactBuffer::flush	() {
+	if (buffer8 != nullptr)
+	   buffer8 -> FlushRingBuffer ();
+	else
+	   buffer16 -> FlushRingBuffer ();
+}
+
+int32_t	compactBuffer::readAvailable	() {
+	if (buffer8 != nullptr)
+	   return buffer8 -> GetRingBufferReadAvailable ();
+	return buffer16 -> GetRingBufferReadAvailable ();
+}
+
+bool	compactBuffer::waitForReadAvailable	(int32_t n, int32_t ms) {
+	if (buffer8 != nullptr)
+	   return buffer8 -> WaitForReadAvailable (n, ms);
+	return buffer16 -> WaitForReadAvailable (n, ms);
+}
+
+void	compactBuffer::wakeAll	() {
+	if (buffer8 != nullptr)
+	   buffer8 -> WakeAll ();
+	else
+	   buffer16 -> WakeAll ();
+}
+//
+//	converted straight from the buffer regions into v
+int32_t	compactBuffer::get	(std::complex<float> *v, int32_t n) {
+void	*data1, *data2;
+int32_t	size1, size2;
+
+	if (buffer8 != nullptr) {
+	   n	= buffer8 -> GetRingBufferReadRegions (n, &data1, &size1,
+	                                                  &data2, &size2);
+	   convert_int8 (static_cast<int8_t *>(data1), v, size1, scale);
+	   convert_int8 (static_cast<int8_t *>(data2), &v [size1],
+	                                                  size2, scale);
+	   buffer8 -> AdvanceRingBufferReadIndex (n);
+	   return n;
+	}
+	n	= buffer16 -> GetRingBufferReadRegions (n, &data1, &size1,
+	                                                &data2, &size2);
+	convert_int16 (static_cast<int16_t *>(data1), v, size1, scale);
+	convert_int16 (static_cast<int16_t *>(data2), &v [size1],
+	                                                  size2, scale);
+	buffer16 -> AdvanceRingBufferReadIndex (n);
+	return n;
+}
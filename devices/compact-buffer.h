@@ -0,0 +1,74 @@
+#
+/*
+ *    Copyright (C) 2020
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of channelScanner
+ *
+ *    channelScanner is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    channelScanner is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with channelScanner; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *	Compact sample storage: instead of complex floats (8 bytes) the
+ *	buffer between device and decoder holds the samples as the
+ *	device delivers them, complex int8 (rtlsdr, hackrf) or complex
+ *	int16 (the others), i.e. 2 or 4 bytes a sample. The sampleReader
+ *	converts them when it takes them out, in the blocks it corrects
+ *	the frequency in.
+ *	Samples that are resampled first (airspy, pluto, uff files at
+ *	another rate) are stored as int16, scaled such that the 12 bits
+ *	of the device keep 2 extra bits.
+ */
+#ifndef	__COMPACT_BUFFER__
+#define	__COMPACT_BUFFER__
+
+#include	<stdint.h>
+#include	<complex>
+#include	"ringbuffer.h"
+
+class	compactBuffer {
+public:
+	enum sampleType {
+	   COMPACT_INT8,
+	   COMPACT_INT16
+	};
+//	the buffer takes the place of the float buffer, it holds "size"
+//	elements (a power of 2); a stored value v stands for v * scale
+			compactBuffer	(int32_t size,
+	                                 sampleType, float scale);
+			~compactBuffer	();
+	sampleType	type		();
+//	the writer side, what does not fit is lost. The integer input
+//	should match the type, uint8 is stored as int8 (i.e. - 128)
+	void		putUint8	(const uint8_t *, int32_t n);
+	void		putInt8		(const int8_t *, int32_t n);
+	void		putInt16	(const int16_t *, int32_t n);
+	void		putInt16	(const int16_t *, const int16_t *,
+	                                 int32_t n);
+	void		putFloat	(const std::complex<float> *, int32_t n);
+	bool		waitForWriteAvailable	(int32_t n, int32_t ms);
+	void		flush		();
+//	the reader side, the samples are converted to float
+	int32_t		readAvailable	();
+	bool		waitForReadAvailable	(int32_t n, int32_t ms);
+	int32_t		get		(std::complex<float> *, int32_t n);
+	void		wakeAll		();
+private:
+	sampleType	theType;
+	float		scale;
+	RingBuffer<std::complex<int8_t>>	*buffer8;
+	RingBuffer<std::complex<int16_t>>	*buffer16;
+};
+#endif
+
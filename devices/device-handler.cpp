@@ -27,6 +27,8 @@
 
 	deviceHandler::deviceHandler (RingBuffer<std::complex<float>> *b) {
 	_I_Buffer = b;
+	theFrontEnd	= nullptr;
+	theCompact	= nullptr;
 }
 
 	deviceHandler::~deviceHandler (void) {
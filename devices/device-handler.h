@@ -33,6 +33,21 @@
 #include	"ringbuffer.h"
 using namespace std;
 
+class	channelizer;
+class	frontEnd;
+class	compactBuffer;
+
+//	how a device puts its samples into the buffer: as floats, through
+//	a front end that corrects them already (-f), or as integers in a
+//	compactBuffer of its own (-c)
+#define	SAMPLES_FLOAT		0
+#define	SAMPLES_FRONTEND	1
+#define	SAMPLES_COMPACT		2
+//	the number of samples between device and decoder. With compact
+//	storage the float buffer is not used, a small one will do
+#define	DEVICE_BUFFER		(16 * 32768)
+#define	STANDIN_BUFFER		1024
+
 class	deviceHandler {
 public:
 			deviceHandler 	(RingBuffer<std::complex<float>> *);
@@ -42,11 +57,23 @@ virtual		void	stopReader	(void);
 virtual		void	startDumping	(const std::string &);
 virtual		void	stopDumping	();
 virtual		int16_t	bitDepth	(void) { return 10;}
+virtual		bool	endReached	(void) { return false;}
+//	devices that can deliver a wideband stream (rate > 2048000)
+//	tell the rate, in wideband mode the samples go to a channelizer
+virtual		int32_t	widebandRate	(void) { return 0;}
+virtual		bool	restartWideband	(int32_t, channelizer *) {
+	                                                  return false;}
 virtual		std::string deviceName	();
 		std::string	toHex	(uint32_t);
+//	the front end the device writes through or the compact storage
+//	it writes into, if any, the reader of the buffer needs them
+		frontEnd	*getFrontEnd	() { return theFrontEnd; }
+		compactBuffer	*getCompact	() { return theCompact; }
 //
 protected:
 		RingBuffer<std::complex<float>> *_I_Buffer;
+		frontEnd	*theFrontEnd;
+		compactBuffer	*theCompact;
 		int32_t	vfoFrequency;
 	        int32_t	vfoOffset;
 	        int	theGain;
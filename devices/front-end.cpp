@@ -0,0 +1,279 @@
+#
+/*
+ *    Copyright (C) 2020
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of channelScanner
+ *
+ *    channelScanner is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    channelScanner is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with channelScanner; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include	"front-end.h"
+#include	"sample-convert.h"
+#include	"resampler.h"
+#include	"dab-constants.h"
+#include	<string.h>
+#include	<math.h>
+#include	<algorithm>
+//
+//	The frequency correction is a numerically controlled oscillator:
+//	four phasors, each for every fourth sample, are rotated by
+//	4 * step, so the inner loop has no dependencies between the
+//	samples and is vectorized by the compiler. The phasors are
+//	recomputed from the (integer) phase every NCO_ANCHOR samples,
+//	so rounding errors do not accumulate
+#define	NCO_ANCHOR	1024
+#define	NCO_LANES	4
+//
+//	the number of input samples handled in one go, the intermediate
+//	results (a block and its resampled version) stay in the cache
+#define	FE_BLOCK	2048
+
+void	nco_rotate	(const std::complex<float> *in,
+	                 std::complex<float> *out,
+	                 int32_t n, int32_t offset, int32_t &phase) {
+const float *__restrict x	= reinterpret_cast<const float *>(in);
+float	*__restrict z		= reinterpret_cast<float *>(out);
+double	stepAngle	= - 2 * M_PI * offset / INPUT_RATE;
+float	stepRe		= cos (NCO_LANES * stepAngle);
+float	stepIm		= sin (NCO_LANES * stepAngle);
+
+	for (int base = 0; base < n; base += NCO_ANCHOR) {
+	   int32_t m	= std::min (NCO_ANCHOR, n - base);
+	   int32_t first = ((phase - offset) % INPUT_RATE + INPUT_RATE) %
+	                                                      INPUT_RATE;
+	   double angle	= 2 * M_PI * first / INPUT_RATE;
+	   float pRe [NCO_LANES], pIm [NCO_LANES];
+	   for (int k = 0; k < NCO_LANES; k ++) {
+	      pRe [k]	= cos (angle + k * stepAngle);
+	      pIm [k]	= sin (angle + k * stepAngle);
+	   }
+	   const float *__restrict y	= &x [2 * base];
+	   float *__restrict w	= &z [2 * base];
+	   int	i	= 0;
+	   for (; i + NCO_LANES <= m; i += NCO_LANES) {
+	      for (int k = 0; k < NCO_LANES; k ++) {
+	         float re	= y [2 * (i + k)];
+	         float im	= y [2 * (i + k) + 1];
+	         w [2 * (i + k)]	= re * pRe [k] - im * pIm [k];
+	         w [2 * (i + k) + 1]	= re * pIm [k] + im * pRe [k];
+	         float t	= pRe [k] * stepRe - pIm [k] * stepIm;
+	         pIm [k]	= pRe [k] * stepIm + pIm [k] * stepRe;
+	         pRe [k]	= t;
+	      }
+	   }
+//	lane k now holds the phasor for sample i + k
+	   for (int k = 0; i + k < m; k ++) {
+	      float re	= y [2 * (i + k)];
+	      float im	= y [2 * (i + k) + 1];
+	      w [2 * (i + k)]	= re * pRe [k] - im * pIm [k];
+	      w [2 * (i + k) + 1]	= re * pIm [k] + im * pRe [k];
+	   }
+	   phase	= ((phase - (int64_t)offset * m) % INPUT_RATE +
+	                                       INPUT_RATE) % INPUT_RATE;
+	}
+}
+//
+//	computed as w^n * level + alpha * sum (w^(n - 1 - i) * |v [i]|),
+//	w = 1 - alpha, the sum again in four independent lanes.
+//	In float w differs too much from 1 - alpha, hence the doubles
+float	level_update	(const std::complex<float> *v,
+	                 int32_t n, float level) {
+const float *x	= reinterpret_cast<const float *>(v);
+const double w	= 1 - (double)LEVEL_ALPHA;
+const double w4	= w * w * w * w;
+double	acc [NCO_LANES] = {0, 0, 0, 0};
+int	i	= 0;
+
+	for (; i + NCO_LANES <= n; i += NCO_LANES)
+	   for (int k = 0; k < NCO_LANES; k ++)
+	      acc [k] = acc [k] * w4 + fabsf (x [2 * (i + k)]) +
+	                               fabsf (x [2 * (i + k) + 1]);
+	double sum	= ((acc [0] * w + acc [1]) * w + acc [2]) * w + acc [3];
+	for (; i < n; i ++)
+	   sum	= sum * w + fabsf (x [2 * i]) + fabsf (x [2 * i + 1]);
+	return pow (w, n) * level + LEVEL_ALPHA * sum;
+}
+
+	frontEnd::frontEnd	(RingBuffer<std::complex<float>> *b,
+	                         int32_t inRate):
+	                            convBuffer (FE_BLOCK) {
+	this	-> _I_Buffer	= b;
+	this	-> inRate	= inRate;
+	theResampler		= nullptr;
+	if (inRate != INPUT_RATE) {
+	   theResampler	= new resampler (inRate, INPUT_RATE);
+	   rateBuffer. resize (theResampler -> maxOutput (FE_BLOCK));
+	}
+	offset		= 0;
+	phase		= 0;
+	sLevel		= 0;
+	publishedLevel. store (0);
+	requested. store (false);
+	nrChanges. store (0);
+	reqOffset	= 0;
+	reqPosition	= 0;
+	reqPhase	= 0;
+}
+
+	frontEnd::~frontEnd	() {
+	delete theResampler;
+}
+
+int32_t	frontEnd::maxOutput	(int32_t n) {
+int32_t	blocks	= (n + FE_BLOCK - 1) / FE_BLOCK;
+	if (theResampler == nullptr)
+	   return n;
+	return blocks * theResampler -> maxOutput (FE_BLOCK);
+}
+
+void	frontEnd::putUint8	(const uint8_t *p, int32_t n, float scale) {
+	for (int32_t i = 0; i < n; i += FE_BLOCK) {
+	   int32_t m	= std::min (FE_BLOCK, n - i);
+	   convert_uint8 (&p [2 * i], convBuffer. data (), m, scale);
+	   process (convBuffer. data (), m);
+	}
+}
+
+void	frontEnd::putInt8	(const int8_t *p, int32_t n, float scale) {
+	for (int32_t i = 0; i < n; i += FE_BLOCK) {
+	   int32_t m	= std::min (FE_BLOCK, n - i);
+	   convert_int8 (&p [2 * i], convBuffer. data (), m, scale);
+	   process (convBuffer. data (), m);
+	}
+}
+
+void	frontEnd::putInt16	(const int16_t *p, int32_t n, float scale) {
+	for (int32_t i = 0; i < n; i += FE_BLOCK) {
+	   int32_t m	= std::min (FE_BLOCK, n - i);
+	   convert_int16 (&p [2 * i], convBuffer. data (), m, scale);
+	   process (convBuffer. data (), m);
+	}
+}
+
+void	frontEnd::putInt16	(const int16_t *xi, const int16_t *xq,
+	                         int32_t n, float scale) {
+	for (int32_t i = 0; i < n; i += FE_BLOCK) {
+	   int32_t m	= std::min (FE_BLOCK, n - i);
+	   convert_int16_planar (&xi [i], &xq [i],
+	                         convBuffer. data (), m, scale);
+	   process (convBuffer. data (), m);
+	}
+}
+
+void	frontEnd::putFloat	(const std::complex<float> *p, int32_t n) {
+	for (int32_t i = 0; i < n; i += FE_BLOCK)
+	   process (&p [i], std::min (FE_BLOCK, n - i));
+}
+//
+//	one block: resampled (if needed) into rateBuffer, then corrected
+//	while copied into the buffer. The level is taken from what was
+//	just written, it is still in the cache
+void	frontEnd::process	(const std::complex<float> *in, int32_t n) {
+const std::complex<float> *v	= in;
+void	*data1, *data2;
+int32_t	size1, size2;
+
+	if (theResampler != nullptr) {
+	   n	= theResampler -> process (in, n, rateBuffer. data ());
+	   v	= rateBuffer. data ();
+	}
+	if (n == 0)
+	   return;
+	takeOver ();
+	n	= _I_Buffer -> GetRingBufferWriteRegions (n, &data1, &size1,
+	                                                 &data2, &size2);
+std::complex<float> *region1	= static_cast<std::complex<float> *>(data1);
+std::complex<float> *region2	= static_cast<std::complex<float> *>(data2);
+	if ((offset != 0) || (phase != 0)) {
+	   nco_rotate (v, region1, size1, offset, phase);
+	   nco_rotate (&v [size1], region2, size2, offset, phase);
+	}
+	else {
+	   memcpy (region1, v, size1 * sizeof (std::complex<float>));
+	   memcpy (region2, &v [size1], size2 * sizeof (std::complex<float>));
+	}
+	sLevel	= level_update (region1, size1, sLevel);
+	sLevel	= level_update (region2, size2, sLevel);
+	publishedLevel. store (sLevel, std::memory_order_relaxed);
+	_I_Buffer -> AdvanceRingBufferWriteIndex (n);
+}
+//
+//	a request of the reader is handled at the start of a block.
+//	Between the position of the reader and here the reader
+//	corrects with (reqOffset - offset), what its phase will be here
+//	is absorbed in ours, the reader subtracts it when it gets here
+void	frontEnd::takeOver	() {
+	if (!requested. load (std::memory_order_acquire))
+	   return;
+std::lock_guard<std::mutex> lk (locker);
+	if (!requested. load ())
+	   return;
+uint64_t here	= _I_Buffer -> WritePosition ();
+int64_t	distance = (here - reqPosition) % INPUT_RATE;
+int64_t	step	= (reqOffset - offset) % INPUT_RATE;
+int32_t	absorbed = ((reqPhase - distance * step) % INPUT_RATE +
+	                                         INPUT_RATE) % INPUT_RATE;
+	phase	= (phase + absorbed) % INPUT_RATE;
+	offset	= reqOffset;
+	changes. push_back ({here, offset, absorbed});
+	nrChanges. fetch_add (1);
+	requested. store (false);
+}
+
+void	frontEnd::reset	() {
+std::lock_guard<std::mutex> lk (locker);
+	requested. store (false);
+	offset	= 0;
+	phase	= 0;
+	sLevel	= 0;
+	publishedLevel. store (0);
+	changes. push_back ({_I_Buffer -> WritePosition (), 0, 0});
+	nrChanges. fetch_add (1);
+}
+
+float	frontEnd::level	() {
+	return publishedLevel. load (std::memory_order_relaxed);
+}
+
+void	frontEnd::request	(int32_t offset,
+	                         uint64_t position, int32_t phase) {
+std::lock_guard<std::mutex> lk (locker);
+	reqOffset	= offset;
+	reqPosition	= position;
+	reqPhase	= phase;
+	requested. store (true, std::memory_order_release);
+}
+
+//
+//	most of the time there is none, then we do not lock
+bool	frontEnd::nextChange	(change *c) {
+	if (nrChanges. load () == 0)
+	   return false;
+std::lock_guard<std::mutex> lk (locker);
+	if (changes. empty ())
+	   return false;
+	*c	= changes. front ();
+	return true;
+}
+
+void	frontEnd::popChange	() {
+std::lock_guard<std::mutex> lk (locker);
+	if (!changes. empty ()) {
+	   changes. pop_front ();
+	   nrChanges. fetch_sub (1);
+	}
+}
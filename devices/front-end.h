@@ -0,0 +1,114 @@
+#
+/*
+ *    Copyright (C) 2020
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of channelScanner
+ *
+ *    channelScanner is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    channelScanner is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with channelScanner; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *	The fused front end: the samples of a device are converted,
+ *	resampled, corrected in frequency and measured (the level) in
+ *	blocks small enough to stay in the cache, the result goes
+ *	straight into the ringbuffer. The sampleReader then has nothing
+ *	left to do but copying.
+ *	The frequency offset is the one the processor asks the
+ *	sampleReader for, the reader hands it over, together with the
+ *	phase it is at, and the front end tells at which sample (the
+ *	position in the ringbuffer) it took over. Up to that sample the
+ *	reader corrects the difference itself, so the phase of the
+ *	correction is continuous.
+ *	A device makes its front end when asked for (SAMPLES_FRONTEND),
+ *	the reader gets it from the device, through the scanContext.
+ */
+#ifndef	__FRONT_END__
+#define	__FRONT_END__
+
+#include	<stdint.h>
+#include	<complex>
+#include	<vector>
+#include	<deque>
+#include	<mutex>
+#include	<atomic>
+#include	"ringbuffer.h"
+
+class	resampler;
+
+//	sample i is multiplied by exp (j * 2 * PI * phase / INPUT_RATE),
+//	phase = phase - (i + 1) * offset, the phase (mod INPUT_RATE) is
+//	updated. in and out do not overlap
+void	nco_rotate	(const std::complex<float> *in,
+	                 std::complex<float> *out,
+	                 int32_t n, int32_t offset, int32_t &phase);
+//	level = alpha * (|re| + |im|) + (1 - alpha) * level for all samples
+#define	LEVEL_ALPHA	0.00001
+float	level_update	(const std::complex<float> *,
+	                 int32_t n, float level);
+
+class	frontEnd {
+public:
+//	a change of the correction as applied by the front end: from
+//	position on, the offset is "offset" and "absorbed" was added
+//	to the phase
+	struct change {
+	   uint64_t	position;
+	   int32_t	offset;
+	   int32_t	absorbed;
+	};
+			frontEnd	(RingBuffer<std::complex<float>> *,
+	                                 int32_t inRate);
+			~frontEnd	();
+//	the input, n complex samples; what does not fit in the buffer
+//	is lost
+	void		putUint8	(const uint8_t *, int32_t n, float scale);
+	void		putInt8		(const int8_t *, int32_t n, float scale);
+	void		putInt16	(const int16_t *, int32_t n, float scale);
+	void		putInt16	(const int16_t *, const int16_t *,
+	                                 int32_t n, float scale);
+	void		putFloat	(const std::complex<float> *, int32_t n);
+//	the number of samples written for n input samples, at most
+	int32_t		maxOutput	(int32_t n);
+//	to be called (by the device) when the buffer is flushed
+	void		reset		();
+	float		level		();
+//	the reader side: ask for "offset" to be applied, the reader is
+//	at position with the given phase
+	void		request		(int32_t offset,
+	                                 uint64_t position, int32_t phase);
+	bool		nextChange	(change *);
+	void		popChange	();
+private:
+	RingBuffer<std::complex<float>> *_I_Buffer;
+	int32_t		inRate;
+	resampler	*theResampler;
+	std::vector<std::complex<float>>	convBuffer;
+	std::vector<std::complex<float>>	rateBuffer;
+	int32_t		offset;
+	int32_t		phase;
+	float		sLevel;
+	std::atomic<float>	publishedLevel;
+	std::mutex	locker;
+	std::atomic<bool>	requested;
+	int32_t		reqOffset;
+	uint64_t	reqPosition;
+	int32_t		reqPhase;
+	std::deque<change>	changes;
+	std::atomic<int32_t>	nrChanges;
+	void		takeOver	();
+	void		process		(const std::complex<float> *, int32_t n);
+};
+#endif
+
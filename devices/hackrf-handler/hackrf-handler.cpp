@@ -23,7 +23,10 @@
  */
 
 #include	"hackrf-handler.h"
-#include	"xml-filewriter.h"
+#include	"sample-recorder.h"
+#include	"sample-convert.h"
+#include	"front-end.h"
+#include	"compact-buffer.h"
 #include	<unistd.h>
 
 #define	DEFAULT_GAIN	30
@@ -34,7 +37,8 @@
 	                               int16_t	ppm,
 	                               int16_t	lnaGain,
 	                               int16_t	vgaGain,
-	                               bool	ampEnable):
+	                               bool	ampEnable,
+	                               int	sampleMode):
 	                                 deviceHandler (b) {
 int	res;
 	this	-> _I_Buffer		= b;
@@ -101,10 +105,21 @@ int	res;
 	dumping. store (false);
 	running. store (false);
 	xmlFile		= nullptr;
+	theFrontEnd	= nullptr;
+	theCompact	= nullptr;
+	if (sampleMode == SAMPLES_FRONTEND)
+	   theFrontEnd	= new frontEnd (_I_Buffer, inputRate);
+	else
+	if (sampleMode == SAMPLES_COMPACT)
+	   theCompact	= new compactBuffer (DEVICE_BUFFER,
+	                                     compactBuffer::COMPACT_INT8,
+	                                     1 / 128.0f);
 }
 
 	hackrfHandler::~hackrfHandler	(void) {
 	stopReader ();
+	delete theFrontEnd;
+	delete theCompact;
 	hackrf_close (theDevice);
 	hackrf_exit ();
 }
@@ -135,25 +150,33 @@ int	res;
 	}
 }
 //
-//	we use a static large buffer, rather than trying to allocate
-//	a buffer on the stack
-static std::complex<float>buffer [32 * 32768];
+//	the samples are converted straight into the buffer, what does
+//	not fit is lost
 static
 int	callback (hackrf_transfer *transfer) {
 hackrfHandler *ctx = static_cast <hackrfHandler *>(transfer -> rx_ctx);
-int	i;
-uint8_t *p	= transfer -> buffer;
+int8_t	*p	= (int8_t *)(transfer -> buffer);
 RingBuffer<std::complex<float> > * q = ctx -> _I_Buffer;
+void	*data1, *data2;
+int32_t	size1, size2;
 
-	for (i = 0; i < transfer -> valid_length / 2; i ++) {
-	   float re	= (((int8_t *)p) [2 * i]) / 128.0;
-	   float im	= (((int8_t *)p) [2 * i + 1]) / 128.0;
-	   buffer [i]	= std::complex<float> (re, im);
+	if (ctx -> getFrontEnd () != nullptr) {
+	   ctx -> getFrontEnd () -> putInt8 (p, transfer -> valid_length / 2,
+	                                                      1 / 128.0f);
+	   return 0;
 	}
-	q -> putDataIntoBuffer (buffer, transfer -> valid_length / 2);
-	if (ctx -> dumping. load ())
-	   ctx -> xmlWriter -> add ((std::complex<int8_t> *)p,
-	                                      transfer -> valid_length / 2);
+	if (ctx -> getCompact () != nullptr) {
+	   ctx -> getCompact () -> putInt8 (p, transfer -> valid_length / 2);
+	   return 0;
+	}
+	int32_t n = q -> GetRingBufferWriteRegions (transfer -> valid_length / 2,
+	                                            &data1, &size1,
+	                                            &data2, &size2);
+	convert_int8 (p, static_cast<std::complex<float> *>(data1),
+	              size1, 1 / 128.0f);
+	convert_int8 (p + 2 * size1, static_cast<std::complex<float> *>(data2),
+	              size2, 1 / 128.0f);
+	q -> AdvanceRingBufferWriteIndex (n);
 	return 0;
 }
 
@@ -163,6 +186,10 @@ int	res;
 	if (running. load ())
 	   return true;
 
+	if (theFrontEnd != nullptr)
+	   theFrontEnd -> reset ();
+	if (theCompact != nullptr)
+	   theCompact -> flush ();
 	res     = hackrf_set_freq (theDevice, newFrequency);
         if (res != HACKRF_SUCCESS) {
            fprintf (stderr, "Problem with hackrf_set_freq: \n");
@@ -207,6 +234,10 @@ int	res;
 
 void	hackrfHandler::resetBuffer	(void) {
 	_I_Buffer	-> FlushRingBuffer ();
+	if (theFrontEnd != nullptr)
+	   theFrontEnd -> reset ();
+	if (theCompact != nullptr)
+	   theCompact -> flush ();
 }
 
 int16_t	hackrfHandler::bitDepth	(void) {
@@ -218,9 +249,11 @@ void	hackrfHandler::startDumping	(const std::string &fileName) {
 	if (xmlFile == nullptr)
 	   return;
 	
-	xmlWriter	= new xml_fileWriter (xmlFile,
+	theRecorder	= new sampleRecorder (_I_Buffer,
+	                                      xmlFile,
 	                                      8,
 	                                      "int8",
+	                                      128.0,
 	                                      2048000,
 	                                      vfoFrequency,
 	                                      "Hackrf",
@@ -235,9 +268,7 @@ void	hackrfHandler::stopDumping	() {
 	if (xmlFile == nullptr)	// this can happen !!
 	   return;
 	dumping. store (false);
-	usleep (1000);
-	xmlWriter	-> print_xmlHeader ();
-	delete xmlWriter;
+	delete theRecorder;		// writes the header
 	fclose (xmlFile);
 	xmlFile		= nullptr;
 }
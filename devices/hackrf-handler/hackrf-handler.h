@@ -26,10 +26,13 @@
 
 #include	"ringbuffer.h"
 #include	<atomic>
+#include	<vector>
 #include	"device-handler.h"
 #include	"libhackrf/hackrf.h"
 
-class	xml_fileWriter;
+class	sampleRecorder;
+class	frontEnd;
+class	compactBuffer;
 typedef int (*hackrf_sample_block_cb_fn)(hackrf_transfer *transfer);
 
 
@@ -42,7 +45,8 @@ public:
 	                                         int16_t  ppm,
                                                  int16_t  lnaGain,
                                                  int16_t  vgaGain,
-	                                         bool	ampEnable = false);
+	                                         bool	ampEnable = false,
+	                                         int	sampleMode = SAMPLES_FLOAT);
 			~hackrfHandler		(void);
 	bool		restartReader		(int32_t);
 	void		stopReader		(void);
@@ -55,7 +59,7 @@ public:
 	RingBuffer<std::complex<float>>	*_I_Buffer;
 	hackrf_device	*theDevice;
 	std::atomic<bool>	dumping;
-	xml_fileWriter	*xmlWriter;
+	sampleRecorder	*theRecorder;
 private:
 	std::string	recorderVersion;
 	FILE		*xmlFile;
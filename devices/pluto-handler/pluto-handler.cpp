@@ -22,7 +22,13 @@
 
 #include	"pluto-handler.h"
 #include	"xml-filewriter.h"
+#include	"sample-convert.h"
+#include	"resampler.h"
+#include	"front-end.h"
+#include	"compact-buffer.h"
 #include	<unistd.h>
+#include	<cstring>
+#include	<vector>
 #include	"ad9361.h"
 
 /* static scratch mem for strings */
@@ -154,16 +160,12 @@ int	ret;
 	return true;
 }
 
-static inline
-std::complex<float> cmul (std::complex<float> x, float y) {
-	return std::complex<float> (real (x) * y, imag (x) * y);
-}
-
 	plutoHandler::plutoHandler  (RingBuffer<std::complex<float>>*b,
 	                             const std::string	 &recorderVersion,
 	                             int32_t	frequency,
 	                             int	gainValue,
-	                             bool	agcMode):
+	                             bool	agcMode,
+	                             int	sampleMode):
 	                               deviceHandler (b) {
 	this	-> _I_Buffer		= b;
 	this	-> recorderVersion	= recorderVersion;
@@ -258,16 +260,6 @@ std::complex<float> cmul (std::complex<float> x, float y) {
 	}
 
 	iio_buffer_set_blocking_mode (rxbuf, true);
-//
-//	and set up interpolation table
-	float	divider		= (float)DIVIDER;
-	float	denominator	= DAB_RATE / divider;
-	for (int i = 0; i < DAB_RATE / DIVIDER; i ++) {
-           float inVal  = float (RX_RATE / divider);
-           mapTable_int [i]     =  int (floor (i * (inVal / denominator)));
-           mapTable_float [i]   = i * (inVal / denominator) - mapTable_int [i];
-        }
-        convIndex       = 0;
 
 	(void)  ad9361_set_bb_rate_custom_filter_manual (get_ad9361_phy (ctx),
 	                                                 RX_RATE,
@@ -278,10 +270,21 @@ std::complex<float> cmul (std::complex<float> x, float y) {
 	dumping. store (false);
 	xmlFile		= nullptr;
 	running. store (false);
+	theFrontEnd	= nullptr;
+	theCompact	= nullptr;
+	if (sampleMode == SAMPLES_FRONTEND)
+	   theFrontEnd	= new frontEnd (_I_Buffer, RX_RATE);
+	else
+	if (sampleMode == SAMPLES_COMPACT)	// resampled, so int16 with 2 bits extra
+	   theCompact	= new compactBuffer (DEVICE_BUFFER,
+	                                     compactBuffer::COMPACT_INT16,
+	                                     1 / 8192.0f);
 }
 
 	plutoHandler::~plutoHandler () {
 	stopReader ();
+	delete theFrontEnd;
+	delete theCompact;
 	iio_buffer_destroy (rxbuf);
 	iio_context_destroy (ctx);
 }
@@ -302,6 +305,10 @@ struct	iio_channel *lo_channel;
 	   return false;
 	}
 
+	if (theFrontEnd != nullptr)
+	   theFrontEnd -> reset ();
+	if (theCompact != nullptr)
+	   theCompact -> flush ();
 	threadHandle	= std::thread (&plutoHandler::run, this);
 	return true;
 }
@@ -315,43 +322,64 @@ void	plutoHandler::stopReader() {
 	threadHandle. join ();
 }
 
+//
+//	the samples of a buffer are resampled from RX_RATE to DAB_RATE,
+//	with only the I/Q pair per step they are converted in one go
 void	plutoHandler::run	() {
 char	*p_end, *p_dat;
 int	p_inc;
 int	nbytes_rx;
-std::complex<float> localBuf [DAB_RATE / DIVIDER];
-std::complex<int16_t> dumpBuffer [CONV_SIZE + 1];
+resampler	theResampler (RX_RATE, DAB_RATE);
+std::vector<std::complex<int16_t>>	rawBuffer;
+std::vector<std::complex<float>>	inBuffer;
+std::vector<std::complex<float>>	outBuffer;
 	running. store (true);
 	while (running. load ()) {
 	   nbytes_rx	= iio_buffer_refill	(rxbuf);
 	   p_inc	= iio_buffer_step	(rxbuf);
 	   p_end	= (char *)(iio_buffer_end  (rxbuf));
-
-	   for (p_dat = (char *)iio_buffer_first (rxbuf, rx0_i);
-	        p_dat < p_end; p_dat += p_inc) {
-	      const int16_t i_p = ((int16_t *)p_dat) [0];
-	      const int16_t q_p = ((int16_t *)p_dat) [1];
-	      std::complex<float>sample = std::complex<float> (i_p / 2048.0,
-	                                                       q_p / 2048.0);
-	      dumpBuffer [convIndex] = std::complex<int16_t> (i_p, q_p);
-	      convBuffer [convIndex ++] = sample;
-	      if (convIndex > CONV_SIZE) {
-	         if (dumping. load ())
-	            xmlWriter -> add (&dumpBuffer [1], CONV_SIZE);
-	         for (int j = 0; j < DAB_RATE / DIVIDER; j ++) {
-	            int16_t inpBase	= mapTable_int [j];
-	            float   inpRatio	= mapTable_float [j];
-	            localBuf [j]	= cmul (convBuffer [inpBase + 1],
-	                                                          inpRatio) +
-                                     cmul (convBuffer [inpBase], 1 - inpRatio);
-                 }
-
-	         _I_Buffer ->  putDataIntoBuffer (localBuf,
-	                                          DAB_RATE / DIVIDER);
-	         convBuffer [0] = convBuffer [CONV_SIZE];
-	         convIndex = 1;
-	      }
+	   p_dat	= (char *)iio_buffer_first (rxbuf, rx0_i);
+	   if ((nbytes_rx <= 0) || (p_inc <= 0))
+	      continue;
+
+	   int n	= (p_end - p_dat) / p_inc;
+	   if (n <= 0)
+	      continue;
+//	the front end reads the samples where they are
+	   if ((theFrontEnd != nullptr) &&
+	       (p_inc == (int)sizeof (std::complex<int16_t>))) {
+	      if (dumping. load ())
+	         xmlWriter -> add ((std::complex<int16_t> *)p_dat, n);
+	      theFrontEnd -> putInt16 ((int16_t *)p_dat, n, 1 / 2048.0f);
+	      continue;
+	   }
+	   if ((int)rawBuffer. size () < n) {
+	      rawBuffer. resize (n);
+	      inBuffer.  resize (n);
+	      outBuffer. resize (theResampler. maxOutput (n));
+	   }
+	   if (p_inc == (int)sizeof (std::complex<int16_t>))
+	      memcpy (rawBuffer. data (), p_dat, n * p_inc);
+	   else {
+	      for (int i = 0; i < n; i ++, p_dat += p_inc)
+	         rawBuffer [i] = std::complex<int16_t> (((int16_t *)p_dat) [0],
+	                                                ((int16_t *)p_dat) [1]);
+	   }
+	   if (dumping. load ())
+	      xmlWriter -> add (rawBuffer. data (), n);
+	   if (theFrontEnd != nullptr) {
+	      theFrontEnd -> putInt16 ((int16_t *)(rawBuffer. data ()),
+	                                                 n, 1 / 2048.0f);
+	      continue;
 	   }
+	   convert_int16 ((int16_t *)(rawBuffer. data ()),
+	                  inBuffer. data (), n, 1 / 2048.0f);
+	   int m	= theResampler. process (inBuffer. data (), n,
+	                                         outBuffer. data ());
+	   if (theCompact != nullptr)
+	      theCompact -> putFloat (outBuffer. data (), m);
+	   else
+	      _I_Buffer ->  putDataIntoBuffer (outBuffer. data (), m);
 	}
 }
 int16_t	plutoHandler::bitDepth		() {
@@ -31,6 +31,8 @@
 #include	"device-handler.h"
 
 class	xml_fileWriter;
+class	frontEnd;
+class	compactBuffer;
 
 #define	RX_RATE		2112000
 #define	DAB_RATE	2048000
@@ -51,7 +53,8 @@ public:
 	                                         const std::string &,
 	                                         int	frequency,
 	                                         int	gain,
-	                                         bool	agc);
+	                                         bool	agc,
+	                                         int	sampleMode = SAMPLES_FLOAT);
 	    		~plutoHandler		();
 	bool		restartReader		(int32_t);
 	void		stopReader		();
@@ -77,10 +80,6 @@ private:
 	struct	iio_buffer	*rxbuf;
 	struct	iio_buffer	*txbuf;
 	struct	stream_cfg	rx_cfg;
-	std::complex<float>	convBuffer	[CONV_SIZE + 1];
-	int			convIndex;
-	int16_t			mapTable_int	[DAB_RATE / DIVIDER];
-	float			mapTable_float	[DAB_RATE / DIVIDER];
 };
 #endif
 
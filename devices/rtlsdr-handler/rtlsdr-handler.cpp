@@ -28,7 +28,10 @@
 
 #include	"rtl-sdr.h"
 #include	"rtlsdr-handler.h"
-#include	"xml-filewriter.h"
+#include	"sample-recorder.h"
+#include	"sample-convert.h"
+#include	"front-end.h"
+#include	"compact-buffer.h"
 #include	<unistd.h>
 
 #ifdef	__MINGW32__
@@ -38,48 +41,38 @@
 #endif
 
 #define	READLEN_DEFAULT	8192
-//
-//	For the callback, we do need some environment which
-//	is passed through the ctx parameter
-//
-static 
-float convTable [] = {
- -128 / 128.0 , -127 / 128.0 , -126 / 128.0 , -125 / 128.0 , -124 / 128.0 , -123 / 128.0 , -122 / 128.0 , -121 / 128.0 , -120 / 128.0 , -119 / 128.0 , -118 / 128.0 , -117 / 128.0 , -116 / 128.0 , -115 / 128.0 , -114 / 128.0 , -113 / 128.0 
-, -112 / 128.0 , -111 / 128.0 , -110 / 128.0 , -109 / 128.0 , -108 / 128.0 , -107 / 128.0 , -106 / 128.0 , -105 / 128.0 , -104 / 128.0 , -103 / 128.0 , -102 / 128.0 , -101 / 128.0 , -100 / 128.0 , -99 / 128.0 , -98 / 128.0 , -97 / 128.0 
-, -96 / 128.0 , -95 / 128.0 , -94 / 128.0 , -93 / 128.0 , -92 / 128.0 , -91 / 128.0 , -90 / 128.0 , -89 / 128.0 , -88 / 128.0 , -87 / 128.0 , -86 / 128.0 , -85 / 128.0 , -84 / 128.0 , -83 / 128.0 , -82 / 128.0 , -81 / 128.0 
-, -80 / 128.0 , -79 / 128.0 , -78 / 128.0 , -77 / 128.0 , -76 / 128.0 , -75 / 128.0 , -74 / 128.0 , -73 / 128.0 , -72 / 128.0 , -71 / 128.0 , -70 / 128.0 , -69 / 128.0 , -68 / 128.0 , -67 / 128.0 , -66 / 128.0 , -65 / 128.0 
-, -64 / 128.0 , -63 / 128.0 , -62 / 128.0 , -61 / 128.0 , -60 / 128.0 , -59 / 128.0 , -58 / 128.0 , -57 / 128.0 , -56 / 128.0 , -55 / 128.0 , -54 / 128.0 , -53 / 128.0 , -52 / 128.0 , -51 / 128.0 , -50 / 128.0 , -49 / 128.0 
-, -48 / 128.0 , -47 / 128.0 , -46 / 128.0 , -45 / 128.0 , -44 / 128.0 , -43 / 128.0 , -42 / 128.0 , -41 / 128.0 , -40 / 128.0 , -39 / 128.0 , -38 / 128.0 , -37 / 128.0 , -36 / 128.0 , -35 / 128.0 , -34 / 128.0 , -33 / 128.0 
-, -32 / 128.0 , -31 / 128.0 , -30 / 128.0 , -29 / 128.0 , -28 / 128.0 , -27 / 128.0 , -26 / 128.0 , -25 / 128.0 , -24 / 128.0 , -23 / 128.0 , -22 / 128.0 , -21 / 128.0 , -20 / 128.0 , -19 / 128.0 , -18 / 128.0 , -17 / 128.0 
-, -16 / 128.0 , -15 / 128.0 , -14 / 128.0 , -13 / 128.0 , -12 / 128.0 , -11 / 128.0 , -10 / 128.0 , -9 / 128.0 , -8 / 128.0 , -7 / 128.0 , -6 / 128.0 , -5 / 128.0 , -4 / 128.0 , -3 / 128.0 , -2 / 128.0 , -1 / 128.0 
-, 0 / 128.0 , 1 / 128.0 , 2 / 128.0 , 3 / 128.0 , 4 / 128.0 , 5 / 128.0 , 6 / 128.0 , 7 / 128.0 , 8 / 128.0 , 9 / 128.0 , 10 / 128.0 , 11 / 128.0 , 12 / 128.0 , 13 / 128.0 , 14 / 128.0 , 15 / 128.0 
-, 16 / 128.0 , 17 / 128.0 , 18 / 128.0 , 19 / 128.0 , 20 / 128.0 , 21 / 128.0 , 22 / 128.0 , 23 / 128.0 , 24 / 128.0 , 25 / 128.0 , 26 / 128.0 , 27 / 128.0 , 28 / 128.0 , 29 / 128.0 , 30 / 128.0 , 31 / 128.0 
-, 32 / 128.0 , 33 / 128.0 , 34 / 128.0 , 35 / 128.0 , 36 / 128.0 , 37 / 128.0 , 38 / 128.0 , 39 / 128.0 , 40 / 128.0 , 41 / 128.0 , 42 / 128.0 , 43 / 128.0 , 44 / 128.0 , 45 / 128.0 , 46 / 128.0 , 47 / 128.0 
-, 48 / 128.0 , 49 / 128.0 , 50 / 128.0 , 51 / 128.0 , 52 / 128.0 , 53 / 128.0 , 54 / 128.0 , 55 / 128.0 , 56 / 128.0 , 57 / 128.0 , 58 / 128.0 , 59 / 128.0 , 60 / 128.0 , 61 / 128.0 , 62 / 128.0 , 63 / 128.0 
-, 64 / 128.0 , 65 / 128.0 , 66 / 128.0 , 67 / 128.0 , 68 / 128.0 , 69 / 128.0 , 70 / 128.0 , 71 / 128.0 , 72 / 128.0 , 73 / 128.0 , 74 / 128.0 , 75 / 128.0 , 76 / 128.0 , 77 / 128.0 , 78 / 128.0 , 79 / 128.0 
-, 80 / 128.0 , 81 / 128.0 , 82 / 128.0 , 83 / 128.0 , 84 / 128.0 , 85 / 128.0 , 86 / 128.0 , 87 / 128.0 , 88 / 128.0 , 89 / 128.0 , 90 / 128.0 , 91 / 128.0 , 92 / 128.0 , 93 / 128.0 , 94 / 128.0 , 95 / 128.0 
-, 96 / 128.0 , 97 / 128.0 , 98 / 128.0 , 99 / 128.0 , 100 / 128.0 , 101 / 128.0 , 102 / 128.0 , 103 / 128.0 , 104 / 128.0 , 105 / 128.0 , 106 / 128.0 , 107 / 128.0 , 108 / 128.0 , 109 / 128.0 , 110 / 128.0 , 111 / 128.0 
-, 112 / 128.0 , 113 / 128.0 , 114 / 128.0 , 115 / 128.0 , 116 / 128.0 , 117 / 128.0 , 118 / 128.0 , 119 / 128.0 , 120 / 128.0 , 121 / 128.0 , 122 / 128.0 , 123 / 128.0 , 124 / 128.0 , 125 / 128.0 , 126 / 128.0 , 127 / 128.0 };
 
 //	This is the user-side call back function
 //	ctx is the calling task
 static
 void	RTLSDRCallBack (uint8_t *buf, uint32_t len, void *ctx) {
 rtlsdrHandler	*theStick	= (rtlsdrHandler *)ctx;
-std::complex<float> localBuf [len / 2];
-std::complex<uint8_t> dumpBuf [len / 2];
+void	*data1, *data2;
+int32_t	size1, size2;
 	if ((theStick == NULL) || (len != READLEN_DEFAULT))
 	   return;
-
-	for (uint32_t i = 0; i < len / 2; i ++) {
-	   localBuf [i] = std::complex<float> (convTable [buf [2 * i]],
-	                                       convTable [buf [2 * i + 1]]);
-	   dumpBuf [i] = std::complex<uint8_t> (buf [2 * i], buf [2 * i + 1]);
-        }
-
-	if (theStick -> dumping. load ())
-	   theStick -> xmlWriter -> add (dumpBuf, len / 2);
-	(void) theStick -> _I_Buffer -> putDataIntoBuffer (localBuf, len / 2);
+	if (theStick -> getFrontEnd () != nullptr) {
+	   theStick -> getFrontEnd () -> putUint8 (buf, len / 2, 1 / 128.0f);
+	   return;
+	}
+	if (theStick -> getCompact () != nullptr) {
+	   theStick -> getCompact () -> putUint8 (buf, len / 2);
+	   return;
+	}
+//
+//	the samples are converted straight into the buffer, what does
+//	not fit is lost
+	int32_t n = theStick -> _I_Buffer ->
+	                    GetRingBufferWriteRegions (len / 2,
+	                                               &data1, &size1,
+	                                               &data2, &size2);
+	convert_uint8 (buf,
+	               static_cast<std::complex<float> *>(data1),
+	               size1, 1 / 128.0f);
+	convert_uint8 (buf + 2 * size1,
+	               static_cast<std::complex<float> *>(data2),
+	               size2, 1 / 128.0f);
+	theStick -> _I_Buffer -> AdvanceRingBufferWriteIndex (n);
 }
 //
 //	for handling the events in libusb, we need a controlthread
@@ -100,7 +93,8 @@ void	controlThread (rtlsdrHandler *theStick) {
 	                              int16_t	ppmCorrection,
 	                              int16_t	gain,
 	                              bool	autogain,	
-	                              uint16_t	deviceIndex):
+	                              uint16_t	deviceIndex,
+	                              int	sampleMode):
 	                                 deviceHandler (b){
 int16_t	deviceCount;
 int32_t	r;
@@ -116,6 +110,8 @@ int16_t	i;
 	this	-> deviceIndex	= deviceIndex;
 
 	inputRate		= 2048000;
+	theFrontEnd		= nullptr;
+	theCompact		= nullptr;
 	libraryLoaded		= false;
 	open			= false;
 	gains			= NULL;
@@ -197,6 +193,13 @@ int16_t	i;
 	rtlsdr_set_tuner_gain (device, gains [theGain * gainsCount / 100]);
 	dumping. store (false);
 	xmlFile		= nullptr;
+	if (sampleMode == SAMPLES_FRONTEND)
+	   theFrontEnd	= new frontEnd (_I_Buffer, inputRate);
+	else
+	if (sampleMode == SAMPLES_COMPACT)
+	   theCompact	= new compactBuffer (DEVICE_BUFFER,
+	                                     compactBuffer::COMPACT_INT8,
+	                                     1 / 128.0f);
 	running. store (false);
 }
 
@@ -205,6 +208,8 @@ int16_t	i;
 	   this -> rtlsdr_cancel_async (device);
 	   workerHandle. join ();
 	}
+	delete theFrontEnd;
+	delete theCompact;
 
 	running	= false;
 	if (open)
@@ -227,6 +232,10 @@ int32_t	r;
 	if (running)
 	   return true;
 	_I_Buffer	-> FlushRingBuffer ();
+	if (theFrontEnd != nullptr)
+	   theFrontEnd -> reset ();
+	if (theCompact != nullptr)
+	   theCompact -> flush ();
 	r = this -> rtlsdr_reset_buffer (device);
         if (r < 0)
            return false;
@@ -398,6 +407,10 @@ bool	rtlsdrHandler::load_rtlFunctions (void) {
 
 void	rtlsdrHandler::resetBuffer (void) {
 	_I_Buffer -> FlushRingBuffer ();
+	if (theFrontEnd != nullptr)
+	   theFrontEnd -> reset ();
+	if (theCompact != nullptr)
+	   theCompact -> flush ();
 }
 
 int16_t	rtlsdrHandler::bitDepth	(void) {
@@ -413,9 +426,13 @@ void	rtlsdrHandler::startDumping (const std::string & fileName) {
 	if (xmlFile == nullptr)
 	   return;
 	
-	xmlWriter	= new xml_fileWriter (xmlFile,
+//	the recorder follows the samples in the buffer, the callback
+//	does not see it
+	theRecorder	= new sampleRecorder (_I_Buffer,
+	                                      xmlFile,
 	                                      8,
 	                                      "uint8",
+	                                      128.0,
 	                                      2048000,
 	                                      frequency,
 	                                      "rtlsdr",
@@ -430,9 +447,7 @@ void	rtlsdrHandler::stopDumping () {
 	if (xmlFile == nullptr)	// cannot happen
 	   return;
 	dumping. store (false);
-	usleep (1000);
-	xmlWriter	-> print_xmlHeader ();
-	delete xmlWriter;
+	delete theRecorder;		// writes the header
 	fclose (xmlFile);
 	xmlFile		= nullptr;
 }
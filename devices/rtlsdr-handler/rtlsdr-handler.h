@@ -33,7 +33,9 @@
 #include	<stdio.h>
 
 class	dll_driver;
-class	xml_fileWriter;
+class	sampleRecorder;
+class	frontEnd;
+class	compactBuffer;
 typedef	void *HINSTANCE;
 
 #define	DUMP_SIZE	4096
@@ -77,7 +79,8 @@ public:
 	                                 int16_t	ppmCorrection,
 	                                 int16_t	gain,
 	                                 bool		autogain,
-	                                 uint16_t	deviceIndex = 0);
+	                                 uint16_t	deviceIndex = 0,
+	                                 int		sampleMode = SAMPLES_FLOAT);
 
 			~rtlsdrHandler	(void);
 //	interface to the reader
@@ -93,7 +96,7 @@ public:
 	RingBuffer<std::complex<float>>	*_I_Buffer;
 	pfnrtlsdr_read_async	rtlsdr_read_async;
 	struct rtlsdr_dev	*device;
-        xml_fileWriter  *xmlWriter;
+        sampleRecorder  *theRecorder;
         std::atomic<bool> dumping;
 private:
 	int32_t		inputRate;
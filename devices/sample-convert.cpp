@@ -0,0 +1,368 @@
+#
+/*
+ *    Copyright (C) 2020
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of channelScanner
+ *
+ *    channelScanner is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    channelScanner is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with channelScanner; if not, write to the Free Software
+ */
+#include	"sample-convert.h"
+#include	<string.h>
+#include	<atomic>
+
+#if defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))
+#define	CONVERT_X86
+#include	<immintrin.h>
+#elif defined(NEON_AVAILABLE) || defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define	CONVERT_NEON
+#include	<arm_neon.h>
+#endif
+
+typedef	void	(*u8Kernel)	(const uint8_t *, float *, int32_t, float);
+typedef	void	(*s8Kernel)	(const int8_t *, float *, int32_t, float);
+typedef	void	(*s16Kernel)	(const int16_t *, float *, int32_t, float);
+typedef	void	(*planarKernel)	(const int16_t *, const int16_t *,
+	                         float *, int32_t, float);
+
+class	convertKernels {
+public:
+	const char	*name;
+	u8Kernel	u8;
+	s8Kernel	s8;
+	s16Kernel	s16;
+	planarKernel	planar;
+};
+//
+//	the plain versions, also used for the tails. Here n is the
+//	number of floats (for planar: the number of complex samples)
+static
+void	u8_generic	(const uint8_t *in, float *out, int32_t n, float scale) {
+	for (int i = 0; i < n; i ++)
+	   out [i] = ((int)in [i] - 128) * scale;
+}
+
+static
+void	s8_generic	(const int8_t *in, float *out, int32_t n, float scale) {
+	for (int i = 0; i < n; i ++)
+	   out [i] = in [i] * scale;
+}
+
+static
+void	s16_generic	(const int16_t *in, float *out, int32_t n, float scale) {
+	for (int i = 0; i < n; i ++)
+	   out [i] = in [i] * scale;
+}
+
+static
+void	planar_generic	(const int16_t *re, const int16_t *im,
+	                 float *out, int32_t n, float scale) {
+	for (int i = 0; i < n; i ++) {
+	   out [2 * i]		= re [i] * scale;
+	   out [2 * i + 1]	= im [i] * scale;
+	}
+}
+
+#ifdef	CONVERT_X86
+static
+void	u8_sse2		(const uint8_t *in, float *out, int32_t n, float scale) {
+const __m128i zero	= _mm_setzero_si128 ();
+const __m128 off	= _mm_set1_ps (128.0f);
+const __m128 sc		= _mm_set1_ps (scale);
+int	i	= 0;
+	for (; i + 16 <= n; i += 16) {
+	   __m128i x	= _mm_loadu_si128 ((const __m128i *)(in + i));
+	   __m128i lo	= _mm_unpacklo_epi8 (x, zero);
+	   __m128i hi	= _mm_unpackhi_epi8 (x, zero);
+	   __m128 f0	= _mm_cvtepi32_ps (_mm_unpacklo_epi16 (lo, zero));
+	   __m128 f1	= _mm_cvtepi32_ps (_mm_unpackhi_epi16 (lo, zero));
+	   __m128 f2	= _mm_cvtepi32_ps (_mm_unpacklo_epi16 (hi, zero));
+	   __m128 f3	= _mm_cvtepi32_ps (_mm_unpackhi_epi16 (hi, zero));
+	   _mm_storeu_ps (out + i,      _mm_mul_ps (_mm_sub_ps (f0, off), sc));
+	   _mm_storeu_ps (out + i + 4,  _mm_mul_ps (_mm_sub_ps (f1, off), sc));
+	   _mm_storeu_ps (out + i + 8,  _mm_mul_ps (_mm_sub_ps (f2, off), sc));
+	   _mm_storeu_ps (out + i + 12, _mm_mul_ps (_mm_sub_ps (f3, off), sc));
+	}
+	u8_generic (in + i, out + i, n - i, scale);
+}
+//
+//	sign extension: unpack a value with itself and shift it back
+static
+void	s8_sse2		(const int8_t *in, float *out, int32_t n, float scale) {
+const __m128 sc		= _mm_set1_ps (scale);
+int	i	= 0;
+	for (; i + 16 <= n; i += 16) {
+	   __m128i x	= _mm_loadu_si128 ((const __m128i *)(in + i));
+	   __m128i lo	= _mm_srai_epi16 (_mm_unpacklo_epi8 (x, x), 8);
+	   __m128i hi	= _mm_srai_epi16 (_mm_unpackhi_epi8 (x, x), 8);
+	   __m128i v [4];
+	   v [0] = _mm_srai_epi32 (_mm_unpacklo_epi16 (lo, lo), 16);
+	   v [1] = _mm_srai_epi32 (_mm_unpackhi_epi16 (lo, lo), 16);
+	   v [2] = _mm_srai_epi32 (_mm_unpacklo_epi16 (hi, hi), 16);
+	   v [3] = _mm_srai_epi32 (_mm_unpackhi_epi16 (hi, hi), 16);
+	   for (int k = 0; k < 4; k ++)
+	      _mm_storeu_ps (out + i + 4 * k,
+	                     _mm_mul_ps (_mm_cvtepi32_ps (v [k]), sc));
+	}
+	s8_generic (in + i, out + i, n - i, scale);
+}
+
+static
+void	s16_sse2	(const int16_t *in, float *out, int32_t n, float scale) {
+const __m128 sc		= _mm_set1_ps (scale);
+int	i	= 0;
+	for (; i + 8 <= n; i += 8) {
+	   __m128i x	= _mm_loadu_si128 ((const __m128i *)(in + i));
+	   __m128i lo	= _mm_srai_epi32 (_mm_unpacklo_epi16 (x, x), 16);
+	   __m128i hi	= _mm_srai_epi32 (_mm_unpackhi_epi16 (x, x), 16);
+	   _mm_storeu_ps (out + i,     _mm_mul_ps (_mm_cvtepi32_ps (lo), sc));
+	   _mm_storeu_ps (out + i + 4, _mm_mul_ps (_mm_cvtepi32_ps (hi), sc));
+	}
+	s16_generic (in + i, out + i, n - i, scale);
+}
+
+static
+void	planar_sse2	(const int16_t *re, const int16_t *im,
+	                 float *out, int32_t n, float scale) {
+const __m128 sc		= _mm_set1_ps (scale);
+int	i	= 0;
+	for (; i + 4 <= n; i += 4) {
+	   __m128i r	= _mm_loadl_epi64 ((const __m128i *)(re + i));
+	   __m128i q	= _mm_loadl_epi64 ((const __m128i *)(im + i));
+	   __m128 fr	= _mm_mul_ps (_mm_cvtepi32_ps (
+	                     _mm_srai_epi32 (_mm_unpacklo_epi16 (r, r), 16)), sc);
+	   __m128 fq	= _mm_mul_ps (_mm_cvtepi32_ps (
+	                     _mm_srai_epi32 (_mm_unpacklo_epi16 (q, q), 16)), sc);
+	   _mm_storeu_ps (out + 2 * i,     _mm_unpacklo_ps (fr, fq));
+	   _mm_storeu_ps (out + 2 * i + 4, _mm_unpackhi_ps (fr, fq));
+	}
+	planar_generic (re + i, im + i, out + 2 * i, n - i, scale);
+}
+//
+//	the AVX2 versions are compiled for AVX2 whatever the flags,
+//	and only used when the processor says it has AVX2
+#define	AVX2	__attribute__ ((target ("avx2")))
+AVX2 static
+void	u8_avx2		(const uint8_t *in, float *out, int32_t n, float scale) {
+const __m256 off	= _mm256_set1_ps (128.0f);
+const __m256 sc		= _mm256_set1_ps (scale);
+int	i	= 0;
+	for (; i + 32 <= n; i += 32) {
+	   for (int k = 0; k < 4; k ++) {
+	      __m128i x	= _mm_loadl_epi64 ((const __m128i *)(in + i + 8 * k));
+	      __m256 f	= _mm256_cvtepi32_ps (_mm256_cvtepu8_epi32 (x));
+	      _mm256_storeu_ps (out + i + 8 * k,
+	                        _mm256_mul_ps (_mm256_sub_ps (f, off), sc));
+	   }
+	}
+	u8_sse2 (in + i, out + i, n - i, scale);
+}
+
+AVX2 static
+void	s8_avx2		(const int8_t *in, float *out, int32_t n, float scale) {
+const __m256 sc		= _mm256_set1_ps (scale);
+int	i	= 0;
+	for (; i + 32 <= n; i += 32) {
+	   for (int k = 0; k < 4; k ++) {
+	      __m128i x	= _mm_loadl_epi64 ((const __m128i *)(in + i + 8 * k));
+	      __m256 f	= _mm256_cvtepi32_ps (_mm256_cvtepi8_epi32 (x));
+	      _mm256_storeu_ps (out + i + 8 * k, _mm256_mul_ps (f, sc));
+	   }
+	}
+	s8_sse2 (in + i, out + i, n - i, scale);
+}
+
+AVX2 static
+void	s16_avx2	(const int16_t *in, float *out, int32_t n, float scale) {
+const __m256 sc		= _mm256_set1_ps (scale);
+int	i	= 0;
+	for (; i + 16 <= n; i += 16) {
+	   __m128i x0	= _mm_loadu_si128 ((const __m128i *)(in + i));
+	   __m128i x1	= _mm_loadu_si128 ((const __m128i *)(in + i + 8));
+	   __m256 f0	= _mm256_cvtepi32_ps (_mm256_cvtepi16_epi32 (x0));
+	   __m256 f1	= _mm256_cvtepi32_ps (_mm256_cvtepi16_epi32 (x1));
+	   _mm256_storeu_ps (out + i,     _mm256_mul_ps (f0, sc));
+	   _mm256_storeu_ps (out + i + 8, _mm256_mul_ps (f1, sc));
+	}
+	s16_sse2 (in + i, out + i, n - i, scale);
+}
+//
+//	unpack works within the 128 bit halves, the permutes put the
+//	halves in order again
+AVX2 static
+void	planar_avx2	(const int16_t *re, const int16_t *im,
+	                 float *out, int32_t n, float scale) {
+const __m256 sc		= _mm256_set1_ps (scale);
+int	i	= 0;
+	for (; i + 8 <= n; i += 8) {
+	   __m256 fr	= _mm256_mul_ps (_mm256_cvtepi32_ps (_mm256_cvtepi16_epi32 (
+	                     _mm_loadu_si128 ((const __m128i *)(re + i)))), sc);
+	   __m256 fq	= _mm256_mul_ps (_mm256_cvtepi32_ps (_mm256_cvtepi16_epi32 (
+	                     _mm_loadu_si128 ((const __m128i *)(im + i)))), sc);
+	   __m256 lo	= _mm256_unpacklo_ps (fr, fq);
+	   __m256 hi	= _mm256_unpackhi_ps (fr, fq);
+	   _mm256_storeu_ps (out + 2 * i,
+	                     _mm256_permute2f128_ps (lo, hi, 0x20));
+	   _mm256_storeu_ps (out + 2 * i + 8,
+	                     _mm256_permute2f128_ps (lo, hi, 0x31));
+	}
+	planar_sse2 (re + i, im + i, out + 2 * i, n - i, scale);
+}
+#endif
+
+#ifdef	CONVERT_NEON
+static
+void	u8_neon		(const uint8_t *in, float *out, int32_t n, float scale) {
+const float32x4_t off	= vdupq_n_f32 (128.0f);
+int	i	= 0;
+	for (; i + 8 <= n; i += 8) {
+	   uint16x8_t x	= vmovl_u8 (vld1_u8 (in + i));
+	   float32x4_t f0 = vcvtq_f32_u32 (vmovl_u16 (vget_low_u16 (x)));
+	   float32x4_t f1 = vcvtq_f32_u32 (vmovl_u16 (vget_high_u16 (x)));
+	   vst1q_f32 (out + i,     vmulq_n_f32 (vsubq_f32 (f0, off), scale));
+	   vst1q_f32 (out + i + 4, vmulq_n_f32 (vsubq_f32 (f1, off), scale));
+	}
+	u8_generic (in + i, out + i, n - i, scale);
+}
+
+static
+void	s8_neon		(const int8_t *in, float *out, int32_t n, float scale) {
+int	i	= 0;
+	for (; i + 8 <= n; i += 8) {
+	   int16x8_t x	= vmovl_s8 (vld1_s8 (in + i));
+	   float32x4_t f0 = vcvtq_f32_s32 (vmovl_s16 (vget_low_s16 (x)));
+	   float32x4_t f1 = vcvtq_f32_s32 (vmovl_s16 (vget_high_s16 (x)));
+	   vst1q_f32 (out + i,     vmulq_n_f32 (f0, scale));
+	   vst1q_f32 (out + i + 4, vmulq_n_f32 (f1, scale));
+	}
+	s8_generic (in + i, out + i, n - i, scale);
+}
+
+static
+void	s16_neon	(const int16_t *in, float *out, int32_t n, float scale) {
+int	i	= 0;
+	for (; i + 8 <= n; i += 8) {
+	   int16x8_t x	= vld1q_s16 (in + i);
+	   float32x4_t f0 = vcvtq_f32_s32 (vmovl_s16 (vget_low_s16 (x)));
+	   float32x4_t f1 = vcvtq_f32_s32 (vmovl_s16 (vget_high_s16 (x)));
+	   vst1q_f32 (out + i,     vmulq_n_f32 (f0, scale));
+	   vst1q_f32 (out + i + 4, vmulq_n_f32 (f1, scale));
+	}
+	s16_generic (in + i, out + i, n - i, scale);
+}
+//
+//	vst2 does the interleaving
+static
+void	planar_neon	(const int16_t *re, const int16_t *im,
+	                 float *out, int32_t n, float scale) {
+int	i	= 0;
+	for (; i + 4 <= n; i += 4) {
+	   float32x4x2_t v;
+	   v. val [0] = vmulq_n_f32 (vcvtq_f32_s32 (vmovl_s16 (vld1_s16 (re + i))),
+	                             scale);
+	   v. val [1] = vmulq_n_f32 (vcvtq_f32_s32 (vmovl_s16 (vld1_s16 (im + i))),
+	                             scale);
+	   vst2q_f32 (out + 2 * i, v);
+	}
+	planar_generic (re + i, im + i, out + 2 * i, n - i, scale);
+}
+#endif
+
+static const convertKernels genericKernels =
+	{"generic", u8_generic, s8_generic, s16_generic, planar_generic};
+#ifdef	CONVERT_X86
+static const convertKernels sse2Kernels =
+	{"sse2", u8_sse2, s8_sse2, s16_sse2, planar_sse2};
+static const convertKernels avx2Kernels =
+	{"avx2", u8_avx2, s8_avx2, s16_avx2, planar_avx2};
+#endif
+#ifdef	CONVERT_NEON
+static const convertKernels neonKernels =
+	{"neon", u8_neon, s8_neon, s16_neon, planar_neon};
+#endif
+
+static
+const convertKernels *bestKernels	() {
+#ifdef	CONVERT_X86
+	__builtin_cpu_init ();
+	if (__builtin_cpu_supports ("avx2"))
+	   return &avx2Kernels;
+	return &sse2Kernels;
+#elif	defined (CONVERT_NEON)
+	return &neonKernels;
+#else
+	return &genericKernels;
+#endif
+}
+//
+//	picked once, on first use
+static
+std::atomic<const convertKernels *> &kernels	() {
+static std::atomic<const convertKernels *> theKernels (bestKernels ());
+	return theKernels;
+}
+
+void	convert_uint8	(const uint8_t *in, std::complex<float> *out,
+	                 int32_t n, float scale) {
+	kernels (). load (std::memory_order_relaxed) ->
+	          u8 (in, reinterpret_cast<float *>(out), 2 * n, scale);
+}
+
+void	convert_int8	(const int8_t *in, std::complex<float> *out,
+	                 int32_t n, float scale) {
+	kernels (). load (std::memory_order_relaxed) ->
+	          s8 (in, reinterpret_cast<float *>(out), 2 * n, scale);
+}
+
+void	convert_int16	(const int16_t *in, std::complex<float> *out,
+	                 int32_t n, float scale) {
+	kernels (). load (std::memory_order_relaxed) ->
+	          s16 (in, reinterpret_cast<float *>(out), 2 * n, scale);
+}
+
+void	convert_int16_planar	(const int16_t *re, const int16_t *im,
+	                         std::complex<float> *out,
+	                         int32_t n, float scale) {
+	kernels (). load (std::memory_order_relaxed) ->
+	          planar (re, im, reinterpret_cast<float *>(out), n, scale);
+}
+
+const char *convert_variant	() {
+	return kernels (). load () -> name;
+}
+
+bool	convert_select	(const char *name) {
+const convertKernels *k	= nullptr;
+	if (name == nullptr) {
+	   kernels (). store (bestKernels ());
+	   return true;
+	}
+	if (strcmp (name, "generic") == 0)
+	   k	= &genericKernels;
+#ifdef	CONVERT_X86
+	if (strcmp (name, "sse2") == 0)
+	   k	= &sse2Kernels;
+	if ((strcmp (name, "avx2") == 0) && (bestKernels () == &avx2Kernels))
+	   k	= &avx2Kernels;
+#endif
+#ifdef	CONVERT_NEON
+	if (strcmp (name, "neon") == 0)
+	   k	= &neonKernels;
+#endif
+	if (k == nullptr)
+	   return false;
+	kernels (). store (k);
+	return true;
+}
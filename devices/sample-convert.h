@@ -0,0 +1,53 @@
+#
+/*
+ *    Copyright (C) 2020
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of channelScanner
+ *
+ *    channelScanner is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    channelScanner is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with channelScanner; if not, write to the Free Software
+ *
+ *	Conversion of the integer samples of the devices to
+ *	std::complex<float>, the value written is (x - offset) * scale,
+ *	offset being 128 for uint8 and 0 otherwise.
+ *	12 bit devices (airspy, pluto) deliver their samples in an int16
+ *	container, for them the int16 conversion (scale 1 / 2048) is used.
+ *	The kernels are picked when first used: AVX2 when the processor
+ *	has it, otherwise SSE2 (x86) or NEON (arm), otherwise plain C++.
+ */
+#ifndef	__SAMPLE_CONVERT__
+#define	__SAMPLE_CONVERT__
+
+#include	<stdint.h>
+#include	<complex>
+
+//	n is the number of complex samples, i.e. 2 * n input values
+void	convert_uint8		(const uint8_t *, std::complex<float> *,
+	                         int32_t n, float scale);
+void	convert_int8		(const int8_t *, std::complex<float> *,
+	                         int32_t n, float scale);
+void	convert_int16		(const int16_t *, std::complex<float> *,
+	                         int32_t n, float scale);
+//	I and Q in separate arrays (sdrplay)
+void	convert_int16_planar	(const int16_t *, const int16_t *,
+	                         std::complex<float> *,
+	                         int32_t n, float scale);
+//	the kernels in use, "avx2", "sse2", "neon" or "generic"
+const char *convert_variant	();
+//	force a variant (for testing and benchmarking), false if the
+//	variant is not available here, nullptr restores the default
+bool	convert_select		(const char *);
+#endif
+
@@ -0,0 +1,119 @@
+#
+/*
+ *    Copyright (C) 2020
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of channelScanner
+ *
+ *    channelScanner is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    channelScanner is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with channelScanner; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#include	"sample-recorder.h"
+#include	"xml-filewriter.h"
+#include	<math.h>
+
+#define	RECORDER_BLOCK	32768
+
+static inline
+int	clamp	(float v, int low, int high) {
+int	x	= (int)lrintf (v);
+	return x < low ? low : x > high ? high : x;
+}
+
+	sampleRecorder::sampleRecorder	(RingBuffer<std::complex<float>> *b,
+	                                 FILE		*f,
+	                                 int		nrBits,
+	                                 const std::string &container,
+	                                 float		scale,
+	                                 int		sampleRate,
+	                                 int		frequency,
+	                                 const std::string &deviceName,
+	                                 const std::string &deviceModel,
+	                                 const std::string &recorderVersion):
+	                                    theTap (b),
+	                                    inBuf (RECORDER_BLOCK),
+	                                    outBuf (RECORDER_BLOCK) {
+	theWriter	= new xml_fileWriter (f, nrBits, container,
+	                                      sampleRate, frequency,
+	                                      deviceName, deviceModel,
+	                                      recorderVersion);
+	this -> container	= container;
+	this -> scale		= scale;
+	running. store (true);
+	threadHandle	= std::thread (&sampleRecorder::run, this);
+}
+
+	sampleRecorder::~sampleRecorder	() {
+	running. store (false);
+	if (threadHandle. joinable ())
+	   threadHandle. join ();
+	fprintf (stderr, "recorder: %lld samples written, %lld lost, max lag %lld\n",
+	                 (long long)theTap. deliveredSamples (),
+	                 (long long)theTap. lostSamples (),
+	                 (long long)theTap. maximumLag ());
+	delete theWriter;		// writes the header
+}
+
+int64_t	sampleRecorder::lostSamples	() {
+	return theTap. lostSamples ();
+}
+//
+//	what is in the buffer when we are stopped is still written
+void	sampleRecorder::run	() {
+	while (true) {
+	   bool stopping	= !running. load ();
+	   int32_t n	= theTap. getDataFromBuffer (inBuf. data (),
+	                                             RECORDER_BLOCK);
+	   if (n > 0) {
+	      write (n);
+	      continue;
+	   }
+	   if (stopping && (theTap. available () == 0))
+	      break;
+	   if (theTap. available () == 0)
+	      (void)theTap. waitForData (RECORDER_BLOCK, 100);
+	}
+}
+
+void	sampleRecorder::write	(int32_t n) {
+//	outBuf has room for the widest container type
+	if (container == "uint8") {
+	   std::complex<uint8_t> *v	=
+	              reinterpret_cast<std::complex<uint8_t> *>(outBuf. data ());
+	   for (int i = 0; i < n; i ++)
+	      v [i] = std::complex<uint8_t> (
+	                 clamp (real (inBuf [i]) * scale + 128, 0, 255),
+	                 clamp (imag (inBuf [i]) * scale + 128, 0, 255));
+	   theWriter -> add (v, n);
+	}
+	else
+	if (container == "int8") {
+	   std::complex<int8_t> *v	=
+	              reinterpret_cast<std::complex<int8_t> *>(outBuf. data ());
+	   for (int i = 0; i < n; i ++)
+	      v [i] = std::complex<int8_t> (
+	                 clamp (real (inBuf [i]) * scale, -128, 127),
+	                 clamp (imag (inBuf [i]) * scale, -128, 127));
+	   theWriter -> add (v, n);
+	}
+	else {
+	   std::complex<int16_t> *v	= outBuf. data ();
+	   for (int i = 0; i < n; i ++)
+	      v [i] = std::complex<int16_t> (
+	                 clamp (real (inBuf [i]) * scale, -32768, 32767),
+	                 clamp (imag (inBuf [i]) * scale, -32768, 32767));
+	   theWriter -> add (v, n);
+	}
+}
@@ -0,0 +1,73 @@
+#
+/*
+ *    Copyright (C) 2020
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of channelScanner
+ *
+ *    channelScanner is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    channelScanner is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with channelScanner; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *	The sampleRecorder writes the samples of a device to an xml
+ *	file. It does not run in the device callback, it follows the
+ *	samples in the ringbuffer through a tap of its own, converts them
+ *	back to the integer type of the device and writes them.
+ *	If it cannot keep up, the lost samples are counted and reported.
+ */
+#ifndef	__SAMPLE_RECORDER__
+#define	__SAMPLE_RECORDER__
+
+#include	<stdio.h>
+#include	<stdint.h>
+#include	<string>
+#include	<vector>
+#include	<complex>
+#include	<thread>
+#include	<atomic>
+#include	"ringbuffer.h"
+
+class	xml_fileWriter;
+
+class	sampleRecorder {
+public:
+//	the container is one of "int16", "int8" or "uint8", the samples
+//	in the buffer are multiplied by scale (and for uint8 shifted
+//	by 128) to get the device values back
+		sampleRecorder	(RingBuffer<std::complex<float>> *,
+	                         FILE		*f,
+	                         int		nrBits,
+	                         const std::string &container,
+	                         float		scale,
+	                         int		sampleRate,
+	                         int		frequency,
+	                         const std::string &deviceName,
+	                         const std::string &deviceModel,
+	                         const std::string &recorderVersion);
+		~sampleRecorder	();
+	int64_t	lostSamples	();
+private:
+	ringTap<std::complex<float>>	theTap;
+	xml_fileWriter	*theWriter;
+	std::string	container;
+	float		scale;
+	std::atomic<bool>	running;
+	std::thread	threadHandle;
+	std::vector<std::complex<float>>	inBuf;
+	std::vector<std::complex<int16_t>>	outBuf;
+	void		run		();
+	void		write		(int32_t);
+};
+#endif
+
@@ -22,7 +22,10 @@
  */
 
 #include	"sdrplay-handler.h"
-#include	"xml-filewriter.h"
+#include	"sample-recorder.h"
+#include	"sample-convert.h"
+#include	"front-end.h"
+#include	"compact-buffer.h"
 #include	<unistd.h>
 
 	sdrplayHandler::sdrplayHandler  (RingBuffer<std::complex<float>> *b,
@@ -33,7 +36,8 @@
 	                                 int16_t	lnaState,
 	                                 bool		autoGain,
 	                                 uint16_t	deviceIndex,
-	                                 int16_t	antenna):
+	                                 int16_t	antenna,
+	                                 int		sampleMode):
 	                                    deviceHandler (b) {
 int	err;
 float	ver;
@@ -124,10 +128,21 @@ int	maxlna;
 	dumping. store (false);
 	xmlFile		= nullptr;
 	running. store (false);
+	theFrontEnd	= nullptr;
+	theCompact	= nullptr;
+	if (sampleMode == SAMPLES_FRONTEND)
+	   theFrontEnd	= new frontEnd (_I_Buffer, inputRate);
+	else
+	if (sampleMode == SAMPLES_COMPACT)
+	   theCompact	= new compactBuffer (DEVICE_BUFFER,
+	                                     compactBuffer::COMPACT_INT16,
+	                                     1 / denominator);
 }
 
 	sdrplayHandler::~sdrplayHandler	(void) {
 	stopReader ();
+	delete theFrontEnd;
+	delete theCompact;
 	if (numofDevs > 0)
 	   mir_sdr_ReleaseDeviceIdx ();
 }
@@ -143,22 +158,32 @@ void myStreamCallback (int16_t		*xi,
 	               uint32_t		reset,
 	               uint32_t		hwRemoved,
 	               void		*cbContext) {
-int16_t	i;
 sdrplayHandler	*p	= static_cast<sdrplayHandler *> (cbContext);
-std::complex<float> localBuf [numSamples];
-std::complex<int16_t> dumpBuf [numSamples];
-float	denominator		= p -> denominator;
+float	scale		= 1 / p -> denominator;
+void	*data1, *data2;
+int32_t	size1, size2;
 
 	if (reset || hwRemoved)
 	   return;
-	for (i = 0; i <  (int)numSamples; i ++) {
-	   localBuf [i] = std::complex<float> (float (xi [i]) / denominator,
-	                                       float (xq [i]) / denominator);
-	   dumpBuf  [i] = std::complex<int16_t> (xi [i], xq [i]);
+	if (p -> getFrontEnd () != nullptr) {
+	   p -> getFrontEnd () -> putInt16 (xi, xq, numSamples, scale);
+	   return;
+	}
+	if (p -> getCompact () != nullptr) {
+	   p -> getCompact () -> putInt16 (xi, xq, numSamples);
+	   return;
 	}
-	if (p -> dumping. load ())
-	   p -> xmlWriter -> add (dumpBuf, numSamples);
-	p -> _I_Buffer -> putDataIntoBuffer (localBuf, numSamples);
+//	converted straight into the buffer, what does not fit is lost
+	int32_t n = p -> _I_Buffer -> GetRingBufferWriteRegions (numSamples,
+	                                                  &data1, &size1,
+	                                                  &data2, &size2);
+	convert_int16_planar (xi, xq,
+	                      static_cast<std::complex<float> *>(data1),
+	                      size1, scale);
+	convert_int16_planar (xi + size1, xq + size1,
+	                      static_cast<std::complex<float> *>(data2),
+	                      size2, scale);
+	p -> _I_Buffer -> AdvanceRingBufferWriteIndex (n);
 	(void)	firstSampleNum;
 	(void)	grChanged;
 	(void)	rfChanged;
@@ -184,6 +209,10 @@ int	localGRed	= GRdB;
 	   return true;
 
 	this	-> frequency = frequency;
+	if (theFrontEnd != nullptr)
+	   theFrontEnd -> reset ();
+	if (theCompact != nullptr)
+	   theCompact -> flush ();
 	err	= mir_sdr_StreamInit (&localGRed,
 	                              double (inputRate) / 1000000.0,
 	                              double (frequency) / 1000000.0,
@@ -230,9 +259,11 @@ void	sdrplayHandler::startDumping	(const std::string &fileName) {
 	if (xmlFile == nullptr)
 	   return;
 	
-	xmlWriter	= new xml_fileWriter (xmlFile,
+	theRecorder	= new sampleRecorder (_I_Buffer,
+	                                      xmlFile,
 	                                      nrBits,
 	                                      "int16",
+	                                      denominator,
 	                                      2048000,
 	                                      frequency,
 	                                      "SDRplay",
@@ -247,9 +278,7 @@ void	sdrplayHandler::stopDumping	() {
 	if (xmlFile == nullptr)	// this can happen !!
 	   return;
 	dumping. store (false);
-	usleep (1000);
-	xmlWriter	-> print_xmlHeader ();
-	delete xmlWriter;
+	delete theRecorder;		// writes the header
 	fclose (xmlFile);
 	xmlFile		= nullptr;
 }
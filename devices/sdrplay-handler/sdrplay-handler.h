@@ -31,7 +31,9 @@
 #include	"device-handler.h"
 #include	"mirsdrapi-rsp.h"
 
-class	xml_fileWriter;
+class	sampleRecorder;
+class	frontEnd;
+class	compactBuffer;
 
 #define	DUMP_SIZE	4096
 typedef void (*mir_sdr_StreamCallback_t)(int16_t	*xi,
@@ -59,7 +61,8 @@ public:
 	                                 int16_t	lnaState,
 	                                 bool		autogain,
 	                                 uint16_t       deviceIndex,
-	                                 int16_t        antenna);
+	                                 int16_t        antenna,
+	                                 int		sampleMode = SAMPLES_FLOAT);
 
 		~sdrplayHandler		(void);
 
@@ -73,7 +76,7 @@ public:
 //	within the callback
 	RingBuffer<std::complex<float>>	*_I_Buffer;
 	float		denominator;
-        xml_fileWriter  *xmlWriter;
+        sampleRecorder  *theRecorder;
         std::atomic<bool> dumping;
 private:
 	std::string	recorderVersion;
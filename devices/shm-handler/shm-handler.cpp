@@ -0,0 +1,113 @@
+#
+/*
+ *    Copyright (C) 2020
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of channelScanner
+ *
+ *    channelScanner is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    channelScanner is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with channelScanner; if not, write to the Free Software
+ */
+#include	"shm-handler.h"
+#include	"shm-ring.h"
+#include	<stdio.h>
+#include	<unistd.h>
+#include	<vector>
+
+#define	SHM_BLOCK	8192
+
+	shmDeviceHandler::shmDeviceHandler (RingBuffer<std::complex<float>> *b,
+	                                    const std::string &name):
+	                                         deviceHandler (b) {
+	theRing		= new shmRing (name);	// throws if not there
+	lost. store (0);
+	running. store (false);
+	atEnd. store (false);
+	fprintf (stderr, "attached to %s, %d bits, frequency %d\n",
+	                  theRing -> name (). c_str (),
+	                  theRing -> bitDepth (), theRing -> frequency ());
+}
+
+	shmDeviceHandler::~shmDeviceHandler () {
+	stopReader ();
+	delete theRing;
+}
+//
+//	we start with the samples written from now on
+bool	shmDeviceHandler::restartReader	(int32_t frequency) {
+	if (running. load () && !atEnd. load ())
+	   return true;
+	stopReader ();
+	if (frequency != theRing -> frequency ())
+	   fprintf (stderr, "the stream is at %d, not at %d\n",
+	                     theRing -> frequency (), frequency);
+	cursor		= theRing -> position ();
+	atEnd. store (false);
+	running. store (true);
+	threadHandle	= std::thread (&shmDeviceHandler::run, this);
+	return true;
+}
+
+void	shmDeviceHandler::stopReader	() {
+	if (!running. load ())
+	   return;
+	running. store (false);
+	_I_Buffer -> WakeAll ();
+	if (threadHandle. joinable ())
+	   threadHandle. join ();
+}
+
+int16_t	shmDeviceHandler::bitDepth	() {
+	return theRing -> bitDepth ();
+}
+
+bool	shmDeviceHandler::endReached	() {
+	return atEnd. load ();
+}
+
+std::string	shmDeviceHandler::deviceName	() {
+	return "shm " + theRing -> name ();
+}
+
+int64_t	shmDeviceHandler::lostSamples	() {
+	return lost. load ();
+}
+//
+//	a reader that lags too much loses samples, the publisher does
+//	not wait for us. Here we do wait for room in our own buffer
+void	shmDeviceHandler::run	() {
+std::vector<std::complex<float>> localBuf (SHM_BLOCK);
+int64_t	lostHere	= 0;
+
+	while (running. load ()) {
+	   int32_t n	= theRing -> get (&cursor, localBuf. data (),
+	                                  SHM_BLOCK, &lostHere);
+	   lost. store (lostHere);
+	   if (n == 0) {
+	      if (!theRing -> alive () &&
+	          (theRing -> position () == cursor)) {
+	         atEnd. store (true);
+	         break;
+	      }
+	      usleep (1000);
+	      continue;
+	   }
+	   while (running. load () &&
+	          !_I_Buffer -> WaitForWriteAvailable (n, 10));
+	   _I_Buffer -> putDataIntoBuffer (localBuf. data (), n);
+	}
+	if (lostHere > 0)
+	   fprintf (stderr, "%s: %lld samples lost\n",
+	                    theRing -> name (). c_str (), (long long)lostHere);
+}
@@ -0,0 +1,60 @@
+#
+/*
+ *    Copyright (C) 2020
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of channelScanner
+ *
+ *    channelScanner is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    channelScanner is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with channelScanner; if not, write to the Free Software
+ *
+ *	The shmDeviceHandler takes its samples from the shared memory
+ *	stream published by another channelScanner (option -Z), so more
+ *	scanners and analyzers can run on the stream of a single device.
+ *	The device is tuned by the publishing process, a request for
+ *	another frequency is reported, not obeyed.
+ */
+#ifndef	__SHM_HANDLER__
+#define	__SHM_HANDLER__
+
+#include	<atomic>
+#include	<thread>
+#include	<string>
+#include	"ringbuffer.h"
+#include	"device-handler.h"
+
+class	shmRing;
+
+class	shmDeviceHandler: public deviceHandler {
+public:
+			shmDeviceHandler (RingBuffer<std::complex<float>> *,
+	                                  const std::string &);
+			~shmDeviceHandler ();
+	bool		restartReader	(int32_t);
+	void		stopReader	();
+	int16_t		bitDepth	();
+	bool		endReached	();
+	std::string	deviceName	();
+	int64_t		lostSamples	();
+private:
+	shmRing		*theRing;
+	uint64_t	cursor;
+	std::atomic<int64_t>	lost;
+	std::thread	threadHandle;
+	std::atomic<bool>	running;
+	std::atomic<bool>	atEnd;
+	void		run		();
+};
+#endif
+
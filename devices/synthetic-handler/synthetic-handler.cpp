@@ -0,0 +1,107 @@
+#
+/*
+ *    Copyright (C) 2020
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of channelScanner
+ *
+ *    channelScanner is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    channelScanner is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with channelScanner; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include	"synthetic-handler.h"
+#include	<unistd.h>
+#include	<vector>
+#include	<chrono>
+
+#define	BLOCK_SIZE	2048
+
+	syntheticHandler::syntheticHandler (RingBuffer<std::complex<float>> *b,
+	                                    uint8_t	dabMode,
+	                                    int32_t	nrFrames,
+	                                    bool	paced):
+	                                       deviceHandler (b),
+	                                       theTransmitter (dabMode,
+	                                                 defaultEnsemble ()) {
+	this	-> nrFrames	= nrFrames;
+	this	-> paced	= paced;
+	running. store (false);
+	atEnd.   store (false);
+}
+
+	syntheticHandler::~syntheticHandler () {
+	stopReader ();
+}
+//
+//	each restart starts a fresh transmission, the frequency
+//	is irrelevant
+bool	syntheticHandler::restartReader	(int32_t freq) {
+	(void)freq;
+	if (running. load ())
+	   return true;
+	if (threadHandle. joinable ())
+	   threadHandle. join ();
+	atEnd.   store (false);
+	running. store (true);
+	threadHandle	= std::thread (&syntheticHandler::run, this);
+	return true;
+}
+
+void	syntheticHandler::stopReader	() {
+	running. store (false);
+	if (threadHandle. joinable ())
+	   threadHandle. join ();
+}
+
+int16_t	syntheticHandler::bitDepth	() {
+	return 12;
+}
+
+std::string	syntheticHandler::deviceName	() {
+	return "synthetic";
+}
+
+bool	syntheticHandler::endReached	() {
+	return atEnd. load ();
+}
+
+void	syntheticHandler::run	() {
+std::vector<std::complex<float>> frame (theTransmitter. frameSize ());
+int32_t	frameCount	= 0;
+int64_t	samplesOut	= 0;
+auto	startTime	= std::chrono::steady_clock::now ();
+
+	while (running. load ()) {
+	   if ((nrFrames > 0) && (frameCount >= nrFrames)) {
+	      atEnd. store (true);
+	      break;
+	   }
+	   theTransmitter. nextFrame (frame. data ());
+	   frameCount ++;
+	   for (int i = 0; running. load () && (i < (int)frame. size ());
+	                                             i += BLOCK_SIZE) {
+	      int n	= std::min (BLOCK_SIZE, (int)frame. size () - i);
+	      while (running. load () &&
+	             !_I_Buffer -> WaitForWriteAvailable (n, 10));
+	      _I_Buffer -> putDataIntoBuffer (&frame [i], n);
+	      samplesOut += n;
+	   }
+	   if (paced)
+	      std::this_thread::sleep_until (startTime +
+	               std::chrono::microseconds (samplesOut * 1000 / 2048));
+	}
+	running. store (false);
+}
+
@@ -0,0 +1,58 @@
+#
+/*
+ *    Copyright (C) 2020
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of channelScanner
+ *
+ *    channelScanner is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    channelScanner is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with channelScanner; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *	A "device" without hardware: the samples are generated by the
+ *	dabTransmitter, either for a given number of frames or endless
+ */
+#ifndef	__SYNTHETIC_HANDLER__
+#define	__SYNTHETIC_HANDLER__
+
+#include	<atomic>
+#include	<thread>
+#include	<string>
+#include	"ringbuffer.h"
+#include	"device-handler.h"
+#include	"dab-transmitter.h"
+
+class	syntheticHandler: public deviceHandler {
+public:
+			syntheticHandler (RingBuffer<std::complex<float>> *,
+	                                  uint8_t	dabMode,
+	                                  int32_t	nrFrames,
+	                                  bool		paced);
+			~syntheticHandler ();
+	bool		restartReader	(int32_t);
+	void		stopReader	();
+	int16_t		bitDepth	();
+	std::string	deviceName	();
+	bool		endReached	();
+private:
+	dabTransmitter	theTransmitter;
+	int32_t		nrFrames;
+	bool		paced;
+	std::thread	threadHandle;
+	std::atomic<bool>	running;
+	std::atomic<bool>	atEnd;
+	void		run		();
+};
+#endif
+
@@ -0,0 +1,493 @@
+#
+/*
+ *    Copyright (C) 2020
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of channelScanner
+ *
+ *    channelScanner is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    channelScanner is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with channelScanner; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include	"uff-handler.h"
+#include	"channelizer.h"
+#include	"sample-convert.h"
+#include	"resampler.h"
+#include	"front-end.h"
+#include	"compact-buffer.h"
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	<string.h>
+#include	<math.h>
+#include	<unistd.h>
+#include	<fcntl.h>
+#include	<sys/mman.h>
+#include	<sys/stat.h>
+#include	<chrono>
+#include	<algorithm>
+
+	uffFileHandler::uffFileHandler (RingBuffer<std::complex<float>> *b,
+	                                const std::string &fileName,
+	                                bool	paced,
+	                                int	sampleMode):
+	                                   deviceHandler (b) {
+struct stat st;
+
+	this	-> fileName	= fileName;
+	this	-> paced	= paced;
+	running. store (false);
+	atEnd.   store (false);
+	samplesRead		= 0;
+	theChannelizer		= nullptr;
+
+	fd	= open (fileName. c_str (), O_RDONLY);
+	if (fd < 0) {
+	   fprintf (stderr, "cannot open %s\n", fileName. c_str ());
+	   throw (51);
+	}
+
+	if ((fstat (fd, &st) < 0) || (st. st_size <= UFF_HEADER_SIZE)) {
+	   fprintf (stderr, "%s is not a uff file\n", fileName. c_str ());
+	   close (fd);
+	   throw (52);
+	}
+	fileSize	= st. st_size;
+
+	fileBase	= (uint8_t *)mmap (nullptr, fileSize,
+	                                   PROT_READ, MAP_PRIVATE, fd, 0);
+	if (fileBase == MAP_FAILED) {
+	   fprintf (stderr, "cannot map %s\n", fileName. c_str ());
+	   close (fd);
+	   throw (52);
+	}
+	(void)madvise (fileBase, fileSize, MADV_SEQUENTIAL);
+	payload		= fileBase + UFF_HEADER_SIZE;
+
+	std::string header ((const char *)fileBase,
+	                    strnlen ((const char *)fileBase, UFF_HEADER_SIZE));
+	if (!parseHeader (header)) {
+	   fprintf (stderr, "%s: header not recognized\n", fileName. c_str ());
+	   munmap (fileBase, fileSize);
+	   close (fd);
+	   throw (53);
+	}
+
+//	the file is replayed per msec, i.e. in blocks of convSize samples
+	convSize	= sampleRate / UFF_DIVIDER;
+	if (sampleRate % UFF_DIVIDER != 0)
+	   fprintf (stderr, "samplerate %d is not a multiple of %d\n",
+	                                      sampleRate, UFF_DIVIDER);
+
+	rangeFirst	= 0;
+	rangeEnd	= nrSamples;
+	theFrontEnd	= nullptr;
+	theCompact	= nullptr;
+	if (sampleMode == SAMPLES_FRONTEND)
+	   theFrontEnd	= new frontEnd (b, sampleRate);
+	else
+	if (sampleMode == SAMPLES_COMPACT) {
+//	at the DAB rate the samples are stored as they are in the file,
+//	otherwise they are resampled first and stored as int16
+	   if (sampleRate != UFF_DAB_RATE)
+	      theCompact = new compactBuffer (DEVICE_BUFFER,
+	                                      compactBuffer::COMPACT_INT16,
+	                                                   1 / 8192.0f);
+	   else
+	      theCompact = new compactBuffer (DEVICE_BUFFER,
+	                                      container == UFF_INT16 ?
+	                                         compactBuffer::COMPACT_INT16 :
+	                                         compactBuffer::COMPACT_INT8,
+	                                                   1 / scale);
+	}
+	fprintf (stderr, "%s: %lld samples, %d bits, rate %d, %s\n",
+	                  fileName. c_str (), (long long)nrSamples,
+	                  nrBits, sampleRate, paced ? "paced" : "unpaced");
+}
+
+	uffFileHandler::~uffFileHandler () {
+	stopReader ();
+	delete theFrontEnd;
+	delete theCompact;
+	munmap (fileBase, fileSize);
+	close (fd);
+}
+
+bool	uffFileHandler::restartReader	(int32_t freq) {
+	if (running. load ())
+	   return true;
+	if (threadHandle. joinable ())
+	   threadHandle. join ();
+	if ((frequency != 0) && (freq != frequency))
+	   fprintf (stderr, "file was recorded at %d, not at %d\n",
+	                                      frequency, freq);
+	samplesRead	= rangeFirst;
+	theChannelizer	= nullptr;
+	if (theFrontEnd != nullptr)
+	   theFrontEnd -> reset ();
+	if (theCompact != nullptr)
+	   theCompact -> flush ();
+	atEnd. store (false);
+	running. store (true);
+	threadHandle	= std::thread (&uffFileHandler::run, this);
+	return true;
+}
+//
+//	wideband replay only makes sense if the file has a higher rate
+int32_t	uffFileHandler::widebandRate	() {
+	return sampleRate > UFF_DAB_RATE ? sampleRate : 0;
+}
+
+bool	uffFileHandler::restartWideband	(int32_t freq, channelizer *c) {
+	if (running. load () || (widebandRate () == 0))
+	   return false;
+	if (threadHandle. joinable ())
+	   threadHandle. join ();
+	if ((frequency != 0) && (freq != frequency))
+	   fprintf (stderr, "file was recorded at %d, not at %d\n",
+	                                      frequency, freq);
+	samplesRead	= rangeFirst;
+	theChannelizer	= c;
+	atEnd. store (false);
+	running. store (true);
+	threadHandle	= std::thread (&uffFileHandler::runWideband, this);
+	return true;
+}
+
+void	uffFileHandler::stopReader	() {
+	running. store (false);
+	if (threadHandle. joinable ())
+	   threadHandle. join ();
+}
+
+int16_t	uffFileHandler::bitDepth	() {
+	return nrBits;
+}
+
+std::string	uffFileHandler::deviceName	() {
+	return recordingDevice;
+}
+
+int32_t	uffFileHandler::fileFrequency	() {
+	return frequency;
+}
+
+int32_t	uffFileHandler::fileRate	() {
+	return sampleRate;
+}
+
+int64_t	uffFileHandler::fileSamples	() {
+	return nrSamples;
+}
+
+bool	uffFileHandler::endReached	() {
+	return atEnd. load ();
+}
+
+void	uffFileHandler::setRange	(int64_t first, int64_t count) {
+	rangeFirst	= std::max ((int64_t)0, std::min (first, nrSamples));
+	rangeEnd	= std::min (rangeFirst + count, nrSamples);
+}
+//
+//	A quick look for a null symbol, no synchronization, just
+//	a running sum of the power over a window. A frame contains
+//	exactly one null symbol, so with a span of a frame the
+//	minimum is the null symbol
+int64_t	uffFileHandler::findNull	(int64_t from, int64_t span,
+	                                 int32_t window) {
+int64_t	end	= std::min (from + span + window, nrSamples);
+int64_t	best	= from;
+double	bestSum	= -1;
+double	sum	= 0;
+
+	if ((from < 0) || (from + window > end))
+	   return from;
+	for (int64_t i = from; i < end; i ++) {
+	   sum	+= norm (getSample (i));
+	   if (i - from >= window)
+	      sum -= norm (getSample (i - window));
+	   if ((i - from >= window - 1) && ((bestSum < 0) || (sum < bestSum))) {
+	      bestSum	= sum;
+	      best	= i - window + 1;
+	   }
+	}
+	return best;
+}
+//
+//	The header is the one written by xml_fileWriter::print_xmlHeader,
+//	we only pick up the elements we need
+bool	uffFileHandler::parseHeader	(const std::string &header) {
+int16_t	testWord	= 0xFF;
+bool	hostIsLSB	= *(uint8_t *)(&testWord) == 0xFF;
+std::string s;
+
+	if (header. find ("<SDR>") == std::string::npos)
+	   return false;
+
+	s	= getAttribute (header, "<Samplerate", "Value");
+	sampleRate	= atoi (s. c_str ());
+	if (sampleRate < UFF_DIVIDER)
+	   return false;
+
+	s	= getAttribute (header, "<Channels", "Bits");
+	nrBits	= atoi (s. c_str ());
+
+	s	= getAttribute (header, "<Channels", "Container");
+	if (s == "uint8") {
+	   container	= UFF_UINT8;
+	   scale	= 128.0;
+	}
+	else
+	if (s == "int8") {
+	   container	= UFF_INT8;
+	   scale	= 128.0;
+	}
+	else
+	if (s == "int16") {
+	   container	= UFF_INT16;
+	   if ((nrBits < 2) || (nrBits > 16))
+	      nrBits	= 16;
+	   scale	= (float)(1 << (nrBits - 1));
+	}
+	else {
+	   fprintf (stderr, "container %s not supported\n", s. c_str ());
+	   return false;
+	}
+	if (nrBits <= 0)
+	   nrBits	= 8;
+
+	s	= getAttribute (header, "<Channels", "Ordering");
+	swapBytes	= (container == UFF_INT16) &&
+	                  ((s == "MSB") == hostIsLSB);
+
+	s	= getAttribute (header, "<Frequency", "Value");
+	frequency	= atoi (s. c_str ()) * 1000;
+
+	recordingDevice	= getAttribute (header, "<Device", "Name");
+	if (recordingDevice == "")
+	   recordingDevice = "uff";
+//
+//	the Count is in elements, i.e. I and Q separately. Since the
+//	writer does not flush its last block, the file may be shorter
+	int	elementSize	= container == UFF_INT16 ? 2 : 1;
+	int64_t	available	= (fileSize - UFF_HEADER_SIZE) /
+	                                       (2 * elementSize);
+	s	= getAttribute (header, "<Datablock ", "Count");
+	nrSamples	= atoll (s. c_str ()) / 2;
+	if ((nrSamples <= 0) || (nrSamples > available))
+	   nrSamples	= available;
+	return nrSamples > 0;
+}
+
+std::string	uffFileHandler::getAttribute (const std::string &header,
+	                                      const std::string &element,
+	                                      const std::string &attribute) {
+size_t	start	= header. find (element);
+	if (start == std::string::npos)
+	   return "";
+size_t	end	= header. find ('>', start);
+size_t	a	= header. find (attribute, start);
+	if ((a == std::string::npos) || (a > end))
+	   return "";
+	a	= header. find ('"', a);
+	if ((a == std::string::npos) || (a > end))
+	   return "";
+size_t	b	= header. find ('"', a + 1);
+	if (b == std::string::npos)
+	   return "";
+	return header. substr (a + 1, b - a - 1);
+}
+
+std::complex<float> uffFileHandler::getSample	(int64_t index) {
+	switch (container) {
+	   case UFF_UINT8: {
+	      uint8_t *p	= &payload [2 * index];
+	      return std::complex<float> ((p [0] - 128) / scale,
+	                                  (p [1] - 128) / scale);
+	   }
+	   case UFF_INT8: {
+	      int8_t *p		= (int8_t *)(&payload [2 * index]);
+	      return std::complex<float> (p [0] / scale, p [1] / scale);
+	   }
+	   default:
+	   case UFF_INT16: {
+	      uint16_t *p	= (uint16_t *)(&payload [4 * index]);
+	      uint16_t re	= p [0];
+	      uint16_t im	= p [1];
+	      if (swapBytes) {
+	         re	= (re << 8) | (re >> 8);
+	         im	= (im << 8) | (im >> 8);
+	      }
+	      return std::complex<float> ((int16_t)re / scale,
+	                                  (int16_t)im / scale);
+	   }
+	}
+}
+//
+//	a run of samples, converted at once unless the bytes
+//	have to be swapped
+void	uffFileHandler::getSamples	(int64_t index,
+	                                 std::complex<float> *out, int32_t n) {
+	switch (container) {
+	   case UFF_UINT8:
+	      convert_uint8 (&payload [2 * index], out, n, 1 / scale);
+	      return;
+	   case UFF_INT8:
+	      convert_int8 ((int8_t *)(&payload [2 * index]), out, n, 1 / scale);
+	      return;
+	   default:
+	   case UFF_INT16:
+	      if (!swapBytes) {
+	         convert_int16 ((int16_t *)(&payload [4 * index]),
+	                                               out, n, 1 / scale);
+	         return;
+	      }
+	      for (int32_t i = 0; i < n; i ++)
+	         out [i] = getSample (index + i);
+	      return;
+	}
+}
+//
+//	the same, but the front end converts, resamples and corrects,
+//	"buf" is only needed when the bytes have to be swapped
+void	uffFileHandler::putFrontEnd	(int64_t index, int32_t n,
+	                                 std::complex<float> *buf) {
+	switch (container) {
+	   case UFF_UINT8:
+	      theFrontEnd -> putUint8 (&payload [2 * index], n, 1 / scale);
+	      return;
+	   case UFF_INT8:
+	      theFrontEnd -> putInt8 ((int8_t *)(&payload [2 * index]),
+	                                                   n, 1 / scale);
+	      return;
+	   default:
+	   case UFF_INT16:
+	      if (!swapBytes) {
+	         theFrontEnd -> putInt16 ((int16_t *)(&payload [4 * index]),
+	                                                   n, 1 / scale);
+	         return;
+	      }
+	      getSamples (index, buf, n);
+	      theFrontEnd -> putFloat (buf, n);
+	      return;
+	}
+}
+//
+//	the same for compact storage at the DAB rate, the samples are
+//	copied as they are
+void	uffFileHandler::putCompact	(int64_t index, int32_t n,
+	                                 std::complex<float> *buf) {
+	switch (container) {
+	   case UFF_UINT8:
+	      theCompact -> putUint8 (&payload [2 * index], n);
+	      return;
+	   case UFF_INT8:
+	      theCompact -> putInt8 ((int8_t *)(&payload [2 * index]), n);
+	      return;
+	   default:
+	   case UFF_INT16:
+	      if (!swapBytes) {
+	         theCompact -> putInt16 ((int16_t *)(&payload [4 * index]), n);
+	         return;
+	      }
+	      getSamples (index, buf, n);
+	      theCompact -> putFloat (buf, n);
+	      return;
+	}
+}
+//
+//	Each msec worth of input is resampled into (about) 2048 samples.
+//	In paced mode the blocks are released at the rate of the
+//	original device, otherwise we only wait for buffer space
+void	uffFileHandler::run	() {
+resampler theResampler (sampleRate, UFF_DAB_RATE);
+std::vector<std::complex<float>> inBuf	(convSize);
+std::vector<std::complex<float>> outBuf	(theResampler. maxOutput (convSize));
+int64_t	blocks		= 0;
+auto	startTime	= std::chrono::steady_clock::now ();
+
+	while (running. load ()) {
+	   if (samplesRead >= rangeEnd) {
+	      atEnd. store (true);
+	      break;
+	   }
+	   int m	= (int)std::min ((int64_t)convSize,
+	                                 rangeEnd - samplesRead);
+	   if (theFrontEnd != nullptr) {
+	      while (running. load () &&
+	             !_I_Buffer -> WaitForWriteAvailable (
+	                                theFrontEnd -> maxOutput (m), 10));
+	      putFrontEnd (samplesRead, m, inBuf. data ());
+	      samplesRead	+= m;
+	   }
+	   else
+	   if ((theCompact != nullptr) && (sampleRate == UFF_DAB_RATE)) {
+	      while (running. load () &&
+	             !theCompact -> waitForWriteAvailable (m, 10));
+	      putCompact (samplesRead, m, inBuf. data ());
+	      samplesRead	+= m;
+	   }
+	   else {
+	      getSamples (samplesRead, inBuf. data (), m);
+	      samplesRead	+= m;
+	      int n	= theResampler. process (inBuf. data (), m,
+	                                            outBuf. data ());
+
+	      if (theCompact != nullptr) {
+	         while (running. load () &&
+	                !theCompact -> waitForWriteAvailable (n, 10));
+	         theCompact -> putFloat (outBuf. data (), n);
+	      }
+	      else {
+	         while (running. load () &&
+	                !_I_Buffer -> WaitForWriteAvailable (n, 10));
+	         _I_Buffer -> putDataIntoBuffer (outBuf. data (), n);
+	      }
+	   }
+	   blocks ++;
+	   if (paced)
+	      std::this_thread::sleep_until (startTime +
+	                                  std::chrono::milliseconds (blocks));
+	}
+	running. store (false);
+}
+//
+//	In wideband mode the samples of each msec are passed as they
+//	are, the channelizer does the filtering and rate conversion
+void	uffFileHandler::runWideband	() {
+std::vector<std::complex<float>> localBuf (convSize);
+int64_t	blocks		= 0;
+auto	startTime	= std::chrono::steady_clock::now ();
+
+	while (running. load ()) {
+	   int n	= (int)std::min ((int64_t)convSize,
+	                                 rangeEnd - samplesRead);
+	   getSamples (samplesRead, localBuf. data (), n);
+	   samplesRead	+= n;
+	   if (n == 0) {
+	      atEnd. store (true);
+	      break;
+	   }
+	   while (running. load () &&
+	          (theChannelizer -> writeAvailable () < n))
+	      usleep (100);
+	   theChannelizer -> put (localBuf. data (), n);
+	   blocks ++;
+	   if (paced)
+	      std::this_thread::sleep_until (startTime +
+	                                  std::chrono::milliseconds (blocks));
+	}
+	running. store (false);
+}
+
@@ -0,0 +1,115 @@
+#
+/*
+ *    Copyright (C) 2020
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of channelScanner
+ *
+ *    channelScanner is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    channelScanner is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with channelScanner; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *	The uffFileHandler replays the ".uff" files as written by
+ *	the xml_fileWriter. The file is memory mapped, the samples
+ *	are converted - and if needed resampled - to 2048000 complex
+ *	samples per second and fed into the ringbuffer, either
+ *	in "real time" or as fast as the decoder accepts them.
+ *	Files recorded at a higher rate can be replayed in wideband
+ *	mode, the samples then go unconverted to a channelizer
+ */
+#ifndef	__UFF_HANDLER__
+#define	__UFF_HANDLER__
+
+#include	<atomic>
+#include	<thread>
+#include	<string>
+#include	<vector>
+#include	"ringbuffer.h"
+#include	"device-handler.h"
+
+#define	UFF_HEADER_SIZE	5000
+#define	UFF_DAB_RATE	2048000
+#define	UFF_DIVIDER	1000
+
+class	frontEnd;
+class	compactBuffer;
+
+class	uffFileHandler: public deviceHandler {
+public:
+			uffFileHandler	(RingBuffer<std::complex<float>> *,
+	                                 const std::string &,
+	                                 bool	paced,
+	                                 int	sampleMode = SAMPLES_FLOAT);
+			~uffFileHandler	();
+	bool		restartReader	(int32_t);
+	void		stopReader	();
+	int16_t		bitDepth	();
+	std::string	deviceName	();
+	int32_t		fileFrequency	();
+	int32_t		fileRate	();
+	int64_t		fileSamples	();
+//	replay only "count" samples (file rate) starting at "first"
+	void		setRange	(int64_t first, int64_t count);
+//	the start of the lowest energy window of "window" samples
+//	within "span" samples from "from", i.e. a null symbol
+	int64_t		findNull	(int64_t from, int64_t span,
+	                                 int32_t window);
+	bool		endReached	();
+	int32_t		widebandRate	();
+	bool		restartWideband	(int32_t, channelizer *);
+private:
+	enum containerType {
+	   UFF_UINT8,
+	   UFF_INT8,
+	   UFF_INT16
+	};
+	std::string	fileName;
+	int		fd;
+	uint8_t		*fileBase;
+	int64_t		fileSize;
+	uint8_t		*payload;
+	int64_t		nrSamples;
+	int64_t		samplesRead;
+	int64_t		rangeFirst;
+	int64_t		rangeEnd;
+	int		sampleRate;
+	int		nrBits;
+	containerType	container;
+	bool		swapBytes;
+	float		scale;
+	int32_t		frequency;
+	std::string	recordingDevice;
+	bool		paced;
+	std::thread	threadHandle;
+	std::atomic<bool>	running;
+	std::atomic<bool>	atEnd;
+	channelizer	*theChannelizer;
+	int		convSize;
+
+	bool		parseHeader	(const std::string &);
+	std::string	getAttribute	(const std::string &,
+	                                 const std::string &,
+	                                 const std::string &);
+	std::complex<float>	getSample	(int64_t);
+	void		getSamples	(int64_t,
+	                                 std::complex<float> *, int32_t);
+	void		putFrontEnd	(int64_t, int32_t,
+	                                 std::complex<float> *);
+	void		putCompact	(int64_t, int32_t,
+	                                 std::complex<float> *);
+	void		run		();
+	void		runWideband	();
+};
+#endif
+
@@ -57,6 +57,9 @@ uint8_t t	= 0;
 	else
 	   byteOrder	= "MSB";
 	nrElements	= 0;
+	bufferP_int16	= 0;
+	bufferP_uint8	= 0;
+	bufferP_int8	= 0;
 }
 
 	xml_fileWriter::~xml_fileWriter	() {
@@ -102,44 +105,37 @@ timeinfo	= localtime (&rawtime);
 	fprintf (xmlFile, "</SDR>\n");
 }
 
-#define	BLOCK_SIZE	8192
-static int16_t buffer_int16 [BLOCK_SIZE];
-static int bufferP_int16	= 0;
 void	xml_fileWriter::add	(std::complex<int16_t> * data, int count) {
 	nrElements	+= 2 * count;
 	for (int i = 0; i < count; i ++) {
 	   buffer_int16 [bufferP_int16 ++] = real (data [i]);
 	   buffer_int16 [bufferP_int16 ++] = imag (data [i]);
-	   if (bufferP_int16 >= BLOCK_SIZE) {
-	      fwrite (buffer_int16, sizeof (int16_t), BLOCK_SIZE, xmlFile);
+	   if (bufferP_int16 >= XML_BLOCK_SIZE) {
+	      fwrite (buffer_int16, sizeof (int16_t), XML_BLOCK_SIZE, xmlFile);
 	      bufferP_int16 = 0;
 	   }
 	}
 }
 
-static uint8_t buffer_uint8 [BLOCK_SIZE];
-static int bufferP_uint8	= 0;
 void	xml_fileWriter::add	(std::complex<uint8_t> * data, int count) {
 	nrElements	+= 2 * count;
 	for (int i = 0; i < count; i ++) {
 	   buffer_uint8 [bufferP_uint8 ++] = real (data [i]);
 	   buffer_uint8 [bufferP_uint8 ++] = imag (data [i]);
-	   if (bufferP_uint8 >= BLOCK_SIZE) {
-	      fwrite (buffer_uint8, sizeof (uint8_t), BLOCK_SIZE, xmlFile);
+	   if (bufferP_uint8 >= XML_BLOCK_SIZE) {
+	      fwrite (buffer_uint8, sizeof (uint8_t), XML_BLOCK_SIZE, xmlFile);
 	      bufferP_uint8 = 0;
 	   }
 	}
 }
 
-static int8_t buffer_int8 [BLOCK_SIZE];
-static int bufferP_int8	= 0;
 void	xml_fileWriter::add	(std::complex<int8_t> * data, int count) {
 	nrElements	+= 2 * count;
 	for (int i = 0; i < count; i ++) {
 	   buffer_int8 [bufferP_int8 ++] = real (data [i]);
 	   buffer_int8 [bufferP_int8 ++] = imag (data [i]);
-	   if (bufferP_int8 >= BLOCK_SIZE) {
-	      fwrite (buffer_int8, sizeof (int8_t), BLOCK_SIZE, xmlFile);
+	   if (bufferP_int8 >= XML_BLOCK_SIZE) {
+	      fwrite (buffer_int8, sizeof (int8_t), XML_BLOCK_SIZE, xmlFile);
 	      bufferP_int8 = 0;
 	   }
 	}
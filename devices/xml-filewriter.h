@@ -30,6 +30,8 @@
 #include	<stdio.h>
 #include	<complex>
 
+#define	XML_BLOCK_SIZE	8192
+
 class Blocks	{
 public:
 			Blocks		() {}
@@ -68,6 +70,13 @@ private:
 	FILE		*xmlFile;
 	std::string	byteOrder;
 	int		nrElements;
+//	the output is written in blocks, one buffer per sample type
+	int16_t		buffer_int16	[XML_BLOCK_SIZE];
+	int		bufferP_int16;
+	uint8_t		buffer_uint8	[XML_BLOCK_SIZE];
+	int		bufferP_uint8;
+	int8_t		buffer_int8	[XML_BLOCK_SIZE];
+	int		bufferP_int8;
 };
 
 #endif
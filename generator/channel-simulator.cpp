@@ -0,0 +1,149 @@
+#
+/*
+ *    Copyright (C) 2020
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of channelScanner
+ *
+ *    channelScanner is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    channelScanner is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with channelScanner; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include	"channel-simulator.h"
+#include	"dab-constants.h"
+
+	channelSimulator::channelSimulator	(const impairments &p,
+	                                         uint32_t seed):
+	                                            generator (seed),
+	                                            gauss (0.0, 1.0) {
+int32_t	maxDelay	= 0;
+
+	params		= p;
+	for (int i = 0; i < (int)params. echoes. size (); i ++)
+	   if (params. echoes [i]. delay > maxDelay)
+	      maxDelay = params. echoes [i]. delay;
+	historySize	= maxDelay + 1;
+	history. resize (historySize);
+	for (int i = 0; i < historySize; i ++)
+	   history [i] = std::complex<float> (0, 0);
+	historyIndex	= 0;
+	phase		= 0;
+	phaseIncrement	= 2 * M_PI * params. freqOffset / INPUT_RATE;
+	resamplePosition	= 0;
+//	a fast sample clock gives more samples for the same signal
+	resampleStep	= 1.0 / (1.0 + params. ppm * 1.0e-6);
+	previousSample	= std::complex<float> (0, 0);
+	signalPower	= 0;
+	powerKnown	= false;
+}
+
+	channelSimulator::~channelSimulator	() {
+}
+
+std::complex<float>
+	channelSimulator::applyEchoes	(std::complex<float> v) {
+std::complex<float> res	= v;
+
+	history [historyIndex] = v;
+	for (int i = 0; i < (int)params. echoes. size (); i ++) {
+	   echoPath &e	= params. echoes [i];
+	   int index	= historyIndex - e. delay;
+	   if (index < 0)
+	      index += historySize;
+	   res += history [index] * std::polar (e. gain, e. phase);
+	}
+	historyIndex	= (historyIndex + 1) % historySize;
+	return res;
+}
+//
+//	the signal power is taken from the input, averaged over the
+//	blocks, so the null symbols are part of the measurement
+void	channelSimulator::addNoise	(std::complex<float> *v, int32_t n) {
+float	sigma;
+
+	if (params. snr >= 200)
+	   return;
+	sigma	= sqrt (signalPower / (2 * pow (10, params. snr / 10)));
+	for (int i = 0; i < n; i ++)
+	   v [i] += std::complex<float> (sigma * gauss (generator),
+	                                 sigma * gauss (generator));
+}
+//
+//	full scale is 4 times the rms value of the (noisy) signal,
+//	values beyond are clipped
+void	channelSimulator::quantize	(std::complex<float> *v, int32_t n) {
+float	levels;
+float	fullScale;
+float	noisePower	= 0;
+
+	if (params. bits <= 0)
+	   return;
+	if (params. snr < 200)
+	   noisePower	= signalPower / pow (10, params. snr / 10);
+	levels		= (1 << (params. bits - 1)) - 1;
+	fullScale	= 4 * sqrt (signalPower + noisePower);
+	if (fullScale <= 0)
+	   return;
+	for (int i = 0; i < n; i ++) {
+	   float re	= round (real (v [i]) / fullScale * levels);
+	   float im	= round (imag (v [i]) / fullScale * levels);
+	   re	= re > levels ? levels : re < -levels ? -levels : re;
+	   im	= im > levels ? levels : im < -levels ? -levels : im;
+	   v [i] = std::complex<float> (re, im) * (fullScale / levels);
+	}
+}
+
+void	channelSimulator::process	(const std::complex<float> *in,
+	                                 int32_t n,
+	                                 std::vector<std::complex<float>> &out) {
+int32_t	first	= out. size ();
+float	power	= 0;
+
+	for (int i = 0; i < n; i ++)
+	   power += std::norm (in [i]);
+	power	/= n > 0 ? n : 1;
+	signalPower	= powerKnown ? 0.9 * signalPower + 0.1 * power : power;
+	powerKnown	= true;
+
+	for (int i = 0; i < n; i ++) {
+	   std::complex<float> v = applyEchoes (in [i]);
+	   v	*= std::complex<float> (cos (phase), sin (phase));
+	   phase	+= phaseIncrement;
+	   if (phase > M_PI)
+	      phase -= 2 * M_PI;
+	   else
+	   if (phase < -M_PI)
+	      phase += 2 * M_PI;
+
+	   if (params. ppm == 0) {
+	      out. push_back (v);
+	      continue;
+	   }
+//	linear interpolation between the previous and the current sample
+	   while (resamplePosition < 1.0) {
+	      out. push_back (previousSample +
+	                      (v - previousSample) * (float)resamplePosition);
+	      resamplePosition += resampleStep;
+	   }
+	   resamplePosition	-= 1.0;
+	   previousSample	= v;
+	}
+
+	if ((int32_t)out. size () > first) {
+	   addNoise (&out [first], out. size () - first);
+	   quantize (&out [first], out. size () - first);
+	}
+}
+
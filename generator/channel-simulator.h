@@ -0,0 +1,90 @@
+#
+/*
+ *    Copyright (C) 2020
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of channelScanner
+ *
+ *    channelScanner is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    channelScanner is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with channelScanner; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *	The channelSimulator applies, in this order, echoes (multipath
+ *	or a second SFN transmitter), a carrier frequency offset,
+ *	a sample clock offset, additive white gaussian noise and
+ *	quantization to a stream of samples (at INPUT_RATE).
+ */
+#ifndef	__CHANNEL_SIMULATOR__
+#define	__CHANNEL_SIMULATOR__
+
+#include	<stdint.h>
+#include	<vector>
+#include	<complex>
+#include	<random>
+
+class	echoPath {
+public:
+			echoPath	(int32_t d = 0, float g = 0,
+	                                 float p = 0):
+	                                   delay (d), gain (g), phase (p) {}
+	int32_t		delay;		// in samples
+	float		gain;		// relative to the main path
+	float		phase;		// in radians
+};
+
+class	impairments {
+public:
+			impairments	():
+	                                   snr (200),
+	                                   freqOffset (0),
+	                                   ppm (0),
+	                                   bits (0) {}
+	float		snr;		// in dB, 200 means "no noise"
+	float		freqOffset;	// in Hz
+	float		ppm;		// sample clock offset
+	int16_t		bits;		// quantization, 0 means none
+	std::vector<echoPath> echoes;
+};
+
+class	channelSimulator {
+public:
+			channelSimulator	(const impairments &,
+	                                         uint32_t seed = 1);
+			~channelSimulator	();
+//	the output is appended to the vector, with a clock offset
+//	its size differs (slightly) from the input size
+	void		process		(const std::complex<float> *, int32_t,
+	                                 std::vector<std::complex<float>> &);
+private:
+	impairments	params;
+	std::vector<std::complex<float>> history;
+	int32_t		historyIndex;
+	int32_t		historySize;
+	double		phase;
+	double		phaseIncrement;
+	double		resamplePosition;
+	double		resampleStep;
+	std::complex<float>	previousSample;
+	float		signalPower;
+	bool		powerKnown;
+	std::mt19937	generator;
+	std::normal_distribution<float> gauss;
+
+	std::complex<float>	applyEchoes	(std::complex<float>);
+	void		addNoise	(std::complex<float> *, int32_t);
+	void		quantize	(std::complex<float> *, int32_t);
+};
+
+#endif
+
@@ -0,0 +1,243 @@
+#
+/*
+ *    Copyright (C) 2020
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of channelScanner
+ *
+ *    channelScanner is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    channelScanner is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with channelScanner; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *	dab-generator writes a number of frames of the synthetic
+ *	ensemble to a uff file (12 bits samples in int16 containers),
+ *	to be replayed by the uff version of the scanner.
+ *	With -W rate a wideband file is written: each of the channels
+ *	(-C, given more than once) carries its own ensemble, the
+ *	blocks are upsampled to "rate" and shifted to their place
+ *	relative to the centre of the group
+ */
+#include	<stdio.h>
+#include	<stdlib.h>
+#include	<unistd.h>
+#include	<string>
+#include	<vector>
+#include	"dab-constants.h"
+#include	"dab-transmitter.h"
+#include	"band-handler.h"
+#include	"xml-filewriter.h"
+#include	"channelizer.h"
+
+#define	SAMPLE_BITS	12
+
+static
+void	printOptions	() {
+	fprintf (stderr,
+"	dab-generator options are\n"
+"	                  -o filename\tthe uff file to write (required)\n"
+"	                  -M Mode\tMode is 1, 2 or 4. Default is Mode 1\n"
+"	                  -n number\tnumber of frames (default 100)\n"
+"	                  -B Band\tBand is either L_BAND or BAND_III (default)\n"
+"	                  -C Channel\tchannel recorded in the header (default 5A)\n"
+"	                  -W rate\twideband file with the given samplerate,\n"
+"	                  \t\teach channel (-C) gets an ensemble\n");
+}
+//
+//	the ensemble for the i-th block of a wideband file
+static
+synthEnsemble	blockEnsemble	(int i, const std::string &channel) {
+synthEnsemble	e	= defaultEnsemble ();
+	e. EId		+= i;
+	e. label	= "Synthetic " + channel;
+	for (int j = 0; j < (int)e. services. size (); j ++) {
+	   e. services [j]. SId	+= 0x10 * i;
+	   e. services [j]. label = channel + " " + e. services [j]. label;
+	}
+	return e;
+}
+
+static
+std::complex<int16_t>	toSample	(std::complex<float> v, float amplitude) {
+float	re	= real (v) * amplitude;
+float	im	= imag (v) * amplitude;
+	re	= re > amplitude ? amplitude :
+	          re < -amplitude ? -amplitude : re;
+	im	= im > amplitude ? amplitude :
+	          im < -amplitude ? -amplitude : im;
+	return std::complex<int16_t> ((int16_t)re, (int16_t)im);
+}
+
+int	main (int argc, char **argv) {
+uint8_t		dabMode		= 1;
+int32_t		nrFrames	= 100;
+uint8_t		theBand		= BAND_III;
+std::vector<std::string> channels;
+int32_t		wideRate	= 0;
+std::string	fileName	= "";
+bandHandler	dabBand;
+int		opt;
+
+	while ((opt = getopt (argc, argv, "o:M:n:B:C:W:")) != -1) {
+	   switch (opt) {
+	      case 'o':
+	         fileName	= std::string (optarg);
+	         break;
+
+	      case 'M':
+	         dabMode	= atoi (optarg);
+	         if (!((dabMode == 1) || (dabMode == 2) || (dabMode == 4)))
+	            dabMode = 1;
+	         break;
+
+	      case 'n':
+	         nrFrames	= atoi (optarg);
+	         if (nrFrames < 1)
+	            nrFrames = 1;
+	         break;
+
+	      case 'B':
+	         theBand = std::string (optarg) == std::string ("L_BAND") ?
+	                                                 L_BAND : BAND_III;
+	         break;
+
+	      case 'C':
+	         channels. push_back (std::string (optarg));
+	         break;
+
+	      case 'W':
+	         wideRate	= atoi (optarg);
+	         break;
+
+	      default:
+	         printOptions ();
+	         exit (1);
+	   }
+	}
+
+	if (fileName == "") {
+	   printOptions ();
+	   exit (1);
+	}
+	if (channels. size () == 0)
+	   channels. push_back ("5A");
+	if ((wideRate != 0) && (wideRate <= INPUT_RATE)) {
+	   fprintf (stderr, "the wideband rate should exceed %d\n", INPUT_RATE);
+	   exit (1);
+	}
+
+	FILE *outFile	= fopen (fileName. c_str (), "wb");
+	if (outFile == nullptr) {
+	   fprintf (stderr, "cannot open %s\n", fileName. c_str ());
+	   exit (2);
+	}
+
+	float	amplitude	= (1 << (SAMPLE_BITS - 1)) - 1;
+	if (wideRate == 0) {
+	   dabTransmitter theTransmitter (dabMode, defaultEnsemble ());
+	   xml_fileWriter *xmlWriter =
+	                    new xml_fileWriter (outFile,
+	                                        SAMPLE_BITS,
+	                                        "int16",
+	                                        INPUT_RATE,
+	                                        dabBand. Frequency (theBand,
+	                                                            channels [0]),
+	                                        "synthetic",
+	                                        "dabTransmitter",
+	                                        "1.0");
+	   std::vector<std::complex<float>>   frame (theTransmitter. frameSize ());
+	   std::vector<std::complex<int16_t>> samples (frame. size ());
+
+	   for (int f = 0; f < nrFrames; f ++) {
+	      theTransmitter. nextFrame (frame. data ());
+	      for (int i = 0; i < (int)frame. size (); i ++)
+	         samples [i] = toSample (frame [i], amplitude);
+	      xmlWriter -> add (samples. data (), samples. size ());
+	   }
+	   delete xmlWriter;		// writes the header
+	   fclose (outFile);
+	   fprintf (stderr, "%d frames (Mode %d) written to %s\n",
+	                         nrFrames, dabMode, fileName. c_str ());
+	   return 0;
+	}
+//
+//	wideband: all channels should fit in one group
+	std::vector<blockGroup> groups =
+	                 dabBand. groupChannels (theBand, channels, wideRate);
+	if (groups. size () != 1) {
+	   fprintf (stderr, "the channels do not fit in %d Hz\n", wideRate);
+	   exit (1);
+	}
+	blockGroup	&g	= groups [0];
+	int	nrBlocks	= g. channels. size ();
+	std::vector<dabTransmitter *>	transmitters;
+	std::vector<polyphaseFilter *>	upsamplers;
+	std::vector<std::complex<double>>	phasors;
+	for (int i = 0; i < nrBlocks; i ++) {
+	   transmitters. push_back (new dabTransmitter (dabMode,
+	                                 blockEnsemble (i, g. channels [i])));
+	   upsamplers. push_back (new polyphaseFilter (INPUT_RATE, wideRate,
+	                                               768000, 1280000));
+	   phasors. push_back (std::complex<double> (1, 0));
+	   fprintf (stderr, "%s at offset %d Hz\n",
+	                     g. channels [i]. c_str (), g. offsets [i]);
+	}
+	xml_fileWriter *xmlWriter =
+	                    new xml_fileWriter (outFile,
+	                                        SAMPLE_BITS,
+	                                        "int16",
+	                                        wideRate,
+	                                        g. centre,
+	                                        "synthetic",
+	                                        "dabTransmitter",
+	                                        "1.0");
+	int32_t	frameSize	= transmitters [0] -> frameSize ();
+	std::vector<std::complex<float>>   frame (frameSize);
+	std::vector<std::complex<float>>   wide (upsamplers [0] -> maxOutput (frameSize));
+	std::vector<std::complex<float>>   sum;
+	std::vector<std::complex<int16_t>> samples;
+
+	for (int f = 0; f < nrFrames; f ++) {
+	   int32_t n = 0;
+	   for (int b = 0; b < nrBlocks; b ++) {
+	      transmitters [b] -> nextFrame (frame. data ());
+	      n = upsamplers [b] -> process (frame. data (), frameSize,
+	                                                  wide. data ());
+	      if (b == 0)
+	         sum. assign (n, std::complex<float> (0, 0));
+	      std::complex<double> step =
+	             std::polar (1.0, 2 * M_PI * g. offsets [b] / wideRate);
+	      for (int i = 0; i < n; i ++) {
+	         sum [i] += wide [i] * std::complex<float> (phasors [b]);
+	         phasors [b] *= step;
+	      }
+	      phasors [b] /= abs (phasors [b]);
+	   }
+	   samples. resize (n);
+	   for (int i = 0; i < n; i ++)
+	      samples [i] = toSample (sum [i] / (float)nrBlocks, amplitude);
+	   xmlWriter -> add (samples. data (), samples. size ());
+	}
+
+	for (int b = 0; b < nrBlocks; b ++) {
+	   delete transmitters [b];
+	   delete upsamplers [b];
+	}
+	delete xmlWriter;		// writes the header
+	fclose (outFile);
+	fprintf (stderr, "%d frames (Mode %d, %d blocks, centre %d) written to %s\n",
+	                         nrFrames, dabMode, nrBlocks, g. centre,
+	                         fileName. c_str ());
+	return 0;
+}
+
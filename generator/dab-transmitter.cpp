@@ -0,0 +1,296 @@
+#
+/*
+ *    Copyright (C) 2020
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of channelScanner
+ *
+ *    channelScanner is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    channelScanner is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with channelScanner; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include	"dab-transmitter.h"
+#include	"protTables.h"
+#include	<string.h>
+
+//	a small ensemble with four (audio) services, each in its
+//	own subchannel (short form, table index 14, i.e. 64 kbit/s)
+synthEnsemble	defaultEnsemble	() {
+synthEnsemble	e;
+static
+const char *names [] = {"Synth One", "Synth Two",
+	                "Synth Three", "Synth Four"};
+
+	e. EId		= 0xE0AB;
+	e. label	= "Synthetic DAB";
+	for (int i = 0; i < 4; i ++) {
+	   synthService s;
+	   s. SId	= 0x5001 + i;
+	   s. label	= names [i];
+	   s. subChId	= i;
+	   s. startAddr	= 32 * i;
+	   s. tableIndex	= 14;
+	   s. ASCTy	= 63;		// DAB+
+	   e. services. push_back (s);
+	}
+	return e;
+}
+
+static
+void	addLabel	(std::vector<uint8_t> &fig, const std::string &label) {
+	for (int i = 0; i < 16; i ++)
+	   fig. push_back (i < (int)label. size () ? label [i] : ' ');
+	fig. push_back (0xFF);		// character flag field
+	fig. push_back (0x00);
+}
+//
+//	the FIB crc is the CCITT crc, inverted, see section 5.2.1
+static
+void	addCRC		(uint8_t *fib) {
+uint16_t	crc	= 0xFFFF;
+
+	for (int i = 0; i < 30; i ++) {
+	   crc ^= fib [i] << 8;
+	   for (int j = 0; j < 8; j ++)
+	      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+	}
+	crc	= ~crc;
+	fib [30]	= crc >> 8;
+	fib [31]	= crc & 0xFF;
+}
+
+	dabTransmitter::dabTransmitter	(uint8_t dabMode,
+	                                 const synthEnsemble &ensemble):
+	                                    params (dabMode),
+	                                    theTable (dabMode),
+	                                    myMapper (dabMode),
+	                                    my_fftHandler (dabMode),
+	                                    encoder (768) {
+uint8_t	shiftRegister [9];
+int16_t	local	= 0;
+
+	this	-> ensemble	= ensemble;
+	this	-> T_null	= params. get_T_null ();
+	this	-> T_u		= params. get_T_u ();
+	this	-> T_s		= params. get_T_s ();
+	this	-> T_g		= params. get_T_g ();
+	this	-> T_F		= params. get_T_F ();
+	this	-> nrBlocks	= params. get_L ();
+	this	-> carriers	= params. get_carriers ();
+	ficBlocks		= 3 * 2 * carriers / 2304;
+	scale			= 0.25 / sqrt (carriers);
+	CIFcount		= 0;
+	mscSeed			= 1;
+	figIndex		= 0;
+	fft_buffer		= my_fftHandler. getVector ();
+	refCarriers. resize (T_u);
+//
+//	energy dispersal vector and puncturing table are the
+//	ones of the ficHandler
+	memset (shiftRegister, 1, 9);
+	for (int i = 0; i < 768; i ++) {
+	   PRBS [i] = shiftRegister [8] ^ shiftRegister [4];
+	   for (int j = 8; j > 0; j --)
+	      shiftRegister [j] = shiftRegister [j - 1];
+	   shiftRegister [0] = PRBS [i];
+	}
+
+	memset (punctureTable, 0, (3072 + 24) * sizeof (bool));
+	for (int i = 0; i < 21; i ++)
+	   for (int k = 0; k < 32 * 4; k ++) {
+	      if (get_PCodes (16 - 1) [k % 32] == 1)
+	         punctureTable [local] = true;
+	      local ++;
+	   }
+	for (int i = 0; i < 3; i ++)
+	   for (int k = 0; k < 32 * 4; k ++) {
+	      if (get_PCodes (15 - 1) [k % 32] == 1)
+	         punctureTable [local] = true;
+	      local ++;
+	   }
+	for (int k = 0; k < 24; k ++) {
+	   if (get_PCodes (8 - 1) [k] == 1)
+	      punctureTable [local] = true;
+	   local ++;
+	}
+
+	buildFIGs ();
+}
+
+	dabTransmitter::~dabTransmitter	() {
+}
+
+int32_t	dabTransmitter::frameSize	() {
+	return T_F;
+}
+//
+//	The FIGs describing the ensemble, sent round robin.
+//	FIG 0/0 (with the CIF count) is added per CIF in buildFIB
+void	dabTransmitter::buildFIGs	() {
+std::vector<uint8_t> fig;
+
+	fig. clear ();			// FIG 1/0, ensemble label
+	fig. push_back ((1 << 5) | 21);
+	fig. push_back (0x00);
+	fig. push_back (ensemble. EId >> 8);
+	fig. push_back (ensemble. EId & 0xFF);
+	addLabel (fig, ensemble. label);
+	figList. push_back (fig);
+
+	for (int i = 0; i < (int)ensemble. services. size (); i ++) {
+	   synthService &s = ensemble. services [i];
+	   fig. clear ();		// FIG 0/1, short form
+	   fig. push_back ((0 << 5) | 4);
+	   fig. push_back (0x01);
+	   fig. push_back ((s. subChId << 2) | ((s. startAddr >> 8) & 03));
+	   fig. push_back (s. startAddr & 0xFF);
+	   fig. push_back (s. tableIndex & 0x3F);
+	   figList. push_back (fig);
+
+	   fig. clear ();		// FIG 1/1, service label
+	   fig. push_back ((1 << 5) | 21);
+	   fig. push_back (0x01);
+	   fig. push_back (s. SId >> 8);
+	   fig. push_back (s. SId & 0xFF);
+	   addLabel (fig, s. label);
+	   figList. push_back (fig);
+
+	   fig. clear ();		// FIG 0/2, one audio component
+	   fig. push_back ((0 << 5) | 6);
+	   fig. push_back (0x02);
+	   fig. push_back (s. SId >> 8);
+	   fig. push_back (s. SId & 0xFF);
+	   fig. push_back (0x01);
+	   fig. push_back (s. ASCTy & 0x3F);
+	   fig. push_back (((s. subChId & 0x3F) << 2) | 0x02);
+	   figList. push_back (fig);
+	}
+}
+//
+//	a FIB is 30 bytes of FIGs, padded with 0xFF, followed by the crc.
+//	It is delivered as a vector of 256 bits
+void	dabTransmitter::buildFIB	(uint8_t *bits, bool firstFIB) {
+uint8_t	fib [32];
+int	used	= 0;
+int	tried	= 0;
+
+	memset (fib, 0xFF, 30);
+	if (firstFIB) {			// FIG 0/0, ensemble info
+	   fib [used ++] = (0 << 5) | 5;
+	   fib [used ++] = 0x00;
+	   fib [used ++] = ensemble. EId >> 8;
+	   fib [used ++] = ensemble. EId & 0xFF;
+	   fib [used ++] = (CIFcount / 250) & 0x1F;
+	   fib [used ++] = CIFcount % 250;
+	}
+
+	while (tried < (int)figList. size ()) {
+	   std::vector<uint8_t> &fig = figList [figIndex];
+	   if (used + (int)fig. size () > 30)
+	      break;
+	   memcpy (&fib [used], fig. data (), fig. size ());
+	   used		+= fig. size ();
+	   figIndex	= (figIndex + 1) % figList. size ();
+	   tried ++;
+	}
+
+	addCRC (fib);
+	for (int i = 0; i < 256; i ++)
+	   bits [i] = (fib [i / 8] >> (7 - (i % 8))) & 01;
+}
+//
+//	768 bits (3 FIBs) in, 2304 bits out
+void	dabTransmitter::encodeFIC	(uint8_t *in, uint8_t *out) {
+uint8_t	dispersed	[768];
+uint8_t	encoded		[4 * 768 + 24];
+int	outCount	= 0;
+
+	for (int i = 0; i < 768; i ++)
+	   dispersed [i] = in [i] ^ PRBS [i];
+	encoder. encode (dispersed, encoded);
+	for (int i = 0; i < 4 * 768 + 24; i ++)
+	   if (punctureTable [i])
+	      out [outCount ++] = encoded [i];
+}
+//
+//	the inverse FFT is not scaled, scaling is done here
+void	dabTransmitter::toTimeDomain	(std::complex<float> *out) {
+	memcpy (fft_buffer, refCarriers. data (),
+	                          T_u * sizeof (std::complex<float>));
+	my_fftHandler. do_iFFT ();
+	for (int i = 0; i < T_u; i ++)
+	   out [T_g + i] = fft_buffer [i] * scale;
+	for (int i = 0; i < T_g; i ++)
+	   out [i] = fft_buffer [T_u - T_g + i] * scale;
+}
+
+void	dabTransmitter::prsSymbol	(std::complex<float> *out) {
+	for (int i = 0; i < T_u; i ++)
+	   refCarriers [i] = std::complex<float> (0, 0);
+	for (int i = 1; i <= carriers / 2; i ++) {
+	   refCarriers [i]	= std::polar (1.0f, theTable. get_Phi (i));
+	   refCarriers [T_u - i] = std::polar (1.0f, theTable. get_Phi (-i));
+	}
+	toTimeDomain (out);
+}
+//
+//	bit i and bit carriers + i form the QPSK symbol for carrier i,
+//	the symbol is differentially applied to the carrier it is
+//	mapped on by the frequency interleaver
+void	dabTransmitter::dataSymbol	(uint8_t *bits,
+	                                 std::complex<float> *out) {
+	for (int i = 0; i < carriers; i ++) {
+	   int16_t index	= myMapper. mapIn (i);
+	   if (index < 0)
+	      index += T_u;
+	   std::complex<float> q ((1 - 2 * bits [i]) * M_SQRT1_2,
+	                          (1 - 2 * bits [carriers + i]) * M_SQRT1_2);
+	   refCarriers [index] *= q;
+	}
+	toTimeDomain (out);
+}
+
+void	dabTransmitter::nextFrame	(std::complex<float> *out) {
+std::vector<uint8_t> ficBits (3 * 2 * carriers);
+std::vector<uint8_t> bits (2 * carriers);
+uint8_t	fibBits [768];
+
+	for (int i = 0; i < T_null; i ++)
+	   out [i] = std::complex<float> (0, 0);
+	out	+= T_null;
+
+	prsSymbol (out);
+	out	+= T_s;
+
+	for (int b = 0; b < ficBlocks; b ++) {
+	   for (int f = 0; f < 3; f ++)
+	      buildFIB (&fibBits [256 * f], f == 0);
+	   encodeFIC (fibBits, &ficBits [2304 * b]);
+	   CIFcount	= (CIFcount + 1) % 5000;
+	}
+
+	for (int symbol = 1; symbol < nrBlocks; symbol ++) {
+	   if (symbol <= 3)
+	      memcpy (bits. data (), &ficBits [(symbol - 1) * 2 * carriers],
+	                                            2 * carriers);
+	   else
+	   for (int i = 0; i < 2 * carriers; i ++) {
+	      mscSeed	= mscSeed * 1103515245 + 12345;
+	      bits [i]	= (mscSeed >> 16) & 01;
+	   }
+	   dataSymbol (bits. data (), out);
+	   out	+= T_s;
+	}
+}
@@ -0,0 +1,107 @@
+#
+/*
+ *    Copyright (C) 2020
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of channelScanner
+ *
+ *    channelScanner is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    channelScanner is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with channelScanner; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *	A simple DAB transmitter, the "inverse" of the receiver chain:
+ *	FIBs (with CRC) are energy dispersed, convolutionally encoded
+ *	and punctured, the bits are mapped onto the carriers through
+ *	the frequency interleaver and DQPSK modulated, starting with
+ *	the phase reference symbol. The MSC contains (reproducible)
+ *	pseudo random data.
+ */
+#ifndef	__DAB_TRANSMITTER__
+#define	__DAB_TRANSMITTER__
+
+#include	<stdint.h>
+#include	<string>
+#include	<vector>
+#include	<complex>
+#include	"dab-constants.h"
+#include	"dab-params.h"
+#include	"phasetable.h"
+#include	"freq-interleaver.h"
+#include	"fft_handler.h"
+#include	"viterbi-spiral.h"
+
+class	synthService {
+public:
+			synthService	() {}
+			~synthService	() {}
+	uint16_t	SId;
+	std::string	label;
+	int16_t		subChId;
+	int16_t		startAddr;
+	int16_t		tableIndex;	// short form, index in ProtLevel
+	int16_t		ASCTy;
+};
+
+class	synthEnsemble {
+public:
+			synthEnsemble	() {}
+			~synthEnsemble	() {}
+	uint16_t	EId;
+	std::string	label;
+	std::vector<synthService> services;
+};
+
+synthEnsemble	defaultEnsemble	();
+
+class	dabTransmitter {
+public:
+			dabTransmitter	(uint8_t,	// Mode
+	                                 const synthEnsemble &);
+			~dabTransmitter	();
+	int32_t		frameSize	();
+	void		nextFrame	(std::complex<float> *);
+private:
+	dabParams	params;
+	phaseTable	theTable;
+	interLeaver	myMapper;
+	fft_handler	my_fftHandler;
+	viterbiSpiral	encoder;
+	synthEnsemble	ensemble;
+	int32_t		T_null;
+	int32_t		T_u;
+	int32_t		T_s;
+	int32_t		T_g;
+	int32_t		T_F;
+	int32_t		nrBlocks;
+	int32_t		carriers;
+	int32_t		ficBlocks;
+	float		scale;
+	int32_t		CIFcount;
+	uint32_t	mscSeed;
+	int		figIndex;
+	std::vector<std::vector<uint8_t>>	figList;
+	std::vector<std::complex<float>>	refCarriers;
+	std::complex<float>	*fft_buffer;
+	bool		punctureTable	[4 * 768 + 24];
+	uint8_t		PRBS		[768];
+
+	void		buildFIGs	();
+	void		buildFIB	(uint8_t *, bool);
+	void		encodeFIC	(uint8_t *, uint8_t *);
+	void		prsSymbol	(std::complex<float> *);
+	void		dataSymbol	(uint8_t *, std::complex<float> *);
+	void		toTimeDomain	(std::complex<float> *);
+};
+
+#endif
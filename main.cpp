@@ -34,6 +34,7 @@
 #include	"dab-processor.h"
 #include	"band-handler.h"
 #include	"ringbuffer.h"
+#include	"channelizer.h"
 #ifdef	HAVE_PLUTO
 #include	"pluto-handler.h"
 #elif	HAVE_SDRPLAY_V2
@@ -46,12 +47,32 @@
 #include        "hackrf-handler.h"
 #elif   HAVE_LIMESDR
 #include        "lime-handler.h"
+#elif   HAVE_UFF
+#include        "uff-handler.h"
+#elif   HAVE_SYNTHETIC
+#include        "synthetic-handler.h"
+#elif   HAVE_SHM
+#include        "shm-handler.h"
 #endif
+#include	"shm-ring.h"
+#include	"resampler.h"
+#include	"device-handler.h"
+#include	"fft_handler.h"
 #include	"service-printer.h"
+#include	"channel-events.h"
+#include	"scan-context.h"
+#include	"scan-scheduler.h"
 #include	<locale>
 #include	<codecvt>
 #include	<atomic>
 #include	<string>
+#include	<chrono>
+#include	<mutex>
+#include	<algorithm>
+#include	<thread>
+#ifdef	HAVE_UFF
+#include	<dirent.h>
+#endif
 using std::cerr;
 using std::endl;
 
@@ -67,52 +88,55 @@ void	handleChannel (deviceHandler	*theDevice,
 	               FILE		*outFile,
 	               bool		jsonOutput,
 	               bool		firstEnsemble,
-	               bool		dumping);
-//	we deal with callbacks from different threads. So, if you extend
-//	the functions, take care and add locking whenever needed
+	               bool		dumping,
+	               bool		offline,
+	               fileThroughput	*result = nullptr);
+void	scanDevices   (const std::vector<deviceHandler *> &devices,
+	               const std::vector<RingBuffer<std::complex<float>> *> &buffers,
+	               const std::vector<std::string> &channelList,
+	               uint8_t		Mode,
+	               uint8_t		theBand,
+	               int		timeSyncTime,
+	               int		freqSyncTime,
+	               int		duration,
+	               FILE		*outFile,
+	               bool		jsonOutput,
+	               bool		dumping,
+	               bool		offline);
+void	handleGroup   (deviceHandler	*theDevice,
+	               uint8_t		Mode,
+	               uint8_t		theBand,
+	               const blockGroup	&theGroup,
+	               int		timeSyncTime,
+	               int		freqSyncTime,
+	               int		duration,
+	               FILE		*outFile,
+	               bool		jsonOutput,
+	               bool		firstEnsemble,
+	               bool		dumping,
+	               bool		offline);
+void	publishStream (deviceHandler	*theDevice,
+	               RingBuffer<std::complex<float>> *b,
+	               const std::string &name,
+	               uint8_t		theBand,
+	               const std::string &theChannel);
+//	The state of a scan is kept in a scanContext, the callbacks
+//	(called from the processor threads) only touch their own context.
+//	What remains here are the settings, shared by all pipelines
 static
 std::atomic<bool> run;
 
-static
-std::atomic<bool>timeSynced;
-
-static
-std::atomic<bool>timesyncSet;
-
-static
-std::atomic<bool>ensembleRecognized;
-std::string     ensembleName;
-uint32_t        ensembleId;
-static
-void    ensembleHandler (std::string name, int Id, void *userData) {
-        fprintf (stderr, "ensemble %s is (%X) recognized\n",
-                                  name. c_str (), (uint32_t)Id);
-        ensembleRecognized. store (true);
-        ensembleName    = name;
-        ensembleId      = Id;
-}
-
 std::string homeDir	= getenv ("HOME");
-std::vector<std::string> programNames;
-std::vector<int> programSIds;
-
-#include	<bits/stdc++.h>
-
-std::unordered_map <int, std::string> ensembleContents;
-static
-void	addtoEnsemble (std::string s, int SId, void *userdata) {
-	for (std::vector<std::string>::iterator it = programNames.begin();
-	             it != programNames. end(); ++it)
-	   if (*it == s)
-	      return;
-	ensembleContents. insert (pair <int, std::string> (SId, s));
-	programNames. push_back (s);
-	programSIds . push_back (SId);
-	std::cerr << "program " << s << " is part of the ensemble\n";
-}
 
 static
 FILE	*outFile	= stdout;
+//
+//	with compact storage the device keeps the samples, the float
+//	buffer is a stand-in
+static
+int32_t	bufferSize	(int sampleMode) {
+	return sampleMode == SAMPLES_COMPACT ? STANDIN_BUFFER : DEVICE_BUFFER;
+}
 static
 SNDFILE	*dumpFile	= nullptr;
 
@@ -121,26 +145,43 @@ static void sighandler (int signum) {
 	run. store (false);
 }
 
-std::vector<std::string> channelList;
+#ifdef	HAVE_UFF
 static
-void	syncsignalHandler (bool b, void *userData) {
-	timeSynced. store (b);
-	timesyncSet. store (true);
-	(void)userData;
-}
-//
+void	analyzeFiles	(const std::vector<std::string> &fileList,
+	                 int		workers,
+	                 uint8_t	theMode,
+	                 uint8_t	theBand,
+	                 const std::string &theChannel,
+	                 int		sampleMode,
+	                 int		timeSyncTime,
+	                 int		freqSyncTime,
+	                 int		duration,
+	                 bool		jsonOutput);
 static
-callbacks	the_callBacks;
+void	addDirectory	(const std::string &dirName,
+	                 std::vector<std::string> &fileList);
+static
+void	analyzeChunks	(const std::string &fileName,
+	                 int		nrChunks,
+	                 int		workers,
+	                 uint8_t	theMode,
+	                 uint8_t	theBand,
+	                 const std::string &theChannel,
+	                 int		sampleMode,
+	                 bool		jsonOutput);
+#endif
 
 int	main (int argc, char **argv) {
 // Default values
 uint8_t		theMode		= 1;
 uint8_t		theBand		= BAND_III;
-int		duration	= 10;		// seconds, default
+int		duration	= 10000;	// milliseconds, default
+std::vector<std::string> channelList;
+int		sampleMode	= SAMPLES_FLOAT;
 #ifdef	HAVE_PLUTO
 int16_t		gain		= 60;
 bool		autogain	= false;
-const char	*optionsString	= "O:RT:F:D:d:M:B:C:G:Q";
+const char	*optionsString	= "O:RT:F:D:d:M:B:C:G:QZ:r:fcw:E:";
 const char	*deviceString	= "Compiled for Adalm Pluto";
 #elif	HAVE_SDRPLAY_V2
 int16_t		GRdB		= 30;
@@ -148,52 +189,69 @@ int16_t		lnaState	= 4;
 bool		autogain	= false;
 int16_t		ppmOffset	= 0;
 const char	*deviceString	= "Compiled for SDRPlay (2.13 library)";
-const char	*optionsString	= "O:RF:T:D:d:M:B:C:G:L:Qp:";
+const char	*optionsString	= "O:RF:T:D:d:M:B:C:G:L:Qp:Z:fcw:E:";
 #elif	HAVE_AIRSPY
 int16_t		gain		= 20;
 bool		autogain	= false;
 bool		rf_bias		= false;
 int16_t		ppmOffset	= 0;
 const char	*deviceString	= "Compiled for AIRspy";
-const char	*optionsString	= "O:RT:F:D:d:M:B:C:G:p:";
+const char	*optionsString	= "O:RT:F:D:d:M:B:C:G:p:WZ:r:fcw:E:";
 #elif	HAVE_RTLSDR
 int16_t		gain		= 20;
 bool		autogain	= false;
 int16_t		ppmOffset	= 0;
 const char	*deviceString	= "Compiled for rtlsdr sticks";
-const char	*optionsString	= "O:F:T:D:d:M:B:C:G:p:QR";
+const char	*optionsString	= "O:F:T:D:d:M:B:C:G:p:QRN:Z:fcw:E:";
 #elif	HAVE_HACKRF
 int		lnaGain		= 40;
 int		vgaGain		= 40;
 int		ppmOffset	= 0;
 const char	*deviceString	= "Compiled for hackrf";
-const char	*optionsString	= "O:F:T:D:d:A:C:G:g:p:R:";
+const char	*optionsString	= "O:F:T:D:d:A:C:G:g:p:R:Z:fcw:E:";
 #elif	HAVE_LIMESDR
 int16_t		gain		= 70;
 std::string	antenna		= "Auto";
 const char	*deviceString	= "Compiled for limesdr";
-const char	*optionsString	= "O:F:T:RD:d:A:C:G:g:X:";
+const char	*optionsString	= "O:F:T:RD:d:A:C:G:g:X:Z:w:E:";
+#elif	HAVE_UFF
+std::string	fileName	= "";
+std::vector<std::string> fileList;
+int		workers		= std::thread::hardware_concurrency ();
+int		nrChunks	= 1;
+bool		paced		= true;
+const char	*deviceString	= "Compiled for uff file replay";
+const char	*optionsString	= "O:F:T:D:d:M:B:C:i:I:j:S:PWN:Z:r:fcw:E:";
+#elif	HAVE_SYNTHETIC
+int32_t		nrFrames	= 0;
+bool		paced		= true;
+const char	*deviceString	= "Compiled for a synthetic signal";
+const char	*optionsString	= "O:F:T:D:d:M:B:C:n:PN:Z:w:E:";
+#elif	HAVE_SHM
+std::string	shmName		= "dab-iq";
+const char	*deviceString	= "Compiled for a shared memory stream";
+const char	*optionsString	= "O:F:T:D:d:M:B:C:s:w:E:";
 #endif
+std::string	publishName	= "";
 bool		dumping		= false;
-int16_t		timeSyncTime	= 10;
-int16_t		freqSyncTime	= 5;
+bool		offline		= false;
+bool		wideband	= false;
+int		nrDevices	= 1;
+int		timeSyncTime	= 10000;	// milliseconds
+int		freqSyncTime	= 5000;		// milliseconds
 bool		jsonOutput	= false;
+std::string	wisdomName	= "";
+std::string	planEffort	= "";
 int		opt;
 struct sigaction sigact;
 deviceHandler	*theDevice	= nullptr;
 bool		firstEnsemble	= true;
-RingBuffer<std::complex<float>> _I_Buffer (16 * 32768);
-
-	the_callBacks. signalHandler            = syncsignalHandler;
-        the_callBacks. ensembleHandler          = ensembleHandler;
-        the_callBacks. programnameHandler       = addtoEnsemble;
+bool		compacting	= false;
 
 	std::cerr << "dab_channelScanner,\n \
 	                Copyright 2020 J van Katwijk, Lazy Chair Computing\n";
 	std::cerr << deviceString << "\n\
 	          Software is provided AS IS and licensed under GPL V2\n";
-	timeSynced.	store (false);
-	timesyncSet.	store (false);
 	run.		store (false);
 //	std::wcout.imbue(std::locale("en_US.utf8"));
 	if (argc == 1) {
@@ -218,12 +276,20 @@ RingBuffer<std::complex<float>> _I_Buffer (16 * 32768);
 	         homeDir	= optarg;
 	         break;
 
+	      case 'w':
+	         wisdomName	= optarg;
+	         break;
+
+	      case 'E':
+	         planEffort	= optarg;
+	         break;
+
 	      case 'D':
-	         freqSyncTime	= atoi (optarg);
+	         freqSyncTime	= atof (optarg) * 1000;
 	         break;
 
 	      case 'd':
-	         timeSyncTime	= atoi (optarg);
+	         timeSyncTime	= atof (optarg) * 1000;
 	         break;
 
 	      case 'M':
@@ -238,7 +304,7 @@ RingBuffer<std::complex<float>> _I_Buffer (16 * 32768);
 	         break;
 
 	      case 'T':
-	         duration	= atoi (optarg);
+	         duration	= atof (optarg) * 1000;
 	         break;
 
 	      case 'R':
@@ -250,6 +316,32 @@ RingBuffer<std::complex<float>> _I_Buffer (16 * 32768);
 	         fprintf (stderr, "%s \n", optarg);
 	         break;
 
+	      case 'W':
+	         wideband	= true;
+	         break;
+
+	      case 'N':
+	         nrDevices	= atoi (optarg);
+	         break;
+
+	      case 'Z':
+	         publishName	= std::string (optarg);
+	         break;
+
+	      case 'r':
+	         if (!resampler_select (optarg))
+	            fprintf (stderr, "resampler %s not available, using %s\n",
+	                                               optarg, "polyphase");
+	         break;
+
+	      case 'f':
+	         sampleMode	= SAMPLES_FRONTEND;
+	         break;
+
+	      case 'c':
+	         compacting	= true;
+	         break;
+
 #ifdef	HAVE_PLUTO
 	      case 'G':
 	         gain		= atoi (optarg);
@@ -320,7 +412,7 @@ RingBuffer<std::complex<float>> _I_Buffer (16 * 32768);
 	         ppmOffset	= 0;
 	         break;
 
-#elif	HAVE_LIME
+#elif	HAVE_LIMESDR
 	      case 'G':
 	      case 'g':	
 	         gain		= atoi (optarg);
@@ -330,6 +422,43 @@ RingBuffer<std::complex<float>> _I_Buffer (16 * 32768);
 	         antenna	= std::string (optarg);
 	         break;
 
+#elif	HAVE_UFF
+	      case 'i':
+	         fileList. push_back (std::string (optarg));
+	         break;
+
+	      case 'I':
+	         addDirectory (std::string (optarg), fileList);
+	         break;
+
+	      case 'j':
+	         workers	= atoi (optarg);
+	         break;
+
+	      case 'S':
+	         nrChunks	= atoi (optarg);
+	         break;
+
+	      case 'P':
+	         paced		= false;
+	         offline	= true;
+	         break;
+
+#elif	HAVE_SYNTHETIC
+	      case 'n':
+	         nrFrames	= atoi (optarg);
+	         break;
+
+	      case 'P':
+	         paced		= false;
+	         offline	= true;
+	         break;
+
+#elif	HAVE_SHM
+	      case 's':
+	         shmName	= std::string (optarg);
+	         break;
+
 #endif
 	      default:
 	         fprintf (stderr, "Option %c not understood\n", opt);
@@ -337,57 +466,156 @@ RingBuffer<std::complex<float>> _I_Buffer (16 * 32768);
 	         exit (1);
 	   }
 	}
+//
+//	the recorder taps the buffer and writes the samples as they came
+//	from the device, the front end would have corrected them already
+	if ((sampleMode == SAMPLES_FRONTEND) && dumping) {
+	   fprintf (stderr, "-f is ignored with -R\n");
+	   sampleMode	= SAMPLES_FLOAT;
+	}
+//
+//	the front end, the recorder and the publisher all work on the
+//	float samples in the buffer, compact storage is not for them
+	if (compacting) {
+	   if ((sampleMode == SAMPLES_FRONTEND) ||
+	                               dumping || (publishName != ""))
+	      fprintf (stderr, "-c is ignored with -f, -R or -Z\n");
+	   else
+	      sampleMode	= SAMPLES_COMPACT;
+	}
+	RingBuffer<std::complex<float>> _I_Buffer (bufferSize (sampleMode),
+	                                                           true);
+//
+//	with a wisdom file the plans are measured, unless told otherwise
+	if ((planEffort == "") && (wisdomName != ""))
+	   planEffort	= "measure";
+	if (planEffort == "patient")
+	   fft_handler::setPlanning (FFTW_PATIENT, wisdomName);
+	else
+	if (planEffort == "measure")
+	   fft_handler::setPlanning (FFTW_MEASURE, wisdomName);
+	else {
+	   if ((planEffort != "") && (planEffort != "estimate"))
+	      fprintf (stderr, "unknown planning %s, using estimate\n",
+	                                           planEffort. c_str ());
+	   fft_handler::setPlanning (FFTW_ESTIMATE, wisdomName);
+	}
 //
 	sigact.sa_handler = sighandler;
 	sigemptyset(&sigact.sa_mask);
 	sigact.sa_flags = 0;
 
-	int32_t frequency	= MHz (220);	// just a dummy value
-	try {
+	if (homeDir.back () != '/')
+	   homeDir = homeDir + "/";
+#ifdef	HAVE_UFF
+//
+//	with more than one file, the files are decoded in parallel,
+//	as fast as possible
+	if (fileList. size () > 1) {
+	   if (wideband || dumping)
+	      fprintf (stderr, "-W and -R are ignored in batch mode\n");
+	   analyzeFiles (fileList, workers, theMode, theBand,
+	                 channelList. size () > 0 ? channelList [0] : "",
+	                 sampleMode, timeSyncTime, freqSyncTime, duration, jsonOutput);
+	   if (outFile != stdout)
+	      fclose (outFile);
+	   exit (0);
+	}
+	if (fileList. size () == 1)
+	   fileName	= fileList [0];
+//
+//	a single long file can be split into chunks, decoded in parallel
+	if ((nrChunks > 1) && (fileName != "")) {
+	   if (wideband || dumping)
+	      fprintf (stderr, "-W and -R are ignored when decoding chunks\n");
+	   analyzeChunks (fileName, nrChunks, workers, theMode, theBand,
+	                  channelList. size () > 0 ? channelList [0] : "",
+	                  sampleMode, jsonOutput);
+	   if (outFile != stdout)
+	      fclose (outFile);
+	   exit (0);
+	}
+#endif
+
+//
+//	with more than one device (-N), each device gets its own buffer,
+//	"index" selects the device (where the device supports that)
+	auto makeDevice = [&] (RingBuffer<std::complex<float>> *b,
+	                       int index) -> deviceHandler * {
+	   (void)index;
+#if	defined (HAVE_SDRPLAY_V2) || defined (HAVE_AIRSPY) || \
+	defined (HAVE_PLUTO) || defined (HAVE_RTLSDR) || \
+	defined (HAVE_HACKRF) || defined (HAVE_LIMESDR)
+//	the radios start at some frequency, the replay devices have none
+	   int32_t frequency	= MHz (220);	// just a dummy value
+#endif
 #ifdef	HAVE_SDRPLAY_V2
-	   theDevice	= new sdrplayHandler (&_I_Buffer,
-	                                      std::string ("2"),
-	                                      frequency,
-	                                      ppmOffset,
-	                                      GRdB,
-	                                      lnaState,
-	                                      autogain,
-	                                      0,
-	                                      0);
+	   return new sdrplayHandler (b,
+	                              std::string ("2"),
+	                              frequency,
+	                              ppmOffset,
+	                              GRdB,
+	                              lnaState,
+	                              autogain,
+	                              0,
+	                              0,
+	                              sampleMode);
 #elif	HAVE_AIRSPY
-	   theDevice	= new airspyHandler (&_I_Buffer,
-	                                     std::string ("2"),
-	                                     frequency,
-	                                     ppmOffset,
-	                                     gain,
-	                                     rf_bias);
+	   return new airspyHandler (b,
+	                             std::string ("2"),
+	                             frequency,
+	                             ppmOffset,
+	                             gain,
+	                             rf_bias,
+	                             sampleMode);
 #elif	HAVE_PLUTO
-	   theDevice	= new plutoHandler	(&_I_Buffer,
-	                                         std::string ("2"),
-	                                         frequency,
-	                                         gain,
-	                                         autogain);
+	   return new plutoHandler	(b,
+	                                 std::string ("2"),
+	                                 frequency,
+	                                 gain,
+	                                 autogain,
+	                                 sampleMode);
 #elif	HAVE_RTLSDR
-	   theDevice	= new rtlsdrHandler	(&_I_Buffer,
-	                                         std::string ("2"),
-	                                         frequency,
-	                                         ppmOffset,
-	                                         gain,
-	                                         autogain);
+	   return new rtlsdrHandler	(b,
+	                                 std::string ("2"),
+	                                 frequency,
+	                                 ppmOffset,
+	                                 gain,
+	                                 autogain,
+	                                 index,
+	                                 sampleMode);
 #elif   HAVE_HACKRF
-           theDevice    = new hackrfHandler     (&_I_Buffer,
-	                                         std::string ("2"),
-                                                 frequency,
-                                                 ppmOffset,
-                                                 lnaGain,
-                                                 vgaGain);
-#elif   HAVE_LIME
-           theDevice    = new limeHandler       (&_I_Buffer,
-	                                         std::string ("2"),
-                                                 frequency,
-	                                         gain, antenna);
+           return new hackrfHandler     (b,
+	                                 std::string ("2"),
+                                         frequency,
+                                         ppmOffset,
+                                         lnaGain,
+                                         vgaGain,
+	                                 false,
+	                                 sampleMode);
+#elif   HAVE_LIMESDR
+           return new limeHandler       (b,
+	                                 std::string ("2"),
+                                         frequency,
+	                                 gain, antenna);
+#elif	HAVE_UFF
+	   return new uffFileHandler	(b,
+	                                 fileName,
+	                                 paced,
+	                                 sampleMode);
+#elif	HAVE_SYNTHETIC
+	   return new syntheticHandler	(b,
+	                                 theMode,
+	                                 nrFrames,
+	                                 paced);
+#elif	HAVE_SHM
+	   return new shmDeviceHandler	(b, shmName);
 #endif
+	   return nullptr;
+	};
 
+	try {
+	   theDevice	= makeDevice (&_I_Buffer, 0);
 	}
 	catch (int e) {
 	   std::cerr << "allocating device failed (" << e << "), fatal\n";
@@ -398,8 +626,94 @@ RingBuffer<std::complex<float>> _I_Buffer (16 * 32768);
 	   exit (33);
 	}
 //
-	if (homeDir.back () != '/')
-	   homeDir = homeDir + "/";
+//	with -Z the device is tuned to the (first) channel and its
+//	samples are published, nothing is decoded here
+	if (publishName != "") {
+	   if (channelList. size () == 0) {
+	      fprintf (stderr, "-Z needs a channel (-C)\n");
+	      exit (34);
+	   }
+	   sigaction (SIGINT, &sigact, nullptr);
+	   sigaction (SIGTERM, &sigact, nullptr);
+	   publishStream (theDevice, &_I_Buffer, publishName,
+	                  theBand, channelList [0]);
+	   theDevice	-> stopReader ();
+	   delete theDevice;
+	   exit (0);
+	}
+//
+	if (wideband && (theDevice -> widebandRate () == 0)) {
+	   fprintf (stderr, "device does not support wideband mode\n");
+	   wideband	= false;
+	}
+//
+//	in wideband mode the channels are grouped, all blocks of
+//	a group are decoded in parallel
+	if (wideband) {
+	   bandHandler dabBand;
+	   std::vector<blockGroup> groups =
+	             dabBand. groupChannels (theBand, channelList,
+	                                     theDevice -> widebandRate ());
+	   for (uint16_t i = 0; i < groups. size (); i ++)
+	      handleGroup (theDevice,
+	                   theMode,
+	                   theBand,
+	                   groups [i],
+	                   timeSyncTime,
+	                   freqSyncTime,
+	                   duration,
+	                   outFile,
+	                   jsonOutput,
+	                   firstEnsemble,
+	                   dumping,
+	                   offline);
+	   channelList. resize (0);
+	}
+//
+//	with more devices the channels are scanned in parallel, the
+//	devices other than the first one are opened here
+	if ((nrDevices > 1) && (channelList. size () > 1)) {
+	   std::vector<deviceHandler *> devices;
+	   std::vector<RingBuffer<std::complex<float>> *> buffers;
+	   devices. push_back (theDevice);
+	   buffers. push_back (&_I_Buffer);
+	   for (int i = 1; i < nrDevices; i ++) {
+	      RingBuffer<std::complex<float>> *b =
+	                     new RingBuffer<std::complex<float>> (
+	                                      bufferSize (sampleMode), true);
+	      deviceHandler *d	= nullptr;
+	      try {
+	         d	= makeDevice (b, i);
+	      }
+	      catch (int e) {
+	         fprintf (stderr, "device %d cannot be opened (%d)\n", i, e);
+	      }
+	      if (d == nullptr) {
+	         delete b;
+	         break;
+	      }
+	      devices. push_back (d);
+	      buffers. push_back (b);
+	   }
+	   fprintf (stderr, "scanning %d channels with %d devices\n",
+	                     (int)channelList. size (), (int)devices. size ());
+	   scanDevices (devices, buffers, channelList,
+	                theMode,
+	                theBand,
+	                timeSyncTime,
+	                freqSyncTime,
+	                duration,
+	                outFile,
+	                jsonOutput,
+	                dumping,
+	                offline);
+	   for (int i = 1; i < (int)devices. size (); i ++) {
+	      devices [i] -> stopReader ();
+	      delete devices [i];
+	      delete buffers [i];
+	   }
+	   channelList. resize (0);
+	}
 	for (uint16_t i = 0; i < channelList. size (); i ++) {
 	   std::string theChannel = channelList. at (i);
 	   handleChannel (theDevice,
@@ -413,7 +727,8 @@ RingBuffer<std::complex<float>> _I_Buffer (16 * 32768);
 	                  outFile,
 	                  jsonOutput,
 	                  firstEnsemble,
-	                  dumping
+	                  dumping,
+	                  offline
 	                 );
 	}
 
@@ -422,126 +737,222 @@ RingBuffer<std::complex<float>> _I_Buffer (16 * 32768);
 }
 
 
-void	handleChannel (deviceHandler *theDevice,
-	               RingBuffer<std::complex<float>> *_I_Buffer,
-	               uint8_t		theMode,
-	               uint8_t		theBand,
-	               std::string	theChannel,
-	               int		timeSyncTime,
-	               int		freqSyncTime,
-	               int		duration,
-	               FILE		*outFile,
-	               bool		jsonOutput,
-	               bool		firstEnsemble,
-	               bool		dumping){
-bool		firstService	= true;
-bandHandler     dabBand;
-int32_t frequency	= dabBand. Frequency (theBand, theChannel);
-dabProcessor theRadio (_I_Buffer,
-	               theMode,
-	               &the_callBacks,
-	               nullptr		// Ctx
-	              );
-
-	programNames. resize (0);
-	programSIds. resize (0);
-
-	theRadio. start ();
-	theDevice	-> restartReader (frequency);
-
-	print_fileHeader (outFile, jsonOutput);
-	timesyncSet.		store (false);
-	ensembleRecognized.	store (false);
-	
-	while (!timeSynced. load () && (--timeSyncTime >= 0))
-	      sleep (1);
-
-	if (!timeSynced. load ()) {
-	   cerr << "There does not seem to be a DAB signal here" << endl;
-	   theDevice -> stopReader ();
-	   sleep (1);
-	   theRadio. stop ();
-	   return;
-	}
-
-	std::cerr << "there might be a DAB signal here" << endl;
-
-	while ((--freqSyncTime >= 0)) {
-	   std::cerr << freqSyncTime + 1 << "\r";
-	   sleep (1);
+#define	WAIT_EVENT	0
+#define	WAIT_TIMEOUT	1
+#define	WAIT_NODATA	2
+//
+//	Waiting, at most "ms" milliseconds, for an event. In offline mode
+//	the milliseconds are not wall clock time, but signal time, i.e.
+//	samples consumed by the processor. WAIT_NODATA is returned when a
+//	finite input is exhausted and the processor does not progress anymore
+static
+int	awaitEvent (scanContext *ctx, int event, int32_t seen, int32_t ms,
+	            deviceHandler *theDevice, bool offline) {
+channelEvents	&theEvents	= ctx -> events;
+dabProcessor	*theRadio	= ctx -> theRadio;
+
+	if (ms <= 0)
+	   return theEvents. count (event) != seen ? WAIT_EVENT : WAIT_TIMEOUT;
+	if (!offline)
+	   return theEvents. waitFor (event, seen, ms) ?
+	                                  WAIT_EVENT : WAIT_TIMEOUT;
+
+	int64_t target	= theRadio -> get_sampleCount () +
+	                               (int64_t)ms * (INPUT_RATE / 1000);
+	int64_t lastCount	= -1;
+	int	stalls		= 0;
+	while (true) {
+	   if (theEvents. waitFor (event, seen, 1))
+	      return WAIT_EVENT;
+	   int64_t count = theRadio -> get_sampleCount ();
+	   if (count >= target)
+	      return WAIT_TIMEOUT;
+	   if (theDevice -> endReached () && (count == lastCount)) {
+	      if (++stalls >= 50)
+	         return WAIT_NODATA;
+	   }
+	   else
+	      stalls	= 0;
+	   lastCount	= count;
 	}
-	std::cerr << "\n";
+}
+//
+//	the time (in ms) since the start of the channel, wall clock time
+//	or, in offline mode, signal time
+static
+int32_t	channelTime (dabProcessor *theRadio, bool offline,
+	             std::chrono::steady_clock::time_point startTime) {
+	if (offline)
+	   return theRadio -> get_sampleCount () / (INPUT_RATE / 1000);
+	return std::chrono::duration_cast<std::chrono::milliseconds>
+	             (std::chrono::steady_clock::now () - startTime). count ();
+}
 
-	if (!ensembleRecognized. load ()) {
-	   std::cerr << "no ensemble data found, fatal\n";
-	   theDevice -> stopReader ();
-	   sleep (1);
-	   theRadio. stop ();
-	   return;
+static
+void	printThroughput (dabProcessor *theRadio,
+	                 const std::string &theChannel,
+	                 std::chrono::steady_clock::time_point startTime,
+	                 fileThroughput *result = nullptr) {
+std::chrono::duration<double> elapsed =
+	                    std::chrono::steady_clock::now () - startTime;
+int64_t	samples	= theRadio -> get_sampleCount ();
+int32_t	frames	= theRadio -> get_frameCount ();
+
+	if (result != nullptr) {
+	   result -> channel	= theChannel;
+	   result -> samples	= samples;
+	   result -> frames	= frames;
+	   result -> seconds	= elapsed. count ();
 	}
 
-	int avg_snr	= 0;
-	std::vector<int> tii_data;
-	if (dumping) {
-	   time_t now;
-           time (&now);
-           char buf [sizeof "2020-09-06-08T06:07:09Z"];
-           strftime (buf, sizeof (buf), "%F %T", gmtime (&now));
-           std::string timeString = buf;
-           std::string fileName = homeDir +
-	                          theDevice -> deviceName () +
-	                          theChannel + " " +
-	                          theDevice -> toHex (ensembleId) + " " +
-	                          timeString + ".uff";
-	   fprintf (stderr, "fileName = %s\n", fileName. c_str ());
-	   theDevice -> startDumping (fileName);
+	fprintf (stderr, "%s: %lld samples, %d frames in %.2f s (%.0f samples/s, %.1f frames/s)\n",
+	                  theChannel. c_str (), (long long)samples, frames,
+	                  elapsed. count (),
+	                  samples / elapsed. count (),
+	                  frames / elapsed. count ());
+}
+//
+//	Wait for time sync, the ensemble and a complete service list.
+//	Returns false if there is no ensemble
+static
+bool	identifyEnsemble (scanContext *ctx,
+	                  deviceHandler	*theDevice,
+	                  int		timeSyncTime,
+	                  int		freqSyncTime,
+	                  bool		offline,
+	                  std::chrono::steady_clock::time_point startTime) {
+dabProcessor *theRadio	= ctx -> theRadio;
+	int status	= awaitEvent (ctx, EVENT_TIMESYNC, 0,
+	                              timeSyncTime -
+	                                 channelTime (theRadio, offline,
+	                                              startTime),
+	                              theDevice, offline);
+	if (status != WAIT_EVENT) {
+	   cerr << ctx -> channel << ": There does not seem to be a DAB signal here" << endl;
+	   return false;
 	}
 
-	run. store (true);
+	std::cerr << ctx -> channel << ": there might be a DAB signal here" << endl;
 
-	for (int i = 0; i < duration; i ++) {
-	   fprintf (stderr, "we sleep\n");
-	   sleep (1);
-	   avg_snr	+= theRadio. get_snr ();
-	   int tii	= theRadio. get_tiiData ();
-	   if (tii != 0) {
-	      uint16_t tii_index = 0;
-	      for (tii_index = 0; tii_index < tii_data. size (); tii_index ++)
-	         if (tii_data. at (tii_index) == tii)
-	            break;
-	      if (tii_index == tii_data. size ())
-	         tii_data. push_back (tii);
+	int32_t ensembleDeadline = channelTime (theRadio, offline, startTime) +
+	                                                     freqSyncTime;
+	status	= awaitEvent (ctx, EVENT_ENSEMBLE, 0, freqSyncTime,
+	                      theDevice, offline);
+	if (status != WAIT_EVENT) {
+	   std::cerr << ctx -> channel << ": no ensemble data found\n";
+	   return false;
+	}
+//
+//	We wait until the fib processor tells that the service list is
+//	complete, the time for ensemble identification (-D) being the
+//	upper bound
+	int32_t left	= ensembleDeadline -
+	                     channelTime (theRadio, offline, startTime);
+	if (left > 0)
+	   (void)awaitEvent (ctx, EVENT_COMPLETE, 0, left, theDevice, offline);
+	ensembleStatus	theStatus;
+	theRadio -> get_ensembleStatus (&theStatus);
+	fprintf (stderr, "%s: %d of %d services complete, confidence %d%%\n",
+	                  ctx -> channel. c_str (),
+	                  theStatus. complete, theStatus. announced,
+	                  theStatus. confidence);
+	return true;
+}
+//
+//	Dwell until the deadline, the SNR is sampled every SNR_INTERVAL
+//	ms and the average is returned. The TII codes are collected by
+//	the context, when not dumping the dwell ends earlier, once the
+//	list of codes did not grow during TII_STABLE TII events
+#define	SNR_INTERVAL	1000
+#define	TII_STABLE	5
+static
+int	collectTii (scanContext *ctx,
+	            deviceHandler *theDevice,
+	            int32_t	measureDeadline,
+	            bool	dumping,
+	            bool	offline,
+	            std::chrono::steady_clock::time_point startTime) {
+dabProcessor *theRadio	= ctx -> theRadio;
+int64_t	snrSum		= 0;
+int	snrCount	= 0;
+int32_t	nextSample	= channelTime (theRadio, offline, startTime) +
+	                                                    SNR_INTERVAL;
+int	nrCodes		= ctx -> tiiCodes (). size ();
+int	stable		= 0;
+
+	while (true) {
+	   int32_t now	= channelTime (theRadio, offline, startTime);
+	   if (now >= nextSample) {
+	      snrSum	+= theRadio -> get_snr ();
+	      snrCount ++;
+	      nextSample	= now + SNR_INTERVAL;
+	   }
+	   int32_t left	= measureDeadline - now;
+	   if (left <= 0)
+	      break;
+	   int32_t seen	= ctx -> events. count (EVENT_TII);
+	   int status = awaitEvent (ctx, EVENT_TII, seen,
+	                            std::min (left, nextSample - now),
+	                            theDevice, offline);
+	   if (status == WAIT_NODATA)
+	      break;
+	   if (status != WAIT_EVENT)
+	      continue;
+	   int n	= ctx -> tiiCodes (). size ();
+	   if (n != nrCodes) {
+	      nrCodes	= n;
+	      stable	= 0;
 	   }
+	   else
+	   if ((nrCodes > 0) && !dumping &&
+	       ((stable += ctx -> events. count (EVENT_TII) - seen) >=
+	                                                     TII_STABLE))
+	      break;
 	}
+	return snrCount > 0 ? snrSum / snrCount : theRadio -> get_snr ();
+}
+
+static
+void	printEnsemble (scanContext *ctx,
+	               int32_t		frequency,
+	               int		snr,
+	               FILE		*outFile,
+	               bool		jsonOutput,
+	               bool		*firstEnsemble,
+	               const std::vector<int> &tii_data) {
+dabProcessor *theRadio	= ctx -> theRadio;
+bool	firstService	= true;
 
+	std::vector<std::string> programNames	= ctx -> programNames ();
+	std::string ensembleName	= ctx -> ensembleName ();
+	uint32_t ensembleId		= ctx -> ensembleId ();
 
-//	print ensemble data here
 	print_ensembleData (outFile,
 	                    jsonOutput,
-                            &theRadio,
-	                    theChannel,
+                            theRadio,
+	                    ctx -> channel,
 	                    ensembleName,
 	                    ensembleId,
 	                    frequency / 1000,
-	                    avg_snr / duration,	
+	                    snr,
 	                    tii_data,
-	                    &firstEnsemble);
+	                    firstEnsemble);
 
 	print_audioheader (outFile, jsonOutput);
 	for (int i = 0; i < (int)(programNames. size ()); i ++) {
 	   audiodata ad;
-	   theRadio. dataforAudioService (programNames [i]. c_str (),
+	   theRadio -> dataforAudioService (programNames [i]. c_str (),
 	                                                        &ad, 0);
 	   if (ad. defined) {
-	      print_audioService (outFile, jsonOutput, &theRadio,
+	      print_audioService (outFile, jsonOutput, theRadio,
 	                          programNames [i]. c_str (), &ad,
 	                          &firstService);
 	      for (int j = 1; j < 5; j ++) {
 	            packetdata pd;
-	            theRadio. dataforDataService (programNames [i]. c_str (),
+	            theRadio -> dataforDataService (programNames [i]. c_str (),
                                                                       &pd, j);
 	            if (pd. defined)
-	               print_dataService (outFile, jsonOutput, &theRadio,
+	               print_dataService (outFile, jsonOutput, theRadio,
                                           programNames [i]. c_str (), j, &pd,
 	                                  &firstService);
 	      }
@@ -550,7 +961,7 @@ dabProcessor theRadio (_I_Buffer,
 	}
 	for (int i = 0; i < (int)(programNames. size ()); i ++) {
 	   packetdata pd;
-	   theRadio. dataforDataService (programNames [i]. c_str (),
+	   theRadio -> dataforDataService (programNames [i]. c_str (),
 	                                                        &pd, 0);
 	   if (pd. defined && firstService) {
 	      print_dataHeader (outFile, jsonOutput);
@@ -558,30 +969,322 @@ dabProcessor theRadio (_I_Buffer,
 	   }
 
 	   if (pd. defined) 
-	      print_dataService (outFile, jsonOutput, &theRadio,
+	      print_dataService (outFile, jsonOutput, theRadio,
 	                          programNames [i]. c_str (), i, &pd,
 	                          &firstService);
 	}
 
-	print_ensembleFooter (outFile, jsonOutput);
+	print_ensembleFooter (outFile, jsonOutput, theRadio);
 	print_fileFooter (outFile, jsonOutput);
+}
+
+static
+std::string	dumpName	(deviceHandler *theDevice,
+	                         const std::string &theChannel,
+	                         uint32_t ensembleId) {
+time_t now;
+	time (&now);
+	char buf [sizeof "2020-09-06-08T06:07:09Z"];
+	strftime (buf, sizeof (buf), "%F %T", gmtime (&now));
+	std::string timeString = buf;
+	return homeDir + theDevice -> deviceName () +
+	                 theChannel + " " +
+	                 theDevice -> toHex (ensembleId) + " " +
+	                 timeString + ".uff";
+}
+
+void	handleChannel (deviceHandler *theDevice,
+	               RingBuffer<std::complex<float>> *_I_Buffer,
+	               uint8_t		theMode,
+	               uint8_t		theBand,
+	               std::string	theChannel,
+	               int		timeSyncTime,
+	               int		freqSyncTime,
+	               int		duration,
+	               FILE		*outFile,
+	               bool		jsonOutput,
+	               bool		firstEnsemble,
+	               bool		dumping,
+	               bool		offline,
+	               fileThroughput	*result) {
+bandHandler     dabBand;
+int32_t frequency	= dabBand. Frequency (theBand, theChannel);
+scanContext	ctx (theChannel, _I_Buffer, theMode,
+	                             theDevice -> getFrontEnd (),
+	                             theDevice -> getCompact ());
+dabProcessor	&theRadio	= *ctx. theRadio;
+
+	theRadio. start ();
+	theDevice	-> restartReader (frequency);
+	auto startTime	= std::chrono::steady_clock::now ();
+
+	print_fileHeader (outFile, jsonOutput);
+	if (!identifyEnsemble (&ctx, theDevice,
+	                       timeSyncTime, freqSyncTime,
+	                       offline, startTime)) {
+	   theDevice -> stopReader ();
+	   printThroughput (&theRadio, theChannel, startTime, result);
+	   theRadio. stop ();
+	   return;
+	}
+
+	if (dumping) {
+	   std::string fileName = dumpName (theDevice, theChannel,
+	                                    ctx. ensembleId ());
+	   fprintf (stderr, "fileName = %s\n", fileName. c_str ());
+	   theDevice -> startDumping (fileName);
+	}
+
+	run. store (true);
+//
+//	When dumping, the data is recorded for "duration" ms, otherwise
+//	"duration" is the upper bound for collecting the TII data, the
+//	dwell ends once no new TII codes show up
+	int snr	= collectTii (&ctx, theDevice,
+	                      channelTime (&theRadio, offline, startTime) +
+	                                                          duration,
+	                      dumping, offline, startTime);
+
+	printEnsemble (&ctx, frequency, snr,
+	               outFile, jsonOutput, &firstEnsemble, ctx. tiiCodes ());
+	printThroughput (&theRadio, theChannel, startTime, result);
+	if (result != nullptr)
+	   result -> ensemble	= true;
 	theDevice ->  stopDumping	();
 	sf_close (dumpFile);
 	theRadio. stop		();
 	theDevice	-> stopReader	();
 }
+//
+//	In wideband mode the device is tuned to the centre of a group
+//	of blocks, the channelizer feeds a processor per block.
+//	The blocks are handled the same way as a single channel,
+//	the waits overlap since the blocks are decoded in parallel
+void	handleGroup   (deviceHandler	*theDevice,
+	               uint8_t		theMode,
+	               uint8_t		theBand,
+	               const blockGroup	&theGroup,
+	               int		timeSyncTime,
+	               int		freqSyncTime,
+	               int		duration,
+	               FILE		*outFile,
+	               bool		jsonOutput,
+	               bool		firstEnsemble,
+	               bool		dumping,
+	               bool		offline) {
+bandHandler     dabBand;
+int	nrBlocks	= theGroup. channels. size ();
+std::vector<RingBuffer<std::complex<float>> *> buffers;
+std::vector<scanContext *>	contexts;
+std::vector<bool>		found;
+std::vector<int32_t>		deadline;
+
+	for (int i = 0; i < nrBlocks; i ++) {
+	   buffers. push_back (new RingBuffer<std::complex<float>>
+	                                             (DEVICE_BUFFER, true));
+	   contexts. push_back (new scanContext (theGroup. channels [i],
+	                                         buffers [i], theMode));
+	   contexts [i] -> theRadio -> start ();
+	}
+	channelizer	*theChannelizer =
+	                     new channelizer (theDevice -> widebandRate (),
+	                                      theGroup. offsets, buffers);
+	fprintf (stderr, "tuning to %d for %d blocks\n",
+	                          theGroup. centre, nrBlocks);
+	theDevice	-> restartWideband (theGroup. centre, theChannelizer);
+	auto startTime	= std::chrono::steady_clock::now ();
+
+	bool anyEnsemble	= false;
+	for (int i = 0; i < nrBlocks; i ++) {
+	   print_fileHeader (outFile, jsonOutput);
+	   found. push_back (identifyEnsemble (contexts [i], theDevice,
+	                                       timeSyncTime, freqSyncTime,
+	                                       offline, startTime));
+	   anyEnsemble	= anyEnsemble || found [i];
+//	the dwell of a block starts when it is identified, as in
+//	handleChannel, not when the blocks before it are done
+	   deadline. push_back (channelTime (contexts [i] -> theRadio,
+	                                     offline, startTime) + duration);
+	}
+
+	if (dumping && anyEnsemble) {
+	   std::string fileName = dumpName (theDevice,
+	                                    "wide " + theGroup. channels [0],
+	                                    contexts [0] -> ensembleId ());
+	   fprintf (stderr, "fileName = %s\n", fileName. c_str ());
+	   theDevice -> startDumping (fileName);
+	}
+
+	run. store (true);
+	for (int i = 0; i < nrBlocks; i ++) {
+	   if (!found [i])
+	      continue;
+	   int snr	= collectTii (contexts [i], theDevice, deadline [i],
+	                              dumping, offline, startTime);
+	   printEnsemble (contexts [i],
+	                  dabBand. Frequency (theBand, theGroup. channels [i]),
+	                  snr,
+	                  outFile, jsonOutput, &firstEnsemble,
+	                  contexts [i] -> tiiCodes ());
+	}
+
+	if (theChannelizer -> overflows () > 0)
+	   fprintf (stderr, "channelizer: %d times samples lost\n",
+	                             theChannelizer -> overflows ());
+	theDevice ->  stopDumping	();
+	theDevice	-> stopReader	();
+	for (int i = 0; i < nrBlocks; i ++) {
+	   printThroughput (contexts [i] -> theRadio,
+	                    theGroup. channels [i], startTime);
+	   delete contexts [i];
+	}
+//	the channelizer threads may still write into the buffers
+	delete theChannelizer;
+	for (int i = 0; i < nrBlocks; i ++)
+	   delete buffers [i];
+}
+
+//
+//	Scanning with more devices: a thread per device takes channels
+//	from the scheduler until none are left, a device that has done
+//	its own share takes over channels of the others. The reports are
+//	written to memory and merged in the order of the channel list
+void	scanDevices   (const std::vector<deviceHandler *> &devices,
+	               const std::vector<RingBuffer<std::complex<float>> *> &buffers,
+	               const std::vector<std::string> &channelList,
+	               uint8_t		theMode,
+	               uint8_t		theBand,
+	               int		timeSyncTime,
+	               int		freqSyncTime,
+	               int		duration,
+	               FILE		*outFile,
+	               bool		jsonOutput,
+	               bool		dumping,
+	               bool		offline) {
+int	nrDevices	= devices. size ();
+scanScheduler	theScheduler (channelList. size (), nrDevices);
+std::vector<std::string>	reports (channelList. size ());
+std::vector<double>		busy (nrDevices, 0);
+std::vector<std::thread>	pool;
+
+	for (int d = 0; d < nrDevices; d ++)
+	   pool. push_back (std::thread ([&, d] () {
+	      auto startTime	= std::chrono::steady_clock::now ();
+	      int i;
+	      while (theScheduler. next (d, &i)) {
+	         char	*text	= nullptr;
+	         size_t	size	= 0;
+	         FILE	*report	= open_memstream (&text, &size);
+	         if (report == nullptr)
+	            continue;
+	         handleChannel (devices [d], buffers [d], theMode, theBand,
+	                        channelList [i], timeSyncTime, freqSyncTime,
+	                        duration, report, jsonOutput, true,
+	                        dumping, offline);
+	         fclose (report);
+	         reports [i]	= std::string (text, size);
+	         free (text);
+	      }
+	      std::chrono::duration<double> elapsed =
+	                    std::chrono::steady_clock::now () - startTime;
+	      busy [d]	= elapsed. count ();
+	   }));
+	for (int d = 0; d < nrDevices; d ++)
+	   pool [d]. join ();
+
+	for (int i = 0; i < (int)reports. size (); i ++)
+	   fputs (reports [i]. c_str (), outFile);
+	for (int d = 0; d < nrDevices; d ++)
+	   fprintf (stderr, "device %d: %d channels (%d taken over) in %.1f s\n",
+	                     d, theScheduler. handedOut (d),
+	                     theScheduler. stolen (d), busy [d]);
+}
+
+//
+//	The device owner: the samples are taken from the buffer as they
+//	come and put into the shared memory ring. The ring does not wait
+//	for its readers, so neither does the device.
+#define	SHM_SIZE	(32 * 32768)
+void	publishStream (deviceHandler	*theDevice,
+	               RingBuffer<std::complex<float>> *b,
+	               const std::string &name,
+	               uint8_t		theBand,
+	               const std::string &theChannel) {
+bandHandler	dabBand;
+int32_t	frequency	= dabBand. Frequency (theBand, theChannel);
+shmRing	*theRing;
+int64_t	published	= 0;
+auto	lastReport	= std::chrono::steady_clock::now ();
+
+	try {
+	   theRing	= new shmRing (name, SHM_SIZE, INPUT_RATE,
+	                               theDevice -> bitDepth (), frequency);
+	}
+	catch (int e) {
+	   fprintf (stderr, "cannot publish on %s (%d)\n", name. c_str (), e);
+	   return;
+	}
+	fprintf (stderr, "publishing %s (%d) on %s\n", theChannel. c_str (),
+	                  frequency, theRing -> name (). c_str ());
+	run. store (true);
+	theDevice -> restartReader (frequency);
+	while (run. load ()) {
+	   if (!b -> WaitForReadAvailable (2048, 100)) {
+	      if (theDevice -> endReached () &&
+	          (b -> GetRingBufferReadAvailable () == 0))
+	         break;
+	      continue;
+	   }
+	   void	*data1, *data2;
+	   int32_t size1, size2;
+	   int32_t n = b -> GetRingBufferReadRegions (
+	                            b -> GetRingBufferReadAvailable (),
+	                            &data1, &size1, &data2, &size2);
+	   theRing -> put (static_cast<std::complex<float> *>(data1), size1);
+	   theRing -> put (static_cast<std::complex<float> *>(data2), size2);
+	   b -> AdvanceRingBufferReadIndex (n);
+	   published	+= n;
+	   if (std::chrono::steady_clock::now () - lastReport >
+	                                    std::chrono::seconds (10)) {
+	      fprintf (stderr, "%s: %lld samples published\n",
+	                        theRing -> name (). c_str (),
+	                        (long long)published);
+	      lastReport	= std::chrono::steady_clock::now ();
+	   }
+	}
+	fprintf (stderr, "%s: %lld samples published, stopping\n",
+	                  theRing -> name (). c_str (), (long long)published);
+	delete theRing;
+}
 
 void    printOptions (void) {
 	std::cerr << 
 "                          schannel scanner options are\n"
 "	                  -F filename write text output to file\n"
 "	                  -R for channel with data, dump raw output\n"
-"	                  -T Duration\tstop after <Duration> seconds\n"
+"	                  -T Duration\tstop after at most <Duration> seconds\n"
 "	                  -M Mode\tMode is 1, 2 or 4. Default is Mode 1\n"
 "	                  -B Band\tBand is either L_BAND or BAND_III (default)\n"
-"	                  -D number\tamount of time to look for an ensemble\n"
-"	                  -d number\tseconds to reach time sync\n"
+"	                  -D number\tmaximum time (seconds) to look for an ensemble\n"
+"	                  -d number\tmaximum time (seconds) to reach time sync\n"
 "	                  -C Channel, add channel to list of channels\n"
+"	                  -W wideband: decode groups of adjacent channels\n"
+"	                     at once (airspy, wideband uff files)\n"
+"	                  -N number\tscan with <number> devices in parallel\n"
+"	                     (rtlsdr sticks by index, replay devices)\n"
+"	                  -Z name\tdo not scan, publish the samples of the\n"
+"	                     channel (-C) in shared memory <name>\n"
+"	                  -r name\tthe resampler to 2048000 (pluto, airspy,\n"
+"	                     uff files): polyphase (default) or libsamplerate\n"
+"	                  -f fused front end: convert, resample and correct\n"
+"	                     the samples in one pass, in the device thread\n"
+"	                     (not with -R)\n"
+"	                  -c compact buffer: keep the samples as int8/int16\n"
+"	                     between device and decoder (not with -f, -R, -Z)\n"
+"	                  -E effort\tplanning of the FFTs: estimate (default),\n"
+"	                     measure or patient\n"
+"	                  -w file\tfftw wisdom, read at startup and written\n"
+"	                     when new plans are made (implies -E measure)\n"
 "	for rtlsdr:\n"
 "	                  -G Gain in dB (range 0 .. 100)\n"
 "	                  -Q autogain (default off)\n"
@@ -603,5 +1306,372 @@ void    printOptions (void) {
 "	for limesdr:\n"
 "                         -G number\t gain\n"
 "                         -X antenna selection\n"
-"                         -C channel\n";
+"                         -C channel\n"
+"	for uff files:\n"
+"	                  -i filename\tthe uff file to replay, when given more\n"
+"	                     than once the files are analyzed in parallel\n"
+"	                  -I directory\tanalyze all uff files in the directory\n"
+"	                  -j number\tnumber of files (or chunks) analyzed in\n"
+"	                     parallel (default the number of cores)\n"
+"	                  -S number\tsplit a (long) file into <number> chunks,\n"
+"	                     decoded in parallel\n"
+"	                  -P process as fast as possible (default paced),\n"
+"	                     -d, -D and -T then count seconds of signal\n"
+"	                  -C the channel the file was recorded on\n"
+"	for the synthetic signal:\n"
+"	                  -n number\tstop after <number> frames (default endless)\n"
+"	                  -P process as fast as possible (default paced)\n"
+"	for a shared memory stream:\n"
+"	                  -s name\tthe stream, as published with -Z\n"
+"	                     (default dab-iq)\n";
+}
+
+#ifdef	HAVE_UFF
+//
+//	The batch analyzer: each file gets its own pipeline (buffer,
+//	file handler and processor), a pool of workers takes the files
+//	in turn. The reports are written to memory and merged, in the
+//	order of the files, when all files are done
+static
+void	addDirectory	(const std::string &dirName,
+	                 std::vector<std::string> &fileList) {
+DIR	*dir	= opendir (dirName. c_str ());
+std::vector<std::string> names;
+
+	if (dir == nullptr) {
+	   fprintf (stderr, "cannot open directory %s\n", dirName. c_str ());
+	   return;
+	}
+	struct dirent *entry;
+	while ((entry = readdir (dir)) != nullptr) {
+	   std::string name	= entry -> d_name;
+	   if ((name. size () > 4) &&
+	       (name. compare (name. size () - 4, 4, ".uff") == 0))
+	      names. push_back (name);
+	}
+	closedir (dir);
+	std::sort (names. begin (), names. end ());
+	std::string prefix	= dirName. back () == '/' ? dirName :
+	                                                   dirName + "/";
+	for (int i = 0; i < (int)names. size (); i ++)
+	   fileList. push_back (prefix + names [i]);
+}
+
+static
+std::string	analyzeFile	(const std::string &fileName,
+	                	 uint8_t	theMode,
+	                	 uint8_t	theBand,
+	                	 const std::string &defaultChannel,
+	                	 int		sampleMode,
+	                	 int		timeSyncTime,
+	                	 int		freqSyncTime,
+	                	 int		duration,
+	                	 bool		jsonOutput,
+	                	 fileThroughput	*result) {
+RingBuffer<std::complex<float>> theBuffer (bufferSize (sampleMode), true);
+bandHandler	dabBand;
+char	*text	= nullptr;
+size_t	size	= 0;
+FILE	*report	= open_memstream (&text, &size);
+
+	result -> name		= fileName;
+	result -> samples	= 0;
+	result -> frames	= 0;
+	result -> seconds	= 0;
+	result -> ensemble	= false;
+	if (report == nullptr)
+	   return "";
+	try {
+	   uffFileHandler theFile (&theBuffer, fileName, false, sampleMode);
+	   std::string theChannel =
+	              dabBand. channelFor (theBand, theFile. fileFrequency ());
+	   if (theChannel == "")
+	      theChannel = defaultChannel;
+	   if (theChannel == "")
+	      fprintf (stderr, "%s: %d is not a DAB channel, use -C\n",
+	                        fileName. c_str (), theFile. fileFrequency ());
+	   else
+	      handleChannel (&theFile, &theBuffer, theMode, theBand,
+	                     theChannel, timeSyncTime, freqSyncTime, duration,
+	                     report, jsonOutput, true, false, true, result);
+	}
+	catch (int e) {
+	   fprintf (stderr, "%s: cannot be analyzed (%d)\n",
+	                                   fileName. c_str (), e);
+	}
+	fclose (report);
+	std::string res (text, size);
+	free (text);
+	return res;
+}
+
+static
+void	analyzeFiles	(const std::vector<std::string> &fileList,
+	                 int		workers,
+	                 uint8_t	theMode,
+	                 uint8_t	theBand,
+	                 const std::string &theChannel,
+	                 int		sampleMode,
+	                 int		timeSyncTime,
+	                 int		freqSyncTime,
+	                 int		duration,
+	                 bool		jsonOutput) {
+int	nrFiles	= fileList. size ();
+std::vector<std::string>	reports (nrFiles);
+std::vector<fileThroughput>	results (nrFiles);
+std::vector<std::thread>	pool;
+std::atomic<int>		next (0);
+
+	if (workers < 1)
+	   workers = 1;
+	if (workers > nrFiles)
+	   workers = nrFiles;
+	fprintf (stderr, "analyzing %d files with %d workers\n",
+	                                       nrFiles, workers);
+	auto startTime	= std::chrono::steady_clock::now ();
+	for (int w = 0; w < workers; w ++)
+	   pool. push_back (std::thread ([&] () {
+	      int i;
+	      while ((i = next. fetch_add (1)) < nrFiles)
+	         reports [i] = analyzeFile (fileList [i], theMode, theBand,
+	                                    theChannel, sampleMode,
+	                                    timeSyncTime, freqSyncTime,
+	                                    duration, jsonOutput,
+	                                    &results [i]);
+	   }));
+	for (int w = 0; w < workers; w ++)
+	   pool [w]. join ();
+	std::chrono::duration<double> elapsed =
+	                    std::chrono::steady_clock::now () - startTime;
+
+	for (int i = 0; i < nrFiles; i ++)
+	   fputs (reports [i]. c_str (), outFile);
+	print_throughput (outFile, jsonOutput, results,
+	                  elapsed. count (), workers);
+}
+//
+//	A long recording can be decoded in chunks, each chunk on its own
+//	pipeline. The chunks start at a null symbol, found by a quick
+//	look at the signal power, they start half a frame early since
+//	the processor skips half a frame before looking for the dip.
+//	Since acquiring sync costs a few frames, a chunk extends
+//	CHUNK_OVERLAP frames into the next one. The CIF counts of the first
+//	and last frame of the chunks then tell which frames were decoded
+//	twice and whether frames were missed.
+#define	CHUNK_OVERLAP	3
+#define	CIF_MODULO	5000
+
+//
+//	the context of a chunk is made once its file is open, the reader
+//	gets the front end of the file handler (if any). Without a
+//	context (the file could not be opened) *ctxp stays nullptr
+static
+void	decodeChunk	(const std::string &fileName,
+	                 int64_t	first,
+	                 int64_t	count,
+	                 int32_t	frequency,
+	                 const std::string &channel,
+	                 uint8_t	theMode,
+	                 int		sampleMode,
+	                 RingBuffer<std::complex<float>> *buffer,
+	                 scanContext	**ctxp,
+	                 chunkResult	*result) {
+scanContext	*ctx	= nullptr;
+	result -> first		= first;
+	result -> samples	= 0;
+	result -> frames	= 0;
+	result -> seconds	= 0;
+	result -> cifFirst	= -1;
+	result -> cifLast	= -1;
+	result -> snr		= 0;
+	result -> overlap	= 0;
+	result -> lost		= 0;
+	*ctxp	= nullptr;
+	try {
+	   uffFileHandler theFile (buffer, fileName, false, sampleMode);
+	   theFile. setRange (first, count);
+	   ctx	= new scanContext (channel, buffer, theMode,
+	                           theFile. getFrontEnd (),
+	                           theFile. getCompact ());
+	   *ctxp	= ctx;
+	   auto startTime	= std::chrono::steady_clock::now ();
+	   ctx -> theRadio -> start ();
+	   theFile. restartReader (frequency);
+//	the processor waits for samples, so when the file is at its end
+//	and the sample count does not change anymore, the chunk is done
+	   int64_t lastCount	= -1;
+	   int	stalls		= 0;
+	   while (stalls < 50) {
+	      usleep (1000);
+	      int64_t consumed = ctx -> theRadio -> get_sampleCount ();
+	      if (theFile. endReached () && (consumed == lastCount))
+	         stalls ++;
+	      else
+	         stalls = 0;
+	      lastCount	= consumed;
+	   }
+	   ctx -> theRadio -> stop ();
+	   std::chrono::duration<double> elapsed =
+	                    std::chrono::steady_clock::now () - startTime;
+	   result -> samples	= count;
+	   result -> frames	= ctx -> theRadio -> get_frameCount ();
+	   result -> seconds	= elapsed. count ();
+	}
+	catch (int e) {
+	   fprintf (stderr, "%s: chunk at %lld cannot be decoded (%d)\n",
+	                     fileName. c_str (), (long long)first, e);
+	}
+	if (ctx == nullptr)
+	   return;
+	cifRange r;
+	ctx -> theRadio -> get_cifRange (&r);
+	result -> cifFirst	= r. first;
+	result -> cifLast	= r. last;
+	result -> snr		= ctx -> theRadio -> get_snr ();
+}
+//
+//	the distance in CIFs from a to b, the CIF count wraps
+static
+int32_t	cifDistance	(int32_t a, int32_t b) {
+int32_t	d	= ((b - a) % CIF_MODULO + CIF_MODULO) % CIF_MODULO;
+	return d > CIF_MODULO / 2 ? d - CIF_MODULO : d;
+}
+
+static
+void	analyzeChunks	(const std::string &fileName,
+	                 int		nrChunks,
+	                 int		workers,
+	                 uint8_t	theMode,
+	                 uint8_t	theBand,
+	                 const std::string &theChannel,
+	                 int		sampleMode,
+	                 bool		jsonOutput) {
+RingBuffer<std::complex<float>> probeBuffer (32768);
+bandHandler	dabBand;
+dabParams	params (theMode);
+int64_t		total;
+int32_t		rate;
+int32_t		fileFreq;
+std::vector<int64_t>	starts;
+
+	try {
+	   uffFileHandler probe (&probeBuffer, fileName, false);
+	   total	= probe. fileSamples ();
+	   rate		= probe. fileRate ();
+	   fileFreq	= probe. fileFrequency ();
+	   int64_t frameLength	= (int64_t)params. get_T_F () * rate / INPUT_RATE;
+	   int32_t nullLength	= (int64_t)params. get_T_null () * rate / INPUT_RATE;
+	   if (total < 2 * nrChunks * frameLength)
+	      nrChunks	= std::max ((int64_t)1, total / (2 * frameLength));
+	   starts. push_back (0);
+	   for (int k = 1; k < nrChunks; k ++) {
+	      int64_t null = probe. findNull (k * total / nrChunks,
+	                                      frameLength, nullLength);
+	      starts. push_back (std::max ((int64_t)0,
+	                             null - frameLength / 2 - nullLength));
+	   }
+	   starts. push_back (total);
+	}
+	catch (int e) {
+	   fprintf (stderr, "%s cannot be opened (%d)\n", fileName. c_str (), e);
+	   return;
+	}
+
+	std::string channel	= theChannel != "" ? theChannel :
+	                              dabBand. channelFor (theBand, fileFreq);
+	if (channel == "") {
+	   fprintf (stderr, "%s: %d is not a DAB channel, use -C\n",
+	                             fileName. c_str (), fileFreq);
+	   return;
+	}
+	int32_t	frequency	= dabBand. Frequency (theBand, channel);
+	int64_t	overlap		= (int64_t)CHUNK_OVERLAP *
+	                                 params. get_T_F () * rate / INPUT_RATE;
+	std::vector<RingBuffer<std::complex<float>> *> buffers;
+	std::vector<scanContext *>	contexts;
+	std::vector<chunkResult>	results (nrChunks);
+	std::vector<std::thread>	pool;
+	std::atomic<int>		next (0);
+
+	for (int k = 0; k < nrChunks; k ++) {
+	   buffers. push_back (new RingBuffer<std::complex<float>>
+	                                 (bufferSize (sampleMode), true));
+	   contexts. push_back (nullptr);
+	}
+	workers	= std::max (1, std::min (workers, nrChunks));
+	fprintf (stderr, "decoding %s in %d chunks with %d workers\n",
+	                           fileName. c_str (), nrChunks, workers);
+	auto startTime	= std::chrono::steady_clock::now ();
+	for (int w = 0; w < workers; w ++)
+	   pool. push_back (std::thread ([&] () {
+	      int k;
+	      while ((k = next. fetch_add (1)) < nrChunks) {
+	         int64_t end = std::min (total, starts [k + 1] + overlap);
+	         decodeChunk (fileName, starts [k], end - starts [k],
+	                      frequency, channel, theMode, sampleMode,
+	                      buffers [k], &contexts [k], &results [k]);
+	      }
+	   }));
+	for (int w = 0; w < workers; w ++)
+	   pool [w]. join ();
+	std::chrono::duration<double> elapsed =
+	                    std::chrono::steady_clock::now () - startTime;
+//
+//	the merge: in file order, the CIF counts of adjacent chunks
+//	give the overlap (or the gap)
+	int32_t	cifsPerFrame	= std::max (1, params. get_T_F () /
+	                                          (INPUT_RATE * 24 / 1000));
+	int	previous	= -1;
+	int	best		= -1;
+	int64_t	snrSum		= 0;
+	int32_t	frameSum	= 0;
+	std::vector<int> tii_data;
+	for (int k = 0; k < nrChunks; k ++) {
+	   chunkResult &c = results [k];
+	   snrSum	+= (int64_t)c. snr * c. frames;
+	   frameSum	+= c. frames;
+	   if (contexts [k] == nullptr)
+	      continue;
+	   if ((best < 0) || (contexts [k] -> programNames (). size () >
+	                      contexts [best] -> programNames (). size ()))
+	      best	= k;
+	   std::vector<int> codes = contexts [k] -> tiiCodes ();
+	   for (int i = 0; i < (int)codes. size (); i ++)
+	      if (std::find (tii_data. begin (), tii_data. end (),
+	                                  codes [i]) == tii_data. end ())
+	         tii_data. push_back (codes [i]);
+	   if (c. cifFirst < 0)
+	      continue;
+	   if (previous >= 0) {
+	      int32_t d	= cifDistance (results [previous]. cifLast,
+	                               c. cifFirst);
+	      int32_t frames	= (d + (d >= 0 ? 1 : -1) * cifsPerFrame / 2) /
+	                                                      cifsPerFrame;
+	      if (frames <= 0)
+	         c. overlap	= std::min (c. frames, 1 - frames);
+	      else
+	         c. lost	= frames - 1;
+	   }
+	   previous	= k;
+	}
+
+	print_fileHeader (outFile, jsonOutput);
+	if ((best >= 0) && (contexts [best] -> ensembleName () != "")) {
+	   bool firstEnsemble	= true;
+	   printEnsemble (contexts [best], frequency,
+	                  frameSum > 0 ? snrSum / frameSum : 0,
+	                  outFile, jsonOutput, &firstEnsemble, tii_data);
+	}
+	else {
+	   fprintf (stderr, "%s: no ensemble found\n", fileName. c_str ());
+	   print_fileFooter (outFile, jsonOutput);
+	}
+	print_chunks (outFile, jsonOutput, results,
+	              elapsed. count (), workers);
+
+	for (int k = 0; k < nrChunks; k ++) {
+	   delete contexts [k];
+	   delete buffers [k];
+	}
 }
+#endif
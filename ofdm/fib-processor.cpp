@@ -24,6 +24,7 @@
  */
 #include	"fib-processor.h"
 #include	<cstring>
+#include	<algorithm>
 #include	"charsets.h"
 //
 //
@@ -155,6 +156,7 @@ void	fib_processor::process_FIG0 (uint8_t *d) {
 uint8_t	extension	= getBits_5 (d, 8 + 3);
 //uint8_t	CN	= getBits_1 (d, 8 + 0);
 
+	fig0Seen	|= 1u << extension;
 	switch (extension) {
 	   case 0:
 	      FIG0Extension0 (d);
@@ -283,8 +285,6 @@ uint8_t	CN	= getBits_1 (d, 8 + 0);
 
 	(void)CN;
 	changeflag	= getBits_2 (d, 16 + 16);
-	if (changeflag == 0)
-	   return;
 
 	EId			= getBits (d, 16, 16);
 	(void)EId;
@@ -297,6 +297,9 @@ uint8_t	CN	= getBits_1 (d, 8 + 0);
 
 	CIFcount = highpart * 250 + lowpart;
 	hasCIFcount = true;
+//	the CIF count is needed anyway, a change is only announced
+	if (changeflag == 0)
+	   return;
 
 	if (getBits (d, 34, 1))         // only alarm, just ignore
 	   return;
@@ -422,6 +425,7 @@ int16_t		numberofComponents;
 
 	numberofComponents	= getBits_4 (d, lOffset + 4);
 	lOffset	+= 8;
+	findServiceId (SId) -> announced = true;
 
 	for (i = 0; i < numberofComponents; i ++) {
 	   uint8_t	TMid	= getBits_2 (d, lOffset);
@@ -894,6 +898,7 @@ char		label [17];
 	extension	= getBits_3 (d, 8 + 5); 
 	label [16] = 0;
 	(void)Rfu;
+	fig1Seen	|= 1 << extension;
 	switch (extension) {
 /*
 	   default:
@@ -917,6 +922,7 @@ char		label [17];
 	            firstTime	= false;
 	            isSynced	= true;
 	         }
+	         endofCycle ();
 	      }
 //	      fprintf (stderr,
 //	               "charset %d is used for ensemblename\n", charSet);
@@ -1063,6 +1069,7 @@ int16_t	i;
 	for (i = 0; i < 64; i ++)
 	   if (!listofServices [i]. inUse) {
 	      listofServices [i]. inUse = true;
+	      listofServices [i]. announced = false;
 	      listofServices [i]. serviceLabel. hasName = false;
 	      listofServices [i]. serviceId = serviceId;
 	      listofServices [i]. language = -1;
@@ -1222,12 +1229,86 @@ int16_t i;
 	memset (subChannels, 0, sizeof (subChannels));
 	for (i = 0; i < 64; i ++) {
 	   listofServices [i]. inUse = false;
+	   listofServices [i]. announced = false;
 	   listofServices [i]. serviceId = -1;
 	   listofServices [i]. serviceLabel. label = "";
 	   ServiceComps [i]. inUse	= false;
 	   subChannels [i]. inUse	= false;
 	}
 	firstTime	= true;
+	fig0Seen	= 0;
+	fig1Seen	= 0;
+	memset (&status, 0, sizeof (status));
+}
+//
+//	A service is complete when it has a label and its primary
+//	component is bound, i.e. for audio to a subchannel (bind_audioService
+//	checks that), for packet data through a FIG0/3
+void	fib_processor::computeStatus	(ensembleStatus *s) {
+	s -> announced		= 0;
+	s -> labelled		= 0;
+	s -> complete		= 0;
+	s -> subChannels	= 0;
+	for (int i = 0; i < 64; i ++)
+	   if (subChannels [i]. inUse)
+	      s -> subChannels ++;
+
+	for (int i = 0; i < 64; i ++) {
+	   serviceId *service	= &listofServices [i];
+	   if (!service -> inUse || !service -> announced)
+	      continue;
+	   s -> announced ++;
+	   if (!service -> serviceLabel. hasName)
+	      continue;
+	   s -> labelled ++;
+	   for (int j = 0; j < 64; j ++) {
+	      serviceComponent *comp = &ServiceComps [j];
+	      if (!comp -> inUse || (comp -> service != service) ||
+	                                     (comp -> componentNr != 0))
+	         continue;
+	      if ((comp -> TMid == 0) || comp -> is_madePublic)
+	         s -> complete ++;
+	      break;
+	   }
+	}
+	s -> fig0Seen	= fig0Seen;
+	s -> fig1Seen	= fig1Seen;
+}
+//
+//	The ensemble label (FIG 1/0) is repeated regularly, we use
+//	its repetition as the "cycle" in which all FIGs describing
+//	the ensemble should have been transmitted
+void	fib_processor::endofCycle	() {
+ensembleStatus	current;
+
+	computeStatus (&current);
+	if ((current. announced == status. announced) &&
+	    (current. labelled  == status. labelled) &&
+	    (current. complete  == status. complete) &&
+	    (current. subChannels == status. subChannels) &&
+	    (current. fig0Seen  == status. fig0Seen) &&
+	    (current. fig1Seen  == status. fig1Seen))
+	   current. stableCycles = status. stableCycles + 1;
+	else
+	   current. stableCycles = 0;
+
+	bool allComplete = (current. announced > 0) &&
+	                   (current. complete == current. announced);
+	if (allComplete)
+	   current. confidence = 50 + 25 * std::min ((int)current. stableCycles, 2);
+	else
+	   current. confidence = current. announced == 0 ? 0 :
+	                        50 * current. complete / current. announced;
+	current. databaseComplete = allComplete && (current. stableCycles >= 1);
+	status	= current;
+	if (allComplete)
+	   ensembleComplete (current. confidence);
+}
+
+void	fib_processor::get_ensembleStatus	(ensembleStatus *s) {
+	fibLocker. lock ();
+	*s	= status;
+	fibLocker. unlock ();
 }
 
 std::string fib_processor::nameFor (int32_t serviceId) {
@@ -1445,6 +1526,13 @@ void	fib_processor::nameofEnsemble  (int id, const std::string &s) {
 	isSynced	= true;
 }
 
+void	fib_processor::ensembleComplete	(int16_t confidence) {
+	fibLocker. unlock ();
+	if (the_callBacks -> completeHandler != nullptr)
+	   the_callBacks -> completeHandler (confidence, userData);
+	fibLocker. lock ();
+}
+
 void	fib_processor::changeinConfiguration (void) {
 }
 
@@ -44,6 +44,7 @@
 //	from FIG1/2
 	struct serviceid {
 	   bool		inUse;
+	   bool		announced;	// seen in FIG0/2
 	   uint32_t	serviceId;
 	   dabLabel	serviceLabel;
 	   bool		hasPNum;
@@ -108,6 +109,7 @@ public:
 	void	dataforDataService	(const std::string &, packetdata *, int16_t);
 
 	void	reset			();
+	void	get_ensembleStatus	(ensembleStatus *);
 	int32_t get_CIFcount            (void) const;
         bool    has_CIFcount            (void) const;
         void    newFrame                (void);
@@ -183,9 +185,17 @@ private:
 	bool		isSynced;
 	mutex		fibLocker;
 //
+//	for tracking the completeness of the database
+	uint32_t	fig0Seen;
+	uint8_t		fig1Seen;
+	ensembleStatus	status;
+	void		computeStatus	(ensembleStatus *);
+	void		endofCycle	();
+//
 //	these were signals
 	void		addtoEnsemble	(const std::string &, int32_t);
 	void		nameofEnsemble  (int, const std::string &);
+	void		ensembleComplete (int16_t);
 	void		changeinConfiguration (void);
 };
 
@@ -237,6 +237,10 @@ int32_t ficHandler::SIdFor      (const std::string &name) {
         return fibProcessor. SIdFor (name);
 }
 
+void	ficHandler::get_ensembleStatus	(ensembleStatus *s) {
+	fibProcessor. get_ensembleStatus (s);
+}
+
 void	ficHandler::reset	(void) {
 	fibProcessor. reset ();
 }
@@ -52,6 +52,7 @@ public:
 	int32_t	get_CIFcount		() const;
 	bool	has_CIFcount		() const;
 	int32_t	SIdFor			(const std::string &);
+	void	get_ensembleStatus	(ensembleStatus *);
 	void	reset			();
 private:
 	callbacks	*the_callBacks;
@@ -36,6 +36,8 @@
 	ofdmDecoder::ofdmDecoder	(uint8_t	dabMode):
 	                                     params (dabMode),
 	                                     my_fftHandler (dabMode),
+	                                     my_batchHandler (dabMode,
+	                                                      FIC_SYMBOLS),
 	                                     myMapper    (dabMode) {
 
 	this	-> T_s			= params. get_T_s ();
@@ -44,16 +46,24 @@
 	this	-> carriers		= params. get_carriers ();
 	this	-> T_g			= T_s - T_u;
 	fft_buffer			= my_fftHandler. getVector ();
+	batch_buffer			= my_batchHandler. getVector ();
 	phaseReference. resize (T_u);
 }
 
 	ofdmDecoder::~ofdmDecoder	(void) {
 }
 
+std::complex<float>	*ofdmDecoder::fftInput	() {
+	return fft_buffer;
+}
+
 void	ofdmDecoder::processBlock_0 (std::complex<float> *buffer) {
 	memcpy (fft_buffer, buffer,
 	                      T_u * sizeof (std::complex<float>));
+	processBlock_0 ();
+}
 
+void	ofdmDecoder::processBlock_0 () {
 	my_fftHandler. do_FFT ();
 /**
   *	we are now in the frequency domain, and we keep the carriers
@@ -65,17 +75,36 @@ void	ofdmDecoder::processBlock_0 (std::complex<float> *buffer) {
 
 void	ofdmDecoder::decode (std::complex<float> *buffer,
 	                             int32_t blkno, int16_t *ibits) {
-int16_t	i;
-std::complex<float> conjVector [T_u];
-
       memcpy (fft_buffer, &(buffer[T_g]),
                                        T_u * sizeof (std::complex<float>));
+      decode (blkno, ibits);
+}
 
+void	ofdmDecoder::decode (int32_t blkno, int16_t *ibits) {
 //fftlabel:
 /**
   *	first step: do the FFT
   */
 	my_fftHandler. do_FFT ();
+	toBits (fft_buffer, ibits);
+}
+
+std::complex<float>	*ofdmDecoder::batchInput	(int16_t k) {
+	return &batch_buffer [k * T_u];
+}
+//
+//	one plan for all FIC symbols, fftw does them together
+void	ofdmDecoder::transformBatch	() {
+	my_batchHandler. do_FFT ();
+}
+
+void	ofdmDecoder::decodeBatch	(int16_t k, int16_t *ibits) {
+	toBits (&batch_buffer [k * T_u], ibits);
+}
+
+void	ofdmDecoder::toBits	(const std::complex<float> *spectrum,
+	                         int16_t *ibits) {
+int16_t	i;
 /**
   *	a little optimization: we do not interchange the
   *	positive/negative frequencies to their right positions.
@@ -96,8 +125,7 @@ std::complex<float> conjVector [T_u];
   *	The carrier of a block is the reference for the carrier
   *	on the same position in the next block
   */
-	   std::complex<float>	r1 = fft_buffer [index] * conj (phaseReference [index]);
-           conjVector [index] = r1;
+	   std::complex<float>	r1 = spectrum [index] * conj (phaseReference [index]);
 //	The viterbi decoder expects values in the range 0 .. 255,
 //	we present values -127 .. 127 (easy with depuncturing)
 	   float ab1		= abs (r1);
@@ -106,6 +134,6 @@ std::complex<float> conjVector [T_u];
 	}
 
 	memcpy (phaseReference. data (),
-	          fft_buffer, T_u * sizeof (std::complex<float>));
+	          spectrum, T_u * sizeof (std::complex<float>));
 }
 
@@ -33,6 +33,9 @@
 #include	"fft_handler.h"
 
 class	dabParams;
+//
+//	the symbols following block 0 that carry the FIC (modes 1, 2, 4)
+#define	FIC_SYMBOLS	3
 
 class	ofdmDecoder {
 public:
@@ -41,9 +44,22 @@ public:
 	void	processBlock_0		(std::complex<float> *);
 	void	decode			(std::complex<float> *,
 	                                            int32_t n, int16_t *);
+//	the (fftw allocated) input of the FFT, when the T_u samples
+//	of a block are put there, the variants without a buffer
+//	decode them in place
+	std::complex<float>	*fftInput	();
+	void	processBlock_0		();
+	void	decode			(int32_t n, int16_t *);
+//	the FIC symbols of a frame are collected, the T_u samples of
+//	symbol k (0 .. FIC_SYMBOLS - 1) go to batchInput (k), and are
+//	transformed in one go, then decoded one by one, in order
+	std::complex<float>	*batchInput	(int16_t k);
+	void	transformBatch		();
+	void	decodeBatch		(int16_t k, int16_t *);
 private:
 	dabParams	params;
 	fft_handler	my_fftHandler;
+	fft_handler	my_batchHandler;
 	interLeaver	myMapper;
 	int32_t		T_s;
 	int32_t		T_u;
@@ -52,6 +68,9 @@ private:
 	int32_t		nrBlocks;
 	std::vector <complex<float> >	phaseReference;
 	std::complex<float>	*fft_buffer;
+	std::complex<float>	*batch_buffer;
+	void	toBits			(const std::complex<float> *,
+	                                 int16_t *);
 };
 
 #endif
@@ -24,23 +24,27 @@
 #include	"sample-reader.h"
 #include	"device-handler.h"
 #include	"dab-processor.h"
-
-static
-std::complex<float> oscillatorTable [INPUT_RATE];
+#include	"front-end.h"
+#include	"compact-buffer.h"
+#include	<string.h>
 
 	sampleReader::sampleReader (dabProcessor *parent,
-	                            RingBuffer<std::complex<float>> *buffer
-	                           ) {
-int	i;
+	                            RingBuffer<std::complex<float>> *buffer,
+	                            frontEnd *theFrontEnd,
+	                            compactBuffer *theCompact) {
 	theParent		= parent;
 	this	-> _I_Buffer	= buffer;
 	currentPhase		= 0;
 	sLevel			= 0;
 	sampleCount		= 0;
-	for (i = 0; i < INPUT_RATE; i ++)
-	   oscillatorTable [i] = std::complex<float>
-	                            (cos (2.0 * M_PI * i / INPUT_RATE),
-	                             sin (2.0 * M_PI * i / INPUT_RATE));
+	totalSamples. store (0);
+	waitNs			= 0;
+	this	-> theFrontEnd	= theFrontEnd;
+	applied			= 0;
+	residualPhase		= 0;
+	lastOffset		= 0;
+	pending			= false;
+	this	-> theCompact	= theCompact;
 
 	corrector	= 0;
 	dumpfilePointer. store (nullptr);
@@ -57,15 +61,61 @@ void	sampleReader::reset	(void) {
 	currentPhase            = 0;
 	sLevel                  = 0;
 	sampleCount             = 0;
+	totalSamples. store (0);
+	waitNs			= 0;
 }
 
 void	sampleReader::setRunning (bool b) {
 	running. store (b);
+	if (b)
+	   return;
+	if (theCompact != nullptr)
+	   theCompact -> wakeAll ();
+	else
+	   _I_Buffer -> WakeAll ();
 }
 
+//
+//	with a front end the level is measured while writing, it is
+//	ahead of what we read by the amount of data in the buffer
 float	sampleReader::get_sLevel (void) {
+	if (theFrontEnd != nullptr)
+	   return theFrontEnd -> level ();
 	return sLevel;
 }
+//
+//	the number of samples taken from the buffer since the last reset,
+//	offline processing uses it as its clock
+int64_t	sampleReader::get_totalSamples (void) {
+	return totalSamples. load ();
+}
+//
+//	the time spent waiting for samples since the previous call,
+//	to be called from the thread reading the samples
+int64_t	sampleReader::get_waitTime	(void) {
+int64_t	res	= waitNs;
+	waitNs	= 0;
+	return res;
+}
+
+void	sampleReader::waitFor	(int32_t n) {
+std::chrono::steady_clock::time_point start =
+	                              std::chrono::steady_clock::now ();
+	if (theCompact != nullptr)
+	   while (running. load () &&
+	         !theCompact -> waitForReadAvailable (n, 10));
+	else
+	   while (running. load () &&
+	         !_I_Buffer -> WaitForReadAvailable (n, 10));
+	waitNs	+= std::chrono::duration_cast<std::chrono::nanoseconds>
+	             (std::chrono::steady_clock::now () - start). count ();
+}
+
+int32_t	sampleReader::readAvailable	() {
+	if (theCompact != nullptr)
+	   return theCompact -> readAvailable ();
+	return _I_Buffer -> GetRingBufferReadAvailable ();
+}
 
 std::complex<float> sampleReader::getSample (int32_t phaseOffset) {
 std::complex<float> temp;
@@ -73,14 +123,18 @@ std::complex<float> temp;
 	if (!running. load ())
 	   throw 21;
 
-	while (running. load () &&
-	      (_I_Buffer -> GetRingBufferReadAvailable () < 2048))
-	      usleep (100);
+	if (readAvailable () < 2048)
+	   waitFor (2048);
 
 	if (!running. load ())	
 	   throw 20;
 //
-	_I_Buffer -> getDataFromBuffer (&temp, 1);
+	uint64_t position	= _I_Buffer -> ReadPosition ();
+	if (theCompact != nullptr)
+	   theCompact -> get (&temp, 1);
+	else
+	   _I_Buffer -> getDataFromBuffer (&temp, 1);
+	totalSamples. fetch_add (1);
 
 	if (dumpfilePointer. load () != nullptr) {
 	   dumpBuffer [2 * dumpIndex + 1] = imag (temp) * dumpScale;
@@ -92,14 +146,19 @@ std::complex<float> temp;
         }
 
 //	OK, we have a sample!!
-//	first: adjust frequency. We need Hz accuracy
+//	first: adjust frequency. We need Hz accuracy.
+//	A sample from the front end is corrected already, only its
+//	magnitude is used here, so we keep the correction as it is
+	if (theFrontEnd != nullptr) {
+	   std::complex<float> raw	= temp;
+	   correct (&raw, &temp, 1, lastOffset, position);
+	   return temp;
+	}
 	if (phaseOffset != 0) {
-	   currentPhase	-= phaseOffset;
-	   currentPhase	= (currentPhase + INPUT_RATE) % INPUT_RATE;
-
-	   temp		*= oscillatorTable [currentPhase];
+	   std::complex<float> raw	= temp;
+	   rotate (&raw, &temp, 1, phaseOffset);
 	}
-	sLevel		= 0.00001 * jan_abs (temp) + (1 - 0.00001) * sLevel;
+	sLevel		= LEVEL_ALPHA * jan_abs (temp) + (1 - LEVEL_ALPHA) * sLevel;
 #define	N	5
 	sampleCount	++;
 	if (++ sampleCount > INPUT_RATE / N) {
@@ -111,41 +170,60 @@ std::complex<float> temp;
 
 void	sampleReader::getSamples (std::complex<float>  *v,
 	                          int32_t n, int32_t Offset) {
-int32_t		i;
-
-	while (running. load () &&
-	       (_I_Buffer -> GetRingBufferReadAvailable () < n))
-	   usleep (100);
+	if (readAvailable () < n)
+	   waitFor (n);
 
 	if (!running. load ())	
 	   throw 20;
+	if (theCompact != nullptr) {
+	   getCompact (v, n, Offset);
+	   return;
+	}
 //
-	n = _I_Buffer -> getDataFromBuffer (v, n);
-
-	 if (dumpfilePointer. load() != nullptr) {
-           for (i = 0; i < n; i ++) {
-              dumpBuffer [2 * dumpIndex    ] = real (v [i]) * dumpScale;
-              dumpBuffer [2 * dumpIndex + 1] = imag (v [i]) * dumpScale;
-              if (++dumpIndex >= DUMPSIZE / 2) {
-                 sf_writef_short (dumpfilePointer. load(),
-                                  dumpBuffer, dumpIndex);
-                 dumpIndex = 0;
-              }
-           }
-        }
+//	The samples are not copied out of the buffer first, the NCO
+//	reads them from the buffer regions and writes them into v, so
+//	v may well be the input of an FFT. The regions are released
+//	when we are done with them
+void	*data1, *data2;
+int32_t	size1, size2;
+	n = _I_Buffer -> GetRingBufferReadRegions (n, &data1, &size1,
+	                                              &data2, &size2);
+std::complex<float> *region1	= static_cast<std::complex<float> *>(data1);
+std::complex<float> *region2	= static_cast<std::complex<float> *>(data2);
+
+	if (dumpfilePointer. load() != nullptr) {
+	   dump (region1, size1);
+	   dump (region2, size2);
+	}
 
 //	OK, we have samples!!
-//	first: adjust frequency. We need Hz accuracy
-	for (i = 0; i < n; i ++) {
-	   if (Offset != 0) {
-	      currentPhase	-= Offset;
-//
-//	Note that "phase" itself might be negative
-	      currentPhase	= (currentPhase + INPUT_RATE) % INPUT_RATE;
-	      v [i]	*= oscillatorTable [currentPhase];
+//	first: adjust frequency. We need Hz accuracy.
+//	With a front end we only correct what it did not do (yet),
+//	and ask it to take over if there is something left
+	if (theFrontEnd != nullptr) {
+	   uint64_t position	= _I_Buffer -> ReadPosition ();
+	   correct (region1, v, size1, Offset, position);
+	   correct (region2, &v [size1], size2, Offset, position + size1);
+	   _I_Buffer -> AdvanceRingBufferReadIndex (n);
+	   totalSamples. fetch_add (n);
+	   lastOffset	= Offset;
+	   if (!pending && ((Offset != applied) || (residualPhase != 0))) {
+	      theFrontEnd -> request (Offset, position + n, residualPhase);
+	      pending	= true;
 	   }
-	   sLevel	= 0.00001 * jan_abs (v [i]) + (1 - 0.00001) * sLevel;
+	   return;
+	}
+	if (Offset != 0) {
+	   rotate (region1, v, size1, Offset);
+	   rotate (region2, &v [size1], size2, Offset);
 	}
+	else {
+	   memcpy (v, region1, size1 * sizeof (std::complex<float>));
+	   memcpy (&v [size1], region2, size2 * sizeof (std::complex<float>));
+	}
+	_I_Buffer -> AdvanceRingBufferReadIndex (n);
+	totalSamples. fetch_add (n);
+	updateLevel (v, n);
 
 	sampleCount	+= n;
 	if (sampleCount > INPUT_RATE / N) {
@@ -153,6 +231,96 @@ int32_t		i;
 	   sampleCount = 0;
 	}
 }
+//
+//	Compact samples are converted in blocks that stay in L1, the
+//	NCO then reads them from there. Without offset they are
+//	converted into v directly
+void	sampleReader::getCompact	(std::complex<float> *v,
+	                                 int32_t n, int32_t Offset) {
+	for (int32_t done = 0; done < n; ) {
+	   int32_t m	= n - done < COMPACT_BLOCK ? n - done : COMPACT_BLOCK;
+	   std::complex<float> *in = Offset != 0 ? compactBlock : &v [done];
+	   m	= theCompact -> get (in, m);
+//	nothing there, e.g. flushed or stopped after the wait in getSamples
+	   if (m == 0) {
+	      waitFor (n - done);
+	      if (!running. load ())
+	         throw 20;
+	      continue;
+	   }
+	   if (dumpfilePointer. load () != nullptr)
+	      dump (in, m);
+	   if (Offset != 0)
+	      rotate (in, &v [done], m, Offset);
+	   done	+= m;
+	}
+	totalSamples. fetch_add (n);
+	updateLevel (v, n);
+}
+//
+//	sample i (from 0) is multiplied by exp (j * 2 * PI * phase / INPUT_RATE),
+//	with phase = currentPhase - (i + 1) * offset, as the table based
+//	version did. in and out do not overlap
+void	sampleReader::rotate	(const std::complex<float> *in,
+	                         std::complex<float> *out,
+	                         int32_t n, int32_t offset) {
+	nco_rotate (in, out, n, offset, currentPhase);
+}
+//
+//	sLevel = alpha * |v [i]| + (1 - alpha) * sLevel for all samples
+void	sampleReader::updateLevel	(const std::complex<float> *v,
+	                                 int32_t n) {
+	sLevel	= level_update (v, n, sLevel);
+}
+//
+//	n samples from position on, the front end corrected them with
+//	"applied", we do (offset - applied). The changes the front end
+//	made are picked up when we get at their position, the phase it
+//	took over from us is no longer ours
+void	sampleReader::correct	(const std::complex<float> *in,
+	                         std::complex<float> *out,
+	                         int32_t n, int32_t offset,
+	                         uint64_t position) {
+frontEnd::change c;
+
+	while (n > 0) {
+	   int32_t m	= n;
+	   bool changing	= theFrontEnd -> nextChange (&c);
+	   if (changing && (c. position < position + m))
+	      m	= c. position > position ? c. position - position : 0;
+	   if ((offset != applied) || (residualPhase != 0))
+	      nco_rotate (in, out, m, offset - applied, residualPhase);
+	   else
+	      memcpy (out, in, m * sizeof (std::complex<float>));
+	   in		+= m;
+	   out		+= m;
+	   n		-= m;
+	   position	+= m;
+	   if (changing && (c. position <= position)) {
+	      applied	= c. offset;
+	      residualPhase = ((residualPhase - c. absorbed) % INPUT_RATE +
+	                                       INPUT_RATE) % INPUT_RATE;
+	      pending	= false;
+	      theFrontEnd -> popChange ();
+	   }
+	}
+}
+
+//
+//	the raw samples, as they come from the device (with a front end
+//	they are corrected already)
+void	sampleReader::dump	(const std::complex<float> *v, int32_t n) {
+	for (int i = 0; i < n; i ++) {
+	   dumpBuffer [2 * dumpIndex    ] = real (v [i]) * dumpScale;
+	   dumpBuffer [2 * dumpIndex + 1] = imag (v [i]) * dumpScale;
+	   if (++dumpIndex >= DUMPSIZE / 2) {
+	      sf_writef_short (dumpfilePointer. load(),
+	                       dumpBuffer, dumpIndex);
+	      dumpIndex = 0;
+	   }
+	}
+}
+
 static
 int	scales [] =
 	{1, 2, 4, 8, 16, 32, 64, 128, 256, 512,
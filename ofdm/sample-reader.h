@@ -31,23 +31,33 @@
 #include	<stdint.h>
 #include	<atomic>
 #include	<vector>
+#include	<chrono>
 #include	<sndfile.h>
 #include	"ringbuffer.h"
 //
 
 class	deviceHandler;
+class	frontEnd;
+class	compactBuffer;
 class	dabProcessor;
 
 #define	DUMPSIZE	4096
+#define	COMPACT_BLOCK	1024
 
 class	sampleReader {
 public:
+//	with a front end, it is the one the device writes the buffer through,
+//	with compact storage the samples come from theCompact, not the buffer
 			sampleReader	(dabProcessor *,
-	                                 RingBuffer<std::complex<float>> *buffer);
+	                                 RingBuffer<std::complex<float>> *buffer,
+	                                 frontEnd *theFrontEnd = nullptr,
+	                                 compactBuffer *theCompact = nullptr);
 
 			~sampleReader	();
 		void	setRunning	(bool b);
 		float	get_sLevel	(void);
+		int64_t	get_totalSamples	(void);
+		int64_t	get_waitTime	(void);
 	        void	reset		(void);
 		std::complex<float> getSample	(int32_t);
 	        void	getSamples	(std::complex<float> *v,
@@ -57,10 +67,38 @@ public:
 private:
 		dabProcessor	*theParent;
 	        RingBuffer<std::complex<float>> *_I_Buffer;
+//	with a (fused) front end, the samples in the buffer are corrected
+//	with "applied", we correct the difference, with residualPhase
+		frontEnd	*theFrontEnd;
+		int32_t		applied;
+		int32_t		residualPhase;
+		int32_t		lastOffset;
+		bool		pending;
+		void		correct		(const std::complex<float> *,
+	                                 std::complex<float> *,
+	                                 int32_t n, int32_t offset,
+	                                 uint64_t position);
+//	with compact storage the samples come from theCompact, in
+//	blocks converted into compactBlock
+		compactBuffer	*theCompact;
+		std::complex<float>	compactBlock [COMPACT_BLOCK];
+		void		getCompact	(std::complex<float> *,
+	                                 int32_t n, int32_t offset);
+		int32_t		readAvailable	();
 		int32_t		currentPhase;
 		std::atomic<bool>	running;
 		float		sLevel;
 		int32_t		sampleCount;
+		std::atomic<int64_t>	totalSamples;
+		int64_t		waitNs;
+		void		waitFor		(int32_t);
+		void		rotate		(const std::complex<float> *,
+	                                 std::complex<float> *,
+	                                 int32_t n, int32_t offset);
+		void		dump		(const std::complex<float> *,
+	                                 int32_t n);
+		void		updateLevel	(const std::complex<float> *,
+	                                 int32_t n);
 	        int32_t		corrector;
 		bool		dumping;
                 int16_t		dumpIndex;
@@ -0,0 +1,138 @@
+#
+/*
+ *    Copyright (C) 2020
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of channelScanner
+ *
+ *    channelScanner is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    channelScanner is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with channelScanner; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include	"scan-context.h"
+#include	"dab-processor.h"
+#include	<stdio.h>
+#include	<algorithm>
+
+	scanContext::scanContext	(const std::string &channel,
+	                                 RingBuffer<std::complex<float>> *b,
+	                                 uint8_t dabMode,
+	                                 frontEnd *theFrontEnd,
+	                                 compactBuffer *theCompact) {
+	this	-> channel	= channel;
+	this	-> buffer	= b;
+	theEnsembleId		= 0;
+	timeSynced.		store (false);
+	ensembleRecognized.	store (false);
+
+	theCallbacks. signalHandler		= syncsignalHandler;
+	theCallbacks. ensembleHandler		= ensembleHandler;
+	theCallbacks. programnameHandler	= programnameHandler;
+	theCallbacks. tiiHandler		= tiiHandler;
+	theCallbacks. completeHandler		= completeHandler;
+	theRadio	= new dabProcessor (b, dabMode, &theCallbacks, this,
+	                                    theFrontEnd, theCompact);
+}
+
+	scanContext::~scanContext	() {
+	theRadio	-> stop ();
+	delete theRadio;
+}
+
+std::string	scanContext::ensembleName	() {
+std::lock_guard<std::mutex> lck (locker);
+	return theEnsemble;
+}
+
+uint32_t	scanContext::ensembleId	() {
+std::lock_guard<std::mutex> lck (locker);
+	return theEnsembleId;
+}
+
+std::vector<std::string>	scanContext::programNames	() {
+std::lock_guard<std::mutex> lck (locker);
+	return theNames;
+}
+
+std::vector<int>	scanContext::programSIds	() {
+std::lock_guard<std::mutex> lck (locker);
+	return theSIds;
+}
+//
+//	the (different) TII codes seen, (mainId << 8) | subId
+std::vector<int>	scanContext::tiiCodes	() {
+std::lock_guard<std::mutex> lck (locker);
+	return theTii;
+}
+//
+//	the callbacks, called from the processor thread,
+//	signal the events the scanner is waiting for
+void	scanContext::syncsignalHandler	(bool b, void *userData) {
+scanContext *ctx	= static_cast<scanContext *>(userData);
+	ctx -> timeSynced. store (b);
+	if (b)
+	   ctx -> events. signal (EVENT_TIMESYNC);
+}
+
+void	scanContext::ensembleHandler	(std::string name, int Id,
+	                                 void *userData) {
+scanContext *ctx	= static_cast<scanContext *>(userData);
+	fprintf (stderr, "ensemble %s is (%X) recognized\n",
+	                          name. c_str (), (uint32_t)Id);
+	ctx -> locker. lock ();
+	ctx -> theEnsemble	= name;
+	ctx -> theEnsembleId	= Id;
+	ctx -> locker. unlock ();
+	ctx -> ensembleRecognized. store (true);
+	ctx -> events. signal (EVENT_ENSEMBLE);
+}
+
+void	scanContext::programnameHandler	(std::string s, int SId,
+	                                 void *userData) {
+scanContext *ctx	= static_cast<scanContext *>(userData);
+	ctx -> locker. lock ();
+	for (int i = 0; i < (int)(ctx -> theNames. size ()); i ++)
+	   if (ctx -> theNames [i] == s) {
+	      ctx -> locker. unlock ();
+	      return;
+	   }
+	ctx -> theNames. push_back (s);
+	ctx -> theSIds.  push_back (SId);
+	ctx -> locker. unlock ();
+	fprintf (stderr, "program %s is part of the ensemble\n", s. c_str ());
+	ctx -> events. signal (EVENT_SERVICE);
+}
+
+void	scanContext::tiiHandler	(int16_t mainId, int16_t subId,
+	                         unsigned num, void *userData) {
+scanContext *ctx	= static_cast<scanContext *>(userData);
+int	tii	= (mainId << 8) | subId;
+	(void)num;
+	ctx -> locker. lock ();
+	if (std::find (ctx -> theTii. begin (), ctx -> theTii. end (), tii) ==
+	                                          ctx -> theTii. end ())
+	   ctx -> theTii. push_back (tii);
+	ctx -> locker. unlock ();
+	ctx -> events. signal (EVENT_TII);
+}
+//
+//	the database is taken as complete when it did not change during
+//	a repetition of the ensemble label
+void	scanContext::completeHandler	(int16_t confidence, void *userData) {
+scanContext *ctx	= static_cast<scanContext *>(userData);
+	if (confidence >= 75)
+	   ctx -> events. signal (EVENT_COMPLETE);
+}
+
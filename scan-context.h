@@ -0,0 +1,86 @@
+#
+/*
+ *    Copyright (C) 2020
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of channelScanner
+ *
+ *    channelScanner is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    channelScanner is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with channelScanner; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *	A scanContext owns the state of one pipeline: the processor,
+ *	the callbacks, the events and what the callbacks collect
+ *	(ensemble name and id, the services). The callbacks get the
+ *	context as userData, there is no global state, so any number
+ *	of pipelines can run side by side in one process.
+ */
+#ifndef	__SCAN_CONTEXT__
+#define	__SCAN_CONTEXT__
+
+#include	<stdint.h>
+#include	<string>
+#include	<vector>
+#include	<mutex>
+#include	<atomic>
+#include	<complex>
+#include	"dab-api.h"
+#include	"ringbuffer.h"
+#include	"channel-events.h"
+
+class	dabProcessor;
+class	frontEnd;
+class	compactBuffer;
+
+class	scanContext {
+public:
+//	theFrontEnd and theCompact are those of the device writing the
+//	buffer, if any
+			scanContext	(const std::string &channel,
+	                                 RingBuffer<std::complex<float>> *,
+	                                 uint8_t dabMode,
+	                                 frontEnd *theFrontEnd = nullptr,
+	                                 compactBuffer *theCompact = nullptr);
+			~scanContext	();
+	std::string	channel;
+	RingBuffer<std::complex<float>>	*buffer;
+	dabProcessor	*theRadio;
+	channelEvents	events;
+	std::atomic<bool>	timeSynced;
+	std::atomic<bool>	ensembleRecognized;
+
+	std::string	ensembleName	();
+	uint32_t	ensembleId	();
+	std::vector<std::string> programNames	();
+	std::vector<int>	programSIds	();
+	std::vector<int>	tiiCodes	();
+private:
+	callbacks	theCallbacks;
+	std::mutex	locker;
+	std::string	theEnsemble;
+	uint32_t	theEnsembleId;
+	std::vector<std::string> theNames;
+	std::vector<int>	theSIds;
+	std::vector<int>	theTii;
+
+static	void		syncsignalHandler	(bool, void *);
+static	void		ensembleHandler		(std::string, int, void *);
+static	void		programnameHandler	(std::string, int, void *);
+static	void		tiiHandler		(int16_t, int16_t,
+	                                         unsigned, void *);
+static	void		completeHandler		(int16_t, void *);
+};
+
+#endif
+
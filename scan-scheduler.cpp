@@ -0,0 +1,74 @@
+#
+/*
+ *    Copyright (C) 2020
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of channelScanner
+ *
+ *    channelScanner is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    channelScanner is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with channelScanner; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include	"scan-scheduler.h"
+
+	scanScheduler::scanScheduler	(int nrChannels, int nrDevices) {
+	if (nrDevices < 1)
+	   nrDevices = 1;
+	queues. resize (nrDevices);
+	taken.  resize (nrDevices, 0);
+	steals. resize (nrDevices, 0);
+//	device i gets channels [i * n / d .. (i + 1) * n / d)
+	for (int i = 0; i < nrDevices; i ++)
+	   for (int j = i * nrChannels / nrDevices;
+	        j < (i + 1) * nrChannels / nrDevices; j ++)
+	      queues [i]. push_back (j);
+}
+
+	scanScheduler::~scanScheduler	() {
+}
+
+bool	scanScheduler::next	(int device, int *channel) {
+std::lock_guard<std::mutex> lck (locker);
+
+	if (!queues [device]. empty ()) {
+	   *channel	= queues [device]. front ();
+	   queues [device]. pop_front ();
+	   taken [device] ++;
+	   return true;
+	}
+//
+//	steal from the back, the owner works from the front
+int	victim	= -1;
+	for (int i = 0; i < (int)queues. size (); i ++)
+	   if ((victim < 0) || (queues [i]. size () > queues [victim]. size ()))
+	      victim = i;
+	if ((victim < 0) || queues [victim]. empty ())
+	   return false;
+	*channel	= queues [victim]. back ();
+	queues [victim]. pop_back ();
+	taken  [device] ++;
+	steals [device] ++;
+	return true;
+}
+
+int32_t	scanScheduler::handedOut	(int device) {
+std::lock_guard<std::mutex> lck (locker);
+	return taken [device];
+}
+
+int32_t	scanScheduler::stolen		(int device) {
+std::lock_guard<std::mutex> lck (locker);
+	return steals [device];
+}
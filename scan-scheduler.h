@@ -0,0 +1,53 @@
+#
+/*
+ *    Copyright (C) 2020
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of channelScanner
+ *
+ *    channelScanner is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    channelScanner is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with channelScanner; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *	With more than one device the channels are handed out by a
+ *	scheduler. Each device starts with its own share (a run of
+ *	adjacent channels) of the list, a device that has scanned its
+ *	own share steals channels from the end of the largest share
+ *	left, so all devices stay busy until the list is done.
+ */
+#ifndef	__SCAN_SCHEDULER__
+#define	__SCAN_SCHEDULER__
+
+#include	<stdint.h>
+#include	<vector>
+#include	<deque>
+#include	<mutex>
+
+class	scanScheduler {
+public:
+//	the channels are given by their index in the channel list
+			scanScheduler	(int nrChannels, int nrDevices);
+			~scanScheduler	();
+//	the next channel for the device, false when all are handed out
+	bool		next		(int device, int *channel);
+	int32_t		handedOut	(int device);
+	int32_t		stolen		(int device);
+private:
+	std::mutex	locker;
+	std::vector<std::deque<int>>	queues;
+	std::vector<int32_t>	taken;
+	std::vector<int32_t>	steals;
+};
+
+#endif
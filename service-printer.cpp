@@ -200,10 +200,59 @@ void	print_dataService (FILE	*f,
 	}
 }
 
-void	print_ensembleFooter (FILE *f, bool jsonOutput) {
+//
+//	the time per frame spent in the stages of the dabProcessor,
+//	the histograms count frames with a time (in microseconds)
+//	in [2^(i - 1) .. 2^i)
+void	print_stageTimes (FILE *f, bool jsonOutput,
+	                  dabProcessor *theRadio) {
+stageStatistics	s;
+float	frameDuration	= theRadio -> get_frameDuration ();
+
+	theRadio -> get_stageStatistics (&s);
+	if (s. frames == 0)
+	   return;
+
+	if (!jsonOutput) {
+	   fprintf (f, "\n\nProcessing time per frame (%d frames, frame duration %.0f us)\nstage;mean (us);max (us);load (%%);histogram (bucket:frames)\n\n",
+	                    s. frames, frameDuration);
+	   for (int i = 0; i < NR_STAGES; i ++) {
+	      float mean	= s. totalNs [i] / 1000.0 / s. frames;
+	      fprintf (f, "%s;%.1f;%.1f;%.1f;",
+	                  stageName (i), mean, s. maxNs [i] / 1000.0,
+	                  100 * mean / frameDuration);
+	      for (int j = 0; j < HISTOGRAM_SIZE; j ++)
+	         if (s. histogram [i][j] != 0)
+	            fprintf (f, " %d:%d", j, s. histogram [i][j]);
+	      fprintf (f, ";\n");
+	   }
+	   return;
+	}
+
+	fprintf (f, ",\n        \"stageTimes\": { \"frames\": %d, \"frameDuration\": %.0f, \"stages\": [\n",
+	            s. frames, frameDuration);
+	for (int i = 0; i < NR_STAGES; i ++) {
+	   fprintf (f, "            { \"stage\": \"%s\", \"mean\": %.1f, \"max\": %.1f, \"histogram\": [",
+	               stageName (i),
+	               s. totalNs [i] / 1000.0 / s. frames,
+	               s. maxNs [i] / 1000.0);
+	   for (int j = 0; j < HISTOGRAM_SIZE; j ++)
+	      fprintf (f, "%d%s", s. histogram [i][j],
+	                          j < HISTOGRAM_SIZE - 1 ? ", " : "");
+	   fprintf (f, "] }%s\n", i < NR_STAGES - 1 ? "," : "");
+	}
+	fprintf (f, "        ] }");
+}
+
+void	print_ensembleFooter (FILE *f, bool jsonOutput,
+	                      dabProcessor *theRadio) {
 	if (jsonOutput) {
-	   fprintf (f, "\n        }\n    }");
+	   fprintf (f, "\n        }");
+	   print_stageTimes (f, jsonOutput, theRadio);
+	   fprintf (f, "\n    }");
 	}
+	else
+	   print_stageTimes (f, jsonOutput, theRadio);
 }
 
 void	print_fileFooter (FILE *f, bool jsonOutput) {
@@ -212,3 +261,101 @@ void	print_fileFooter (FILE *f, bool jsonOutput) {
 	}
 }
 
+//
+//	the per file numbers of a batch run, the last line gives
+//	the totals, with the time being the wall clock time of the batch
+void	print_throughput (FILE *f, bool jsonOutput,
+	                  const std::vector<fileThroughput> &results,
+	                  double wallTime, int workers) {
+int64_t	totalSamples	= 0;
+int32_t	totalFrames	= 0;
+int	ensembles	= 0;
+
+	for (int i = 0; i < (int)results. size (); i ++) {
+	   totalSamples	+= results [i]. samples;
+	   totalFrames	+= results [i]. frames;
+	   if (results [i]. ensemble)
+	      ensembles ++;
+	}
+	if (wallTime <= 0)
+	   wallTime = 1e-6;
+
+	if (!jsonOutput) {
+	   fprintf (f, "\n\nThroughput (%d files, %d workers)\nfile;channel;ensemble;samples;frames;seconds;samples/s;x realtime\n\n",
+	               (int)results. size (), workers);
+	   for (int i = 0; i < (int)results. size (); i ++) {
+	      const fileThroughput &r = results [i];
+	      double secs	= r. seconds > 0 ? r. seconds : 1e-6;
+	      fprintf (f, "%s;%s;%s;%lld;%d;%.2f;%.0f;%.1f;\n",
+	                  r. name. c_str (), r. channel. c_str (),
+	                  r. ensemble ? "yes" : "no",
+	                  (long long)r. samples, r. frames, r. seconds,
+	                  r. samples / secs,
+	                  r. samples / secs / INPUT_RATE);
+	   }
+	   fprintf (f, "total;;%d;%lld;%d;%.2f;%.0f;%.1f;\n",
+	               ensembles, (long long)totalSamples, totalFrames,
+	               wallTime, totalSamples / wallTime,
+	               totalSamples / wallTime / INPUT_RATE);
+	   return;
+	}
+
+	fprintf (f, "{\n    \"throughput\": { \"files\": %d, \"workers\": %d, \"ensembles\": %d, \"samples\": %lld, \"frames\": %d, \"seconds\": %.2f, \"results\": [\n",
+	            (int)results. size (), workers, ensembles,
+	            (long long)totalSamples, totalFrames, wallTime);
+	for (int i = 0; i < (int)results. size (); i ++) {
+	   const fileThroughput &r = results [i];
+	   fprintf (f, "        { \"file\": \"%s\", \"channel\": \"%s\", \"ensemble\": %s, \"samples\": %lld, \"frames\": %d, \"seconds\": %.2f }%s\n",
+	               r. name. c_str (), r. channel. c_str (),
+	               r. ensemble ? "true" : "false",
+	               (long long)r. samples, r. frames, r. seconds,
+	               i < (int)results. size () - 1 ? "," : "");
+	}
+	fprintf (f, "    ] }\n}\n");
+}
+//
+//	the chunks of a recording decoded in parallel, the last
+//	line gives the totals, frames decoded twice counted once
+void	print_chunks (FILE *f, bool jsonOutput,
+	              const std::vector<chunkResult> &chunks,
+	              double wallTime, int workers) {
+int64_t	totalSamples	= 0;
+int32_t	totalFrames	= 0;
+int32_t	totalLost	= 0;
+
+	for (int i = 0; i < (int)chunks. size (); i ++) {
+	   totalSamples	+= chunks [i]. samples;
+	   totalFrames	+= chunks [i]. frames - chunks [i]. overlap;
+	   totalLost	+= chunks [i]. lost;
+	}
+	if (wallTime <= 0)
+	   wallTime = 1e-6;
+
+	if (!jsonOutput) {
+	   fprintf (f, "\n\nChunks (%d chunks, %d workers)\nchunk;first sample;samples;frames;first CIF;last CIF;SNR;overlap;lost;seconds;\n\n",
+	               (int)chunks. size (), workers);
+	   for (int i = 0; i < (int)chunks. size (); i ++) {
+	      const chunkResult &c = chunks [i];
+	      fprintf (f, "%d;%lld;%lld;%d;%d;%d;%d;%d;%d;%.2f;\n",
+	                  i, (long long)c. first, (long long)c. samples,
+	                  c. frames, c. cifFirst, c. cifLast, c. snr,
+	                  c. overlap, c. lost, c. seconds);
+	   }
+	   fprintf (f, "total;;%lld;%d;;;;;%d;%.2f;\n",
+	               (long long)totalSamples, totalFrames,
+	               totalLost, wallTime);
+	   return;
+	}
+
+	fprintf (f, "{\n    \"chunks\": { \"workers\": %d, \"frames\": %d, \"lost\": %d, \"seconds\": %.2f, \"results\": [\n",
+	            workers, totalFrames, totalLost, wallTime);
+	for (int i = 0; i < (int)chunks. size (); i ++) {
+	   const chunkResult &c = chunks [i];
+	   fprintf (f, "        { \"first\": %lld, \"samples\": %lld, \"frames\": %d, \"firstCIF\": %d, \"lastCIF\": %d, \"snr\": %d, \"overlap\": %d, \"lost\": %d, \"seconds\": %.2f }%s\n",
+	               (long long)c. first, (long long)c. samples,
+	               c. frames, c. cifFirst, c. cifLast, c. snr,
+	               c. overlap, c. lost, c. seconds,
+	               i < (int)chunks. size () - 1 ? "," : "");
+	}
+	fprintf (f, "    ] }\n}\n");
+}
@@ -25,6 +25,33 @@
 #include	"dab_tables.h"
 #include	"dab-api.h"
 class	dabProcessor;
+//
+//	in batch mode, the result of decoding one file
+class	fileThroughput {
+public:
+	std::string	name;
+	std::string	channel;
+	int64_t		samples;
+	int32_t		frames;
+	double		seconds;
+	bool		ensemble;
+};
+//
+//	when a recording is decoded in chunks, the result of one chunk,
+//	overlap and lost are derived from the CIF counts of the chunk
+//	and the one before
+class	chunkResult {
+public:
+	int64_t		first;		// first sample (at the file rate)
+	int64_t		samples;
+	int32_t		frames;
+	int32_t		cifFirst;
+	int32_t		cifLast;
+	int32_t		snr;
+	double		seconds;
+	int32_t		overlap;	// frames also decoded by the previous
+	int32_t		lost;		// frames not decoded by either
+};
 
 void	print_fileHeader (FILE *f, bool jsonOutput);
 void	print_ensembleData (FILE *f, bool jsonOutput,
@@ -49,5 +76,14 @@ void	print_dataService (FILE		*f, bool jsonOutput,
 	                   uint8_t	compnr,
 	                   packetdata *d,
 		           bool *firstService);
-void	print_ensembleFooter (FILE *f, bool jsonOutput);
+void	print_stageTimes (FILE *f, bool jsonOutput,
+	                  dabProcessor *theRadio);
+void	print_ensembleFooter (FILE *f, bool jsonOutput,
+	                      dabProcessor *theRadio);
 void	print_fileFooter (FILE *f, bool jsonOutput);
+void	print_throughput (FILE *f, bool jsonOutput,
+	                  const std::vector<fileThroughput> &results,
+	                  double wallTime, int workers);
+void	print_chunks (FILE *f, bool jsonOutput,
+	              const std::vector<chunkResult> &chunks,
+	              double wallTime, int workers);
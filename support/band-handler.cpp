@@ -22,6 +22,8 @@
  */
 
 #include "band-handler.h"
+#include <algorithm>
+#include <cstdlib>
 
 struct dabFrequencies {
 	const char *key;
@@ -140,3 +142,54 @@ std::string bandHandler::nextChannel(uint8_t dabBand, std::string Channel) {
 
   return "";
 }
+
+//    the channel a recording was made on, "" if the frequency
+//    is not within 100 KHz of a channel in the band
+std::string bandHandler::channelFor(uint8_t dabBand, int32_t frequency) {
+  struct dabFrequencies *finger;
+
+  if (dabBand == BAND_III)
+    finger = bandIII_frequencies;
+  else
+    finger = Lband_frequencies;
+
+  for (int i = 0; finger[i].key != NULL; i++)
+    if (std::abs(finger[i].fKHz * 1000 - frequency) < 100000)
+      return finger[i].key;
+
+  return "";
+}
+
+//    group the channels into sets of blocks that fit within the
+//    usable part (90 percent) of a band of "rate" Hz, each set
+//    is received with one tuning, at the centre of the set
+std::vector<blockGroup> bandHandler::groupChannels(uint8_t dabBand,
+                                       std::vector<std::string> channels,
+                                       int32_t rate) {
+  std::vector<std::pair<int32_t, std::string>> blocks;
+  std::vector<blockGroup> groups;
+  int32_t maxSpan = 2 * (int32_t)(0.45 * rate - 768000);
+
+  for (int i = 0; i < (int)channels.size(); i++)
+    blocks.push_back(std::pair<int32_t, std::string>(
+                         Frequency(dabBand, channels[i]), channels[i]));
+  std::sort(blocks.begin(), blocks.end());
+
+  int first = 0;
+  while (first < (int)blocks.size()) {
+    int last = first;
+    while ((last + 1 < (int)blocks.size()) &&
+           (blocks[last + 1].first - blocks[first].first <= maxSpan))
+      last++;
+    blockGroup g;
+    g.centre = (blocks[first].first + blocks[last].first) / 2 / 1000 * 1000;
+    for (int i = first; i <= last; i++) {
+      g.channels.push_back(blocks[i].second);
+      g.offsets.push_back(blocks[i].first - g.centre);
+    }
+    groups.push_back(g);
+    first = last + 1;
+  }
+  return groups;
+}
+
@@ -25,6 +25,7 @@
 #define  __BANDHANDLER__
 #include <stdint.h>
 #include <string>
+#include <vector>
 //
 //    a simple convenience class
 //
@@ -32,12 +33,26 @@
 #define  BAND_III 0100
 #define  L_BAND   0101
 
+//
+//    in wideband mode a group of adjacent blocks shares one tuning,
+//    the offsets are the block frequencies relative to the centre
+class blockGroup {
+public:
+int32_t		centre;
+std::vector<std::string> channels;
+std::vector<int32_t> offsets;
+};
+
 class bandHandler {
 public:
 		bandHandler		(void);
 		~bandHandler		(void);
 int32_t		Frequency 		(uint8_t band, std::string Channel);
 std::string	nextChannel		(uint8_t dabBand, std::string Channel);
+std::string	channelFor		(uint8_t dabBand, int32_t frequency);
+std::vector<blockGroup> groupChannels	(uint8_t dabBand,
+	                                 std::vector<std::string> channels,
+	                                 int32_t rate);
 };
 #endif
 
@@ -0,0 +1,133 @@
+#
+/*
+ *    Copyright (C) 2020
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of channelScanner
+ *
+ *    channelScanner is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    channelScanner is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with channelScanner; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include	"channelizer.h"
+#include	"dab-constants.h"
+#include	<stdio.h>
+#include	<math.h>
+#include	<algorithm>
+
+#define	BRANCH_BUFFER	(1 << 20)
+#define	BRANCH_BLOCK	8192
+
+	channelizer::branch::branch	(int32_t inputRate, int32_t offset,
+	                                 RingBuffer<std::complex<float>> *b):
+	                                   input (BRANCH_BUFFER),
+	                                   filter (inputRate, INPUT_RATE,
+	                                           DAB_PASSBAND,
+	                                           DAB_STOPBAND) {
+	output		= b;
+	phasor		= std::complex<double> (1, 0);
+	phaseStep	= std::polar (1.0, - 2 * M_PI * offset / inputRate);
+}
+
+	channelizer::branch::~branch	() {
+}
+
+	channelizer::channelizer	(int32_t inputRate,
+	                                 const std::vector<int32_t> &offsets,
+	                                 const std::vector<RingBuffer<std::complex<float>> *> &outputs) {
+	theRate		= inputRate;
+	lost. store (0);
+	running. store (true);
+	for (int i = 0; i < (int)offsets. size (); i ++)
+	   branches. push_back (new branch (inputRate,
+	                                    offsets [i], outputs [i]));
+	for (int i = 0; i < (int)branches. size (); i ++)
+	   branches [i] -> threadHandle =
+	              std::thread (&channelizer::run, this, branches [i]);
+	if (branches. size () > 0)
+	   fprintf (stderr, "channelizer: %d branches, %d -> %d, %d taps per phase\n",
+	                     (int)branches. size (), inputRate, INPUT_RATE,
+	                     branches [0] -> filter. tapsPerPhase ());
+}
+
+	channelizer::~channelizer	() {
+	running. store (false);
+	for (int i = 0; i < (int)branches. size (); i ++) {
+	   if (branches [i] -> threadHandle. joinable ())
+	      branches [i] -> threadHandle. join ();
+	   delete branches [i];
+	}
+}
+//
+//	called from the device thread, just copying
+void	channelizer::put	(const std::complex<float> *v, int32_t n) {
+	for (int i = 0; i < (int)branches. size (); i ++) {
+	   if (branches [i] -> input. GetRingBufferWriteAvailable () < n)
+	      lost. fetch_add (1);
+	   branches [i] -> input. putDataIntoBuffer (v, n);
+	}
+}
+
+int32_t	channelizer::writeAvailable	() {
+int32_t	res	= BRANCH_BUFFER;
+	for (int i = 0; i < (int)branches. size (); i ++)
+	   res	= std::min (res,
+	                branches [i] -> input. GetRingBufferWriteAvailable ());
+	return res;
+}
+
+int32_t	channelizer::inputRate	() {
+	return theRate;
+}
+
+int32_t	channelizer::nrBranches	() {
+	return branches. size ();
+}
+
+int32_t	channelizer::overflows	() {
+	return lost. load ();
+}
+//
+//	The branch waits for room in its output buffer, so a slow
+//	decoder makes the input buffer fill up, samples are then lost
+//	in put (real time) or the device waits (file input)
+void	channelizer::run	(branch *b) {
+std::vector<std::complex<float>> inBuf (BRANCH_BLOCK);
+std::vector<std::complex<float>> outBuf (b -> filter. maxOutput (BRANCH_BLOCK));
+
+	while (running. load ()) {
+	   int32_t n = b -> input. getDataFromBuffer (inBuf. data (),
+	                                               BRANCH_BLOCK);
+	   if (n == 0) {
+	      b -> input. WaitForReadAvailable (BRANCH_BLOCK, 10);
+	      continue;
+	   }
+	   std::complex<float> ph	= std::complex<float> (b -> phasor);
+	   std::complex<float> step	= std::complex<float> (b -> phaseStep);
+	   for (int i = 0; i < n; i ++) {
+	      inBuf [i]	*= ph;
+	      ph	*= step;
+	   }
+//	the float oscillator is renormalized once per block
+	   b -> phasor	= std::complex<double> (ph) / (double)abs (ph);
+
+	   int32_t m	= b -> filter. process (inBuf. data (), n,
+	                                        outBuf. data ());
+	   while (running. load () &&
+	          !b -> output -> WaitForWriteAvailable (m, 10));
+	   b -> output -> putDataIntoBuffer (outBuf. data (), m);
+	}
+}
+
@@ -0,0 +1,76 @@
+#
+/*
+ *    Copyright (C) 2020
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of channelScanner
+ *
+ *    channelScanner is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    channelScanner is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with channelScanner; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *	The channelizer splits a wideband stream (e.g. 8 or 10 MSPS)
+ *	into a number of 2048000 samples/second streams, one for each
+ *	DAB block within the band seen by the device.
+ *	The Band III blocks are not on a regular grid, so rather than
+ *	a DFT filterbank each block has its own branch: an oscillator
+ *	shifts the block to zero, a polyphase (rational L/M) filter
+ *	filters and resamples. Each branch runs in its own thread,
+ *	the device only copies its samples into the input buffers.
+ */
+#ifndef	__CHANNELIZER__
+#define	__CHANNELIZER__
+
+#include	<stdint.h>
+#include	<complex>
+#include	<vector>
+#include	<thread>
+#include	<atomic>
+#include	"ringbuffer.h"
+#include	"resampler.h"
+
+class	channelizer {
+public:
+			channelizer	(int32_t inputRate,
+	                                 const std::vector<int32_t> &offsets,
+	                                 const std::vector<RingBuffer<std::complex<float>> *> &outputs);
+			~channelizer	();
+	void		put		(const std::complex<float> *, int32_t);
+//	the amount that can be put without losing samples
+	int32_t		writeAvailable	();
+	int32_t		inputRate	();
+	int32_t		nrBranches	();
+	int32_t		overflows	();
+private:
+	class	branch {
+	public:
+			branch		(int32_t inputRate, int32_t offset,
+	                                 RingBuffer<std::complex<float>> *);
+			~branch		();
+	   RingBuffer<std::complex<float>>	input;
+	   RingBuffer<std::complex<float>>	*output;
+	   polyphaseFilter	filter;
+	   std::complex<double>	phasor;
+	   std::complex<double>	phaseStep;
+	   std::thread	threadHandle;
+	};
+	int32_t		theRate;
+	std::vector<branch *>	branches;
+	std::atomic<bool>	running;
+	std::atomic<int32_t>	lost;
+	void		run		(branch *);
+};
+
+#endif
+
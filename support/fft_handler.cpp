@@ -22,23 +22,93 @@
  */
 #include	"fft_handler.h"
 #include	<cstring>
+#include	<cstdio>
+#include	<mutex>
+#include	<vector>
+#include	<algorithm>
+//
+//	the fftw planner is not thread safe, with several pipelines
+//	running in parallel plans are created one at a time
+static
+std::mutex	plannerLock;
+
+class	planEntry {
+public:
+	int32_t		size;
+	int16_t		howMany;
+	int		sign;
+	int		alignment;
+	fftwf_plan	plan;
+};
+
+static
+std::vector<planEntry>	plans;
+static
+unsigned	planFlags	= FFTW_ESTIMATE;
+static
+std::string	wisdomFile	= "";
+
+void	fft_handler::setPlanning	(unsigned flags,
+	                                 const std::string &fileName) {
+	std::lock_guard<std::mutex> lck (plannerLock);
+	planFlags	= flags;
+	wisdomFile	= fileName;
+	if ((wisdomFile != "") &&
+	    !fftwf_import_wisdom_from_filename (wisdomFile. c_str ()))
+	   fprintf (stderr, "no fftw wisdom in %s (yet)\n",
+	                                   wisdomFile. c_str ());
+}
+//
+//	the plans live as long as the program does. Planning may
+//	overwrite v, an in-place plan is made for the size, number of
+//	transforms (adjacent in v), direction and alignment of v
+static
+fftwf_plan	getPlan	(int32_t size, int16_t howMany,
+	                 int sign, complex<float> *v) {
+fftwf_complex	*x	= reinterpret_cast <fftwf_complex *>(v);
+int	alignment	= fftwf_alignment_of (reinterpret_cast <float *>(v));
+	std::lock_guard<std::mutex> lck (plannerLock);
+	for (int i = 0; i < (int)plans. size (); i ++)
+	   if ((plans [i]. size == size) && (plans [i]. howMany == howMany) &&
+	       (plans [i]. sign == sign) &&
+	       (plans [i]. alignment == alignment))
+	      return plans [i]. plan;
+	planEntry e;
+	e. size		= size;
+	e. howMany	= howMany;
+	e. sign		= sign;
+	e. alignment	= alignment;
+	if (howMany == 1)
+	   e. plan	= fftwf_plan_dft_1d (size, x, x, sign, planFlags);
+	else
+	   e. plan	= fftwf_plan_many_dft (1, &size, howMany,
+	                                       x, nullptr, 1, size,
+	                                       x, nullptr, 1, size,
+	                                       sign, planFlags);
+	plans. push_back (e);
+	if ((wisdomFile != "") && (planFlags != FFTW_ESTIMATE) &&
+	    !fftwf_export_wisdom_to_filename (wisdomFile. c_str ()))
+	   fprintf (stderr, "cannot write fftw wisdom to %s\n",
+	                                   wisdomFile. c_str ());
+	return e. plan;
+}
 
-	fft_handler::fft_handler (uint8_t dabMode): p (dabMode) {
+	fft_handler::fft_handler (uint8_t dabMode,
+	                          int16_t howMany): p (dabMode) {
 	int i;
 	this	-> fftSize	= p. get_T_u ();
+	this	-> howMany	= howMany;
 	vector	= (complex<float> *)
-	                fftwf_malloc (sizeof (complex<float>) * fftSize);
-	for (i = 0; i < fftSize; i ++)
+	                fftwf_malloc (sizeof (complex<float>) *
+	                                             fftSize * howMany);
+	forwardPlan	= getPlan (fftSize, howMany, FFTW_FORWARD, vector);
+	backwardPlan	= nullptr;
+	for (i = 0; i < fftSize * howMany; i ++)
 	   vector [i] = std::complex<float> (0, 0);
-	plan	= fftwf_plan_dft_1d (fftSize,
-	                            reinterpret_cast <fftwf_complex *>(vector),
-	                            reinterpret_cast <fftwf_complex *>(vector),
-	                            FFTW_FORWARD, FFTW_ESTIMATE);
 }
 
 	fft_handler::~fft_handler (void) {
-	   fftwf_destroy_plan (plan);
-	   fftwf_free (vector);
+	fftwf_free (vector);
 }
 
 complex<float>	*fft_handler::getVector () {
@@ -46,17 +116,22 @@ complex<float>	*fft_handler::getVector () {
 }
 //
 void	fft_handler::do_FFT (void) {
-	fftwf_execute (plan);
+	fftwf_execute_dft (forwardPlan,
+	                   reinterpret_cast <fftwf_complex *>(vector),
+	                   reinterpret_cast <fftwf_complex *>(vector));
 }
 
 //	Note that we do not scale in case of backwards fft,
-//	not needed for our applications
+//	not needed for our applications.
+//	Few handlers do a backward transform, it is planned on the first
+//	call. Planning may overwrite the vector, so its contents are kept
 void	fft_handler::do_iFFT (void) {
-int	i;
-	for (i = 0; i < fftSize; i ++)
-	   vector [i] = conj (vector [i]);
-	fftwf_execute (plan);
-	for (i = 0; i < fftSize; i ++)
-	   vector [i] = conj (vector [i]);
+	if (backwardPlan == nullptr) {
+	   std::vector<complex<float>> keep (vector, vector + fftSize * howMany);
+	   backwardPlan	= getPlan (fftSize, howMany, FFTW_BACKWARD, vector);
+	   std::copy (keep. begin (), keep. end (), vector);
+	}
+	fftwf_execute_dft (backwardPlan,
+	                   reinterpret_cast <fftwf_complex *>(vector),
+	                   reinterpret_cast <fftwf_complex *>(vector));
 }
-
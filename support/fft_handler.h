@@ -24,24 +24,40 @@
 #ifndef __FFT_HANDLER__
 #define	__FFT_HANDLER__
 //
-//	Simple wrapper around fftwf
+//	Simple wrapper around fftwf.
+//	The plans are shared: all handlers of a size use the same plan,
+//	the first one needing it creates it (fftw can execute a plan on
+//	other arrays of the same alignment), so a new dabProcessor
+//	(for each channel) does not plan again.
+//	With "-E measure" or "-E patient" the plans are measured, with
+//	a wisdom file (-w) that is done once, the file is written when
+//	a plan was made and read at startup.
+//	A handler for "howMany" transforms has a vector of howMany * T_u
+//	elements, do_FFT and do_iFFT transform them in one call.
+//	The backward plan is only made for a handler calling do_iFFT.
 #include	"dab-constants.h"
 #include	"dab-params.h"
 #include	<fftw3.h>
+#include	<string>
 
 
 class	fft_handler {
 public:
-			fft_handler	(uint8_t);
+			fft_handler	(uint8_t, int16_t howMany = 1);
 			~fft_handler	(void);
 	complex<float>	*getVector	(void);
 	void		do_FFT		(void);
 	void		do_iFFT		(void);
+//	to be called before the first handler is made
+static	void		setPlanning	(unsigned flags,
+	                                 const std::string &wisdomFile);
 private:
 	dabParams	p;
 	int32_t		fftSize;
+	int16_t		howMany;
 	complex<float>	*vector;
-	fftwf_plan	plan;
+	fftwf_plan	forwardPlan;
+	fftwf_plan	backwardPlan;
 };
 
 #endif
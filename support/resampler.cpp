@@ -0,0 +1,394 @@
+#
+/*
+ *    Copyright (C) 2020
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of channelScanner
+ *
+ *    channelScanner is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    channelScanner is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with channelScanner; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include	"resampler.h"
+#include	<stdio.h>
+#include	<string.h>
+#include	<math.h>
+#include	<atomic>
+
+#if defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))
+#define	RESAMPLER_X86
+#include	<immintrin.h>
+#elif defined(NEON_AVAILABLE) || defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define	RESAMPLER_NEON
+#include	<arm_neon.h>
+#endif
+
+//
+//	The inner product of K complex samples and K (real) taps.
+//	The taps are stored twice, so both are arrays of 2 * K floats,
+//	K being a multiple of 4
+typedef	std::complex<float> (*dotKernel)	(const float *c,
+	                                         const float *x, int32_t K);
+//
+//	The filter loop, one instance per inner product so the latter
+//	is inlined: outputs are computed while the position (in 1/L
+//	inputs) is within the "avail" samples of x
+typedef	int32_t	(*filterKernel)	(const float *c, const float *x,
+	                         int32_t K, int32_t L, int32_t M,
+	                         int32_t &position, int32_t avail,
+	                         std::complex<float> *out);
+
+template <dotKernel dot>
+static
+int32_t	filterLoop	(const float *c, const float *x,
+	                 int32_t K, int32_t L, int32_t M,
+	                 int32_t &position, int32_t avail,
+	                 std::complex<float> *out) {
+int32_t	produced	= 0;
+	while (position / L < avail) {
+	   const int32_t base	= position / L - (K - 1);
+	   out [produced ++]	= dot (&c [2 * (position % L) * K],
+	                               x + 2 * base, K);
+	   position	+= M;
+	}
+	return produced;
+}
+
+static inline
+std::complex<float> dot_generic	(const float *c, const float *x, int32_t K) {
+float	re	= 0;
+float	im	= 0;
+	for (int m = 0; m < K; m ++) {
+	   re	+= c [2 * m] * x [2 * m];
+	   im	+= c [2 * m] * x [2 * m + 1];
+	}
+	return std::complex<float> (re, im);
+}
+
+#ifdef	RESAMPLER_X86
+static inline
+std::complex<float> dot_sse2	(const float *c, const float *x, int32_t K) {
+__m128	acc0	= _mm_setzero_ps ();
+__m128	acc1	= _mm_setzero_ps ();
+	for (int m = 0; m < 2 * K; m += 8) {
+	   acc0	= _mm_add_ps (acc0, _mm_mul_ps (_mm_loadu_ps (c + m),
+	                                        _mm_loadu_ps (x + m)));
+	   acc1	= _mm_add_ps (acc1, _mm_mul_ps (_mm_loadu_ps (c + m + 4),
+	                                        _mm_loadu_ps (x + m + 4)));
+	}
+	acc0	= _mm_add_ps (acc0, acc1);
+//	lanes are re, im, re, im
+	acc0	= _mm_add_ps (acc0, _mm_movehl_ps (acc0, acc0));
+float	r [4];
+	_mm_storeu_ps (r, acc0);
+	return std::complex<float> (r [0], r [1]);
+}
+
+#define	AVX2	__attribute__ ((target ("avx2,fma")))
+AVX2 static inline
+std::complex<float> dot_avx2	(const float *c, const float *x, int32_t K) {
+__m256	acc	= _mm256_setzero_ps ();
+	for (int m = 0; m < 2 * K; m += 8)
+	   acc	= _mm256_fmadd_ps (_mm256_loadu_ps (c + m),
+	                           _mm256_loadu_ps (x + m), acc);
+__m128	s	= _mm_add_ps (_mm256_castps256_ps128 (acc),
+	                      _mm256_extractf128_ps (acc, 1));
+	s	= _mm_add_ps (s, _mm_movehl_ps (s, s));
+float	r [4];
+	_mm_storeu_ps (r, s);
+	return std::complex<float> (r [0], r [1]);
+}
+//
+//	the template instance would not get the target attribute
+AVX2 static
+int32_t	filterLoop_avx2	(const float *c, const float *x,
+	                 int32_t K, int32_t L, int32_t M,
+	                 int32_t &position, int32_t avail,
+	                 std::complex<float> *out) {
+int32_t	produced	= 0;
+	while (position / L < avail) {
+	   const int32_t base	= position / L - (K - 1);
+	   out [produced ++]	= dot_avx2 (&c [2 * (position % L) * K],
+	                                    x + 2 * base, K);
+	   position	+= M;
+	}
+	return produced;
+}
+#endif
+
+#ifdef	RESAMPLER_NEON
+static inline
+std::complex<float> dot_neon	(const float *c, const float *x, int32_t K) {
+float32x4_t acc0	= vdupq_n_f32 (0);
+float32x4_t acc1	= vdupq_n_f32 (0);
+	for (int m = 0; m < 2 * K; m += 8) {
+	   acc0	= vmlaq_f32 (acc0, vld1q_f32 (c + m), vld1q_f32 (x + m));
+	   acc1	= vmlaq_f32 (acc1, vld1q_f32 (c + m + 4),
+	                           vld1q_f32 (x + m + 4));
+	}
+	acc0	= vaddq_f32 (acc0, acc1);
+float32x2_t s	= vadd_f32 (vget_low_f32 (acc0), vget_high_f32 (acc0));
+	return std::complex<float> (vget_lane_f32 (s, 0),
+	                            vget_lane_f32 (s, 1));
+}
+#endif
+
+class	dotVariant {
+public:
+	const char	*name;
+	filterKernel	loop;
+};
+
+static const dotVariant genericDot	=
+	{"generic", filterLoop<dot_generic>};
+#ifdef	RESAMPLER_X86
+static const dotVariant sse2Dot		=
+	{"sse2", filterLoop<dot_sse2>};
+static const dotVariant avx2Dot		=
+	{"avx2", filterLoop_avx2};
+#endif
+#ifdef	RESAMPLER_NEON
+static const dotVariant neonDot		=
+	{"neon", filterLoop<dot_neon>};
+#endif
+
+static
+const dotVariant *bestDot	() {
+#ifdef	RESAMPLER_X86
+	__builtin_cpu_init ();
+	if (__builtin_cpu_supports ("avx2") && __builtin_cpu_supports ("fma"))
+	   return &avx2Dot;
+	return &sse2Dot;
+#elif	defined (RESAMPLER_NEON)
+	return &neonDot;
+#else
+	return &genericDot;
+#endif
+}
+//
+//	picked once, on first use
+static
+std::atomic<const dotVariant *> &theDot	() {
+static std::atomic<const dotVariant *> d (bestDot ());
+	return d;
+}
+
+const char	*resampler_variant	() {
+	return theDot (). load () -> name;
+}
+
+bool	resampler_select_variant	(const char *name) {
+const dotVariant *v	= nullptr;
+	if (name == nullptr) {
+	   theDot (). store (bestDot ());
+	   return true;
+	}
+	if (strcmp (name, "generic") == 0)
+	   v	= &genericDot;
+#ifdef	RESAMPLER_X86
+	if (strcmp (name, "sse2") == 0)
+	   v	= &sse2Dot;
+	if ((strcmp (name, "avx2") == 0) && (bestDot () == &avx2Dot))
+	   v	= &avx2Dot;
+#endif
+#ifdef	RESAMPLER_NEON
+	if (strcmp (name, "neon") == 0)
+	   v	= &neonDot;
+#endif
+	if (v == nullptr)
+	   return false;
+	theDot (). store (v);
+	return true;
+}
+
+#define	RESAMPLE_POLYPHASE	0
+#define	RESAMPLE_LIBSAMPLERATE	1
+static
+std::atomic<int>	selected (RESAMPLE_POLYPHASE);
+
+bool	resampler_select	(const std::string &s) {
+	if (s == "polyphase") {
+	   selected. store (RESAMPLE_POLYPHASE);
+	   return true;
+	}
+#ifdef	HAVE_LIBSAMPLERATE
+	if (s == "libsamplerate") {
+	   selected. store (RESAMPLE_LIBSAMPLERATE);
+	   return true;
+	}
+#endif
+	return false;
+}
+
+static
+int32_t	gcd	(int32_t a, int32_t b) {
+	while (b != 0) {
+	   int32_t t = a % b;
+	   a	= b;
+	   b	= t;
+	}
+	return a;
+}
+
+	polyphaseFilter::polyphaseFilter (int32_t inRate, int32_t outRate,
+	                                  int32_t passBand, int32_t stopBand) {
+int32_t	g	= gcd (inRate, outRate);
+	L	= outRate / g;
+	M	= inRate / g;
+//
+//	A Blackman window needs a length of about 5.5 Fs / transition,
+//	the prototype filter runs at L * inRate, so per phase the length
+//	is 5.5 * inRate / transition. K is rounded up to a multiple
+//	of 4 for the vectorized inner product
+	K	= (int32_t)ceil (5.5 * inRate / (stopBand - passBand));
+	if (K < 4)
+	   K = 4;
+	K	= (K + 3) & ~3;
+int32_t	N	= K * L;
+double	cutoff	= (passBand + stopBand) / 2.0 / ((double)L * inRate);
+
+	coefficients. resize (2 * N);
+	for (int n = 0; n < N; n ++) {
+	   double t	= n - (N - 1) / 2.0;
+	   double x	= 2 * M_PI * cutoff * t;
+	   double sinc	= t == 0 ? 1 : sin (x) / x;
+	   double w	= 0.42 - 0.5 * cos (2 * M_PI * n / (N - 1)) +
+	                         0.08 * cos (4 * M_PI * n / (N - 1));
+	   float h	= L * 2 * cutoff * sinc * w;
+//	phase p = n % L, tap n / L, stored reversed within the phase
+	   int32_t index	= (n % L) * K + (K - 1 - n / L);
+	   coefficients [2 * index]	= h;
+	   coefficients [2 * index + 1]	= h;
+	}
+	buffer. resize (K - 1, std::complex<float> (0, 0));
+	position	= (K - 1) * L;
+}
+
+	polyphaseFilter::~polyphaseFilter	() {
+}
+
+int32_t	polyphaseFilter::maxOutput	(int32_t n) {
+	return (int64_t)(n + 1) * L / M + 2;
+}
+
+int32_t	polyphaseFilter::tapsPerPhase	() {
+	return K;
+}
+//
+//	output k is computed at position k * M / L in the input,
+//	the buffer keeps the last K - 1 samples of the previous call
+int32_t	polyphaseFilter::process	(const std::complex<float> *in,
+	                                 int32_t n,
+	                                 std::complex<float> *out) {
+const filterKernel loop	= theDot (). load (std::memory_order_relaxed) -> loop;
+
+	buffer. insert (buffer. end (), in, in + n);
+int32_t	avail	= buffer. size ();
+int32_t	produced	= loop (coefficients. data (),
+	                        reinterpret_cast<const float *>(buffer. data ()),
+	                        K, L, M, position, avail, out);
+int32_t	drop	= avail - (K - 1);
+	buffer. erase (buffer. begin (), buffer. begin () + drop);
+	position	-= drop * L;
+	return produced;
+}
+
+	resampler::resampler	(int32_t inRate, int32_t outRate) {
+	this	-> inRate	= inRate;
+	this	-> outRate	= outRate;
+	filter		= nullptr;
+#ifdef	HAVE_LIBSAMPLERATE
+	converter	= nullptr;
+#endif
+	if (inRate == outRate)
+	   return;
+#ifdef	HAVE_LIBSAMPLERATE
+	if (selected. load () == RESAMPLE_LIBSAMPLERATE) {
+	   int	err;
+	   converter	= src_new (SRC_SINC_FASTEST, 2, &err);
+	   if (converter != nullptr)
+	      return;
+	   fprintf (stderr, "libsamplerate: %s, using polyphase\n",
+	                                         src_strerror (err));
+	}
+#endif
+	filter	= new polyphaseFilter (inRate, outRate,
+	                               DAB_PASSBAND, DAB_STOPBAND);
+}
+
+	resampler::~resampler	() {
+	delete filter;
+#ifdef	HAVE_LIBSAMPLERATE
+	if (converter != nullptr)
+	   src_delete (converter);
+#endif
+}
+
+//	libsamplerate may hold back a few samples in one call and
+//	deliver them in the next one
+int32_t	resampler::maxOutput	(int32_t n) {
+	if (filter != nullptr)
+	   return filter -> maxOutput (n);
+#ifdef	HAVE_LIBSAMPLERATE
+	if (converter != nullptr)
+	   return (int64_t)(n + 1) * outRate / inRate + 256;
+#endif
+	return n;
+}
+
+const char	*resampler::name	() {
+	if (filter != nullptr)
+	   return "polyphase";
+#ifdef	HAVE_LIBSAMPLERATE
+	if (converter != nullptr)
+	   return "libsamplerate";
+#endif
+	return "none";
+}
+
+int32_t	resampler::process	(const std::complex<float> *in,
+	                         int32_t n,
+	                         std::complex<float> *out) {
+	if (filter != nullptr)
+	   return filter -> process (in, n, out);
+#ifdef	HAVE_LIBSAMPLERATE
+	if (converter != nullptr) {
+	   SRC_DATA d;
+	   int32_t produced	= 0;
+	   memset (&d, 0, sizeof (d));
+	   d. src_ratio		= (double)outRate / inRate;
+	   d. end_of_input	= 0;
+//	I and Q are two interleaved channels
+	   int32_t room		= maxOutput (n);
+	   while ((n > 0) && (produced < room)) {
+	      d. data_in	= reinterpret_cast<const float *>(in);
+	      d. input_frames	= n;
+	      d. data_out	= reinterpret_cast<float *>(out + produced);
+	      d. output_frames	= room - produced;
+	      if (src_process (converter, &d) != 0)
+	         break;
+	      if ((d. input_frames_used == 0) && (d. output_frames_gen == 0))
+	         break;
+	      in	+= d. input_frames_used;
+	      n		-= d. input_frames_used;
+	      produced	+= d. output_frames_gen;
+	   }
+	   return produced;
+	}
+#endif
+	memcpy (out, in, n * sizeof (std::complex<float>));
+	return n;
+}
+
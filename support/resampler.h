@@ -0,0 +1,100 @@
+#
+/*
+ *    Copyright (C) 2020
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of channelScanner
+ *
+ *    channelScanner is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    channelScanner is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with channelScanner; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *	Rate conversion of a device (or file) stream to the
+ *	2048000 samples/second of the decoder.
+ *	polyphaseFilter is a rational L/M resampler, the L phases of
+ *	the low pass are computed once, the inner product runs with
+ *	SSE2/AVX2 (x86) or NEON (arm) when available.
+ *	resampler uses the polyphaseFilter or, when compiled with
+ *	HAVE_LIBSAMPLERATE and selected, libsamplerate.
+ */
+#ifndef	__RESAMPLER__
+#define	__RESAMPLER__
+
+#include	<stdint.h>
+#include	<complex>
+#include	<vector>
+#include	<string>
+#ifdef	HAVE_LIBSAMPLERATE
+#include	<samplerate.h>
+#endif
+
+//
+//	the DAB signal is 1536 KHz wide, everything from
+//	2048 - 768 KHz on would alias into the signal after resampling
+#define	DAB_PASSBAND	768000
+#define	DAB_STOPBAND	1280000
+
+//
+//	polyphaseFilter resamples from inRate to outRate, with a low pass
+//	with passband "passBand" and stopband starting at "stopBand" (Hz)
+class	polyphaseFilter {
+public:
+			polyphaseFilter	(int32_t inRate, int32_t outRate,
+	                                 int32_t passBand, int32_t stopBand);
+			~polyphaseFilter	();
+//	the number of outputs for n inputs is at most maxOutput (n)
+	int32_t		maxOutput	(int32_t n);
+	int32_t		process		(const std::complex<float> *in,
+	                                 int32_t n,
+	                                 std::complex<float> *out);
+	int32_t		tapsPerPhase	();
+private:
+	int32_t		L;		// interpolation
+	int32_t		M;		// decimation
+	int32_t		K;		// taps per phase, a multiple of 4
+	int32_t		position;	// of the next output, in 1/L inputs
+//	L phases of K taps, each tap twice (for the I and the Q)
+	std::vector<float>	coefficients;
+	std::vector<std::complex<float>>	buffer;
+};
+
+class	resampler {
+public:
+			resampler	(int32_t inRate, int32_t outRate);
+			~resampler	();
+	int32_t		maxOutput	(int32_t n);
+	int32_t		process		(const std::complex<float> *in,
+	                                 int32_t n,
+	                                 std::complex<float> *out);
+//	"polyphase", "libsamplerate" or "none" (equal rates)
+	const char	*name		();
+private:
+	int32_t		inRate;
+	int32_t		outRate;
+	polyphaseFilter	*filter;
+#ifdef	HAVE_LIBSAMPLERATE
+	SRC_STATE	*converter;
+#endif
+};
+
+//	the resampler to be used by the devices, "polyphase" (default)
+//	or "libsamplerate"; false if not available
+bool		resampler_select	(const std::string &);
+//	the inner product used, "avx2", "sse2", "neon" or "generic"
+const char	*resampler_variant	();
+//	force a variant (for testing and benchmarking), false if the
+//	variant is not available here, nullptr restores the default
+bool		resampler_select_variant	(const char *);
+#endif
+
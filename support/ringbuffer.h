@@ -72,90 +72,203 @@
 #include	<stdio.h>
 #include	<string.h>
 #include	<stdint.h>
+#include	<atomic>
+#include	<mutex>
+#include	<condition_variable>
+#include	<chrono>
+#include	<algorithm>
+#ifdef	__linux__
+#include	<unistd.h>
+#include	<sys/mman.h>
+#include	<sys/syscall.h>
+#endif
 /*
  *	a simple ringbuffer, lockfree, however only for a
  *	single reader and a single writer.
  *	Mostly used for getting samples from or to the soundcard
+ *
+ *	The indices are std::atomic's, the writer publishes with
+ *	release, the reader picks up with acquire (and vice versa for
+ *	the read index). Writer and reader state are kept on cache
+ *	lines of their own, and each side keeps a copy of the index
+ *	of the other side, it only reloads the real one when the copy
+ *	says there is not enough data (space).
+ *	A reader (writer) that wants to wait for data (space) can
+ *	block on a condition variable, it is woken up by the other side
+ *	only once the amount it asked for is there.
+ *
+ *	Optionally (Linux only) the buffer is mirrored: the same pages
+ *	are mapped twice, back to back, so a region of up to the buffer
+ *	size starting anywhere in the first mapping is contiguous, and
+ *	reads and writes never have to be split at the wrap.
+ *	If the mapping cannot be made, the buffer is a plain one.
+ *
+ *	Next to the (single) reader, any number of ringTap's can follow
+ *	the data, each with its own cursor. The writer does not wait for
+ *	them, a tap that falls behind loses data, it notices that and
+ *	counts it. A tap can wait for data as the reader does.
  */
-#if defined(__APPLE__)
-#   include <libkern/OSAtomic.h>
-    /* Here are the memory barrier functions. Mac OS X only provides
-       full memory barriers, so the three types of barriers are the same,
-       however, these barriers are superior to compiler-based ones. */
-#   define PaUtil_FullMemoryBarrier()  OSMemoryBarrier()
-#   define PaUtil_ReadMemoryBarrier()  OSMemoryBarrier()
-#   define PaUtil_WriteMemoryBarrier() OSMemoryBarrier()
-#elif defined(__GNUC__)
-    /* GCC >= 4.1 has built-in intrinsics. We'll use those */
-#   if (__GNUC__ > 4) || (__GNUC__ == 4 && __GNUC_MINOR__ >= 1)
-# define PaUtil_FullMemoryBarrier()  __sync_synchronize()
-# define PaUtil_ReadMemoryBarrier()  __sync_synchronize()
-# define PaUtil_WriteMemoryBarrier() __sync_synchronize()
-    /* as a fallback, GCC understands volatile asm and "memory" to mean it
-     * should not reorder memory read/writes */
-#   elif defined( __PPC__ )
-#      define PaUtil_FullMemoryBarrier()  asm volatile("sync":::"memory")
-#      define PaUtil_ReadMemoryBarrier()  asm volatile("sync":::"memory")
-#      define PaUtil_WriteMemoryBarrier() asm volatile("sync":::"memory")
-#   elif defined( __i386__ ) || defined( __i486__ ) || defined( __i586__ ) || defined( __i686__ ) || defined( __x86_64__ )
-#      define PaUtil_FullMemoryBarrier()  asm volatile("mfence":::"memory")
-#      define PaUtil_ReadMemoryBarrier()  asm volatile("lfence":::"memory")
-#      define PaUtil_WriteMemoryBarrier() asm volatile("sfence":::"memory")
-#   else
-#      ifdef ALLOW_SMP_DANGERS
-#         warning Memory barriers not defined on this system or system unknown
-#         warning For SMP safety, you should fix this.
-#         define PaUtil_FullMemoryBarrier()
-#         define PaUtil_ReadMemoryBarrier()
-#         define PaUtil_WriteMemoryBarrier()
-#      else
-#         error Memory barriers are not defined on this system. You can still compile by defining ALLOW_SMP_DANGERS, but SMP safety will not be guaranteed.
-#      endif
-#   endif
-#else
-#   ifdef ALLOW_SMP_DANGERS
-#      warning Memory barriers not defined on this system or system unknown
-#      warning For SMP safety, you should fix this.
-#      define PaUtil_FullMemoryBarrier()
-#      define PaUtil_ReadMemoryBarrier()
-#      define PaUtil_WriteMemoryBarrier()
-#   else
-#      error Memory barriers are not defined on this system. You can still compile by defining ALLOW_SMP_DANGERS, but SMP safety will not be guaranteed.
-#   endif
-#endif
+#define	RB_CACHELINE	64
+
+template <class elementtype>
+class ringTap;
 
 template <class elementtype>
 class RingBuffer {
+friend class ringTap<elementtype>;
 private:
+//	constant after construction
 		uint32_t	bufferSize;
-volatile	uint32_t	writeIndex;
-volatile	uint32_t	readIndex;
 		uint32_t	bigMask;
 	        uint32_t	smallMask;
 		char		*buffer;
+		bool		mirrored;
+		size_t		mapSize;
+		char		pad_0 [RB_CACHELINE];
+//	owned by the writer
+	std::atomic<uint32_t>	writeIndex;
+		uint32_t	cachedRead;
+//	for the taps: the number of elements ever written, and the
+//	number the writer may be writing now
+	std::atomic<uint64_t>	written;
+	std::atomic<uint64_t>	claimed;
+		char		pad_1 [RB_CACHELINE];
+//	owned by the reader
+	std::atomic<uint32_t>	readIndex;
+		uint32_t	cachedWrite;
+		char		pad_2 [RB_CACHELINE];
+//	the blocking part, only touched when someone waits
+	std::atomic<int32_t>	readWanted;
+	std::atomic<int32_t>	writeWanted;
+	std::mutex		waitLock;
+	std::condition_variable	readCond;
+	std::condition_variable	writeCond;
+	std::atomic<int32_t>	tapsWaiting;
+	std::condition_variable	tapCond;
+
+	uint32_t	readAvailable	(uint32_t w, uint32_t r) {
+	   return (w - r) & bigMask;
+	}
+//
+//	after publishing its index the writer (reader) looks at whether
+//	the other side waits, the fence pairs with the one in the
+//	wait functions, so either the waiter sees the new index or we
+//	see the waiter
+	void	wakeReader	(uint32_t w) {
+	   std::atomic_thread_fence (std::memory_order_seq_cst);
+	   int32_t wanted = readWanted. load (std::memory_order_relaxed);
+	   if ((wanted > 0) &&
+	       ((int32_t)readAvailable (w,
+	             readIndex. load (std::memory_order_relaxed)) >= wanted)) {
+	      std::lock_guard<std::mutex> lk (waitLock);
+	      readCond. notify_all ();
+	   }
+//	the taps check for themselves whether there is enough
+	   if (tapsWaiting. load (std::memory_order_relaxed) > 0) {
+	      std::lock_guard<std::mutex> lk (waitLock);
+	      tapCond. notify_all ();
+	   }
+	}
+
+	void	wakeWriter	(uint32_t r) {
+	   std::atomic_thread_fence (std::memory_order_seq_cst);
+	   int32_t wanted = writeWanted. load (std::memory_order_relaxed);
+	   if ((wanted > 0) &&
+	       ((int32_t)(bufferSize - readAvailable (
+	             writeIndex. load (std::memory_order_relaxed), r)) >= wanted)) {
+	      std::lock_guard<std::mutex> lk (waitLock);
+	      writeCond. notify_all ();
+	   }
+	}
+//
+//	map a memfd twice, the size should be a multiple of the page size
+	char	*mirror		(size_t size) {
+#ifdef	__linux__
+	   long page	= sysconf (_SC_PAGESIZE);
+	   if ((page <= 0) || (size % page) != 0)
+	      return nullptr;
+	   int fd	= syscall (SYS_memfd_create, "ringbuffer", 0);
+	   if (fd < 0)
+	      return nullptr;
+	   if (ftruncate (fd, size) < 0) {
+	      close (fd);
+	      return nullptr;
+	   }
+	   void *base	= mmap (nullptr, 2 * size, PROT_NONE,
+	                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	   if (base == MAP_FAILED) {
+	      close (fd);
+	      return nullptr;
+	   }
+	   char *b	= static_cast<char *>(base);
+	   if ((mmap (b, size, PROT_READ | PROT_WRITE,
+	              MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) ||
+	       (mmap (b + size, size, PROT_READ | PROT_WRITE,
+	              MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED)) {
+	      munmap (base, 2 * size);
+	      close (fd);
+	      return nullptr;
+	   }
+//	the mappings keep the pages
+	   close (fd);
+	   return b;
+#else
+	   (void)size;
+	   return nullptr;
+#endif
+	}
 public:
-	RingBuffer (uint32_t elementCount) {
+	RingBuffer (uint32_t elementCount, bool wantMirror = false) {
 	if (((elementCount - 1) & elementCount) != 0)
 	    elementCount = 2 * 16384;	/* default	*/
 
 	bufferSize	= elementCount;
-	buffer		= new char [2 * bufferSize * sizeof (elementtype)];
-	writeIndex	= 0;
-	readIndex	= 0;
+	mapSize		= (size_t)bufferSize * sizeof (elementtype);
+	buffer		= wantMirror ? mirror (mapSize) : nullptr;
+	mirrored	= buffer != nullptr;
+	if (wantMirror && !mirrored)
+	   fprintf (stderr, "ringbuffer: no mirrored mapping, using a plain buffer\n");
+	if (!mirrored)
+	   buffer	= new char [bufferSize * sizeof (elementtype)];
+	writeIndex. store (0);
+	readIndex. store (0);
+	cachedRead	= 0;
+	cachedWrite	= 0;
+	written. store (0);
+	claimed. store (0);
+	readWanted. store (0);
+	writeWanted. store (0);
+	tapsWaiting. store (0);
 	smallMask	= (elementCount)- 1;
 	bigMask		= (elementCount * 2) - 1;
 }
 
 	~RingBuffer () {
+#ifdef	__linux__
+	   if (mirrored) {
+	      munmap (buffer, 2 * mapSize);
+	      return;
+	   }
+#endif
 	   delete[]	 buffer;
 }
 
+bool	isMirrored	() {
+	return mirrored;
+}
+
+uint32_t	capacity	() {
+	return bufferSize;
+}
+
 /*
  * 	functions for checking available data for reading and space
- * 	for writing
+ * 	for writing, these look at both (real) indices, and can be
+ *	called from either side
  */
 int32_t	GetRingBufferReadAvailable (void) {
-	return (writeIndex - readIndex) & bigMask;
+	return readAvailable (writeIndex. load (std::memory_order_acquire),
+	                      readIndex. load (std::memory_order_acquire));
 }
 
 int32_t	ReadSpace	(void){
@@ -170,45 +283,120 @@ int32_t	WriteSpace	(void) {
 	return GetRingBufferWriteAvailable ();
 }
 
+//	the indices keep following the number of elements written, so
+//	the slot of an element is the same for the reader and the taps
 void	FlushRingBuffer () {
-	writeIndex	= 0;
-	readIndex	= 0;
+uint32_t w	= written. load () & bigMask;
+	writeIndex. store (w);
+	readIndex. store (w);
+	cachedRead	= w;
+	cachedWrite	= w;
+}
+//
+//	positions counted from the start, the number of elements written
+//	and the number read (or flushed). The first is to be called by
+//	the writer, the second by the reader; readIndex follows the
+//	position modulo 2 * bufferSize and the reader is never more
+//	than bufferSize behind
+uint64_t	WritePosition	() {
+	return written. load (std::memory_order_relaxed);
+}
+
+uint64_t	ReadPosition	() {
+uint64_t w	= written. load (std::memory_order_acquire);
+	return w - ((w - readIndex. load (std::memory_order_relaxed)) & bigMask);
+}
+/*
+ *	wait - at most ms milliseconds - until at least n elements
+ *	can be read (written). Returns true if they can.
+ *	The wait is in small steps, so a caller that loops on
+ *	it can check its own stop flag
+ */
+bool	WaitForReadAvailable	(int32_t n, int32_t ms) {
+	if (GetRingBufferReadAvailable () >= n)
+	   return true;
+	std::unique_lock<std::mutex> lk (waitLock);
+	readWanted. store (n, std::memory_order_relaxed);
+	std::atomic_thread_fence (std::memory_order_seq_cst);
+	bool res = readCond. wait_for (lk, std::chrono::milliseconds (ms),
+	                  [&] { return GetRingBufferReadAvailable () >= n; });
+	readWanted. store (0, std::memory_order_relaxed);
+	return res;
+}
+
+bool	WaitForWriteAvailable	(int32_t n, int32_t ms) {
+	if (GetRingBufferWriteAvailable () >= n)
+	   return true;
+	std::unique_lock<std::mutex> lk (waitLock);
+	writeWanted. store (n, std::memory_order_relaxed);
+	std::atomic_thread_fence (std::memory_order_seq_cst);
+	bool res = writeCond. wait_for (lk, std::chrono::milliseconds (ms),
+	                  [&] { return GetRingBufferWriteAvailable () >= n; });
+	writeWanted. store (0, std::memory_order_relaxed);
+	return res;
+}
+/*
+ *	wake up anyone waiting, e.g. when stopping
+ */
+void	WakeAll	() {
+	std::lock_guard<std::mutex> lk (waitLock);
+	readCond. notify_all ();
+	writeCond. notify_all ();
+	tapCond. notify_all ();
 }
-/* ensure that previous writes are seen before we update the write index 
-   (write after write)
+/* the release makes the elements written visible before the index
  */
 int32_t AdvanceRingBufferWriteIndex (int32_t elementCount) {
-	PaUtil_WriteMemoryBarrier();
-	return writeIndex = (writeIndex + elementCount) & bigMask;
+uint32_t w = (writeIndex. load (std::memory_order_relaxed) +
+	                                     elementCount) & bigMask;
+	written. store (written. load (std::memory_order_relaxed) +
+	                      elementCount, std::memory_order_release);
+	writeIndex. store (w, std::memory_order_release);
+	wakeReader (w);
+	return w;
 }
 
-/* ensure that previous reads (copies out of the ring buffer) are
- * always completed before updating (writing) the read index. 
- * (write-after-read) => full barrier
+/* the release ensures that the reads (copies out of the ring buffer)
+ * are completed before the writer sees the space
  */
 int32_t AdvanceRingBufferReadIndex (int32_t elementCount) {
-    PaUtil_FullMemoryBarrier();
-    return readIndex = (readIndex + elementCount) & bigMask;
+uint32_t r = (readIndex. load (std::memory_order_relaxed) +
+	                                     elementCount) & bigMask;
+	readIndex. store (r, std::memory_order_release);
+	wakeWriter (r);
+	return r;
 }
 
 /***************************************************************************
 ** Get address of region(s) to which we can write data.
 ** If the region is contiguous, size2 will be zero.
-** If non-contiguous, size2 will be the size of second region.
+** If non-contiguous, size2 will be the size of second region,
+** for a mirrored buffer this never happens.
 ** Returns room available to be written or elementCount, whichever is smaller.
+** To be called by the writer only.
 */
 int32_t GetRingBufferWriteRegions (uint32_t elementCount,
                                    void **dataPtr1, int32_t *sizePtr1,
                                    void **dataPtr2, int32_t *sizePtr2 ) {
 uint32_t   index;
-uint32_t   available = GetRingBufferWriteAvailable ();
+uint32_t   w		= writeIndex. load (std::memory_order_relaxed);
+uint32_t   available	= bufferSize - readAvailable (w, cachedRead);
 
+	if (elementCount > available) {
+	   cachedRead	= readIndex. load (std::memory_order_acquire);
+	   available	= bufferSize - readAvailable (w, cachedRead);
+	}
 	if (elementCount > available)
 	   elementCount = available;
+//	the taps must know which elements may be overwritten, before
+//	we start writing them
+	claimed. store (written. load (std::memory_order_relaxed) +
+	                      elementCount, std::memory_order_relaxed);
+	std::atomic_thread_fence (std::memory_order_release);
 
 /* Check to see if write is not contiguous. */
-	index = writeIndex & smallMask;
-	if ((index + elementCount) > bufferSize ) {
+	index = w & smallMask;
+	if (!mirrored && ((index + elementCount) > bufferSize)) {
         /* Write data in two blocks that wrap the buffer. */
            int32_t   firstHalf = bufferSize - index;
            *dataPtr1	= &buffer[index * sizeof(elementtype)];
@@ -223,30 +411,34 @@ uint32_t   available = GetRingBufferWriteAvailable ();
 	   *sizePtr2	= 0;
 	}
 
-	if (available > 0)
-           PaUtil_FullMemoryBarrier(); /* (write-after-read) => full barrier */
-
 	return elementCount;
 }
 
 /***************************************************************************
 ** Get address of region(s) from which we can read data.
 ** If the region is contiguous, size2 will be zero.
-** If non-contiguous, size2 will be the size of second region.
+** If non-contiguous, size2 will be the size of second region,
+** for a mirrored buffer this never happens.
 ** Returns room available to be read or elementCount, whichever is smaller.
+** To be called by the reader only.
 */
 int32_t GetRingBufferReadRegions (uint32_t elementCount,
 	                          void **dataPtr1, int32_t *sizePtr1,
 	                          void **dataPtr2, int32_t *sizePtr2) {
 uint32_t   index;
-uint32_t   available = GetRingBufferReadAvailable (); /* doesn't use memory barrier */
+uint32_t   r		= readIndex. load (std::memory_order_relaxed);
+uint32_t   available	= readAvailable (cachedWrite, r);
 
+	if (elementCount > available) {
+	   cachedWrite	= writeIndex. load (std::memory_order_acquire);
+	   available	= readAvailable (cachedWrite, r);
+	}
 	if (elementCount > available)
 	   elementCount = available;
 
 /* Check to see if read is not contiguous. */
-	index = readIndex & smallMask;
-	if ((index + elementCount) > bufferSize) {
+	index = r & smallMask;
+	if (!mirrored && ((index + elementCount) > bufferSize)) {
         /* Write data in two blocks that wrap the buffer. */
            int32_t firstHalf = bufferSize - index;
 	   *dataPtr1 = &buffer [index * sizeof(elementtype)];
@@ -261,9 +453,6 @@ uint32_t   available = GetRingBufferReadAvailable (); /* doesn't use memory barr
 	   *sizePtr2 = 0;
 	}
     
-	if (available)
-           PaUtil_ReadMemoryBarrier(); /* (read-after-read) => read barrier */
-
 	return elementCount;
 }
 
@@ -308,8 +497,6 @@ void	*data2;
 }
 
 int32_t	skipDataInBuffer (uint32_t n_values) {
-//	ensure that we have the correct read and write indices
-	PaUtil_FullMemoryBarrier ();
 	if (n_values > GetRingBufferReadAvailable ())
 	   n_values = GetRingBufferReadAvailable ();
 	AdvanceRingBufferReadIndex (n_values);
@@ -317,5 +504,106 @@ int32_t	skipDataInBuffer (uint32_t n_values) {
 }
 
 };
-#endif
+//
+//	A ringTap reads - copies - the data written into the buffer
+//	after the tap was made. It is to be used by a single thread.
+//	The element at position p (counted from the start) lives in
+//	the slot of p - bufferSize as well, so it is overwritten as soon
+//	as the writer claims position p + bufferSize. After copying we
+//	check that this did not happen, if it did, the data is counted
+//	as lost and the tap jumps ahead.
+template <class elementtype>
+class ringTap {
+private:
+	RingBuffer<elementtype>	*theRing;
+	uint64_t	cursor;
+	int64_t		delivered;
+	int64_t		lost;
+	int64_t		maxLag;
+public:
+	ringTap (RingBuffer<elementtype> *r) {
+	theRing		= r;
+	cursor		= r -> written. load (std::memory_order_acquire);
+	delivered	= 0;
+	lost		= 0;
+	maxLag		= 0;
+}
+	~ringTap () {}
+
+int32_t	available	() {
+uint64_t w	= theRing -> written. load (std::memory_order_acquire);
+	return (int32_t)std::min (w - cursor,
+	                          (uint64_t)theRing -> bufferSize);
+}
+
+//
+//	wait - at most ms milliseconds - until at least n elements
+//	are available, as WaitForReadAvailable does for the reader
+bool	waitForData	(int32_t n, int32_t ms) {
+	if (available () >= n)
+	   return true;
+	std::unique_lock<std::mutex> lk (theRing -> waitLock);
+	theRing -> tapsWaiting. fetch_add (1, std::memory_order_relaxed);
+	std::atomic_thread_fence (std::memory_order_seq_cst);
+	bool res = theRing -> tapCond. wait_for (lk,
+	                             std::chrono::milliseconds (ms),
+	                             [&] { return available () >= n; });
+	theRing -> tapsWaiting. fetch_sub (1, std::memory_order_relaxed);
+	return res;
+}
 
+int32_t	getDataFromBuffer	(elementtype *data, int32_t n) {
+uint64_t w	= theRing -> written. load (std::memory_order_acquire);
+uint64_t size	= theRing -> bufferSize;
+
+	if (w - cursor > size) {	// overtaken, forget the oldest
+	   lost		+= w - size - cursor;
+	   cursor	= w - size;
+	}
+	if ((int64_t)(w - cursor) > maxLag)
+	   maxLag	= w - cursor;
+	if ((uint64_t)n > w - cursor)
+	   n	= w - cursor;
+	if (n <= 0)
+	   return 0;
+
+uint32_t index	= cursor & theRing -> smallMask;
+int32_t	first	= theRing -> mirrored ? n :
+	                     std::min ((int32_t)(size - index), n);
+const elementtype *b	= reinterpret_cast<const elementtype *>
+	                                            (theRing -> buffer);
+	memcpy (data, &b [index], first * sizeof (elementtype));
+	if (first < n)
+	   memcpy (&data [first], b, (n - first) * sizeof (elementtype));
+
+	std::atomic_thread_fence (std::memory_order_acquire);
+	if (theRing -> claimed. load (std::memory_order_relaxed) >
+	                                          cursor + size) {
+	   lost		+= n;
+	   cursor	+= n;
+	   return 0;
+	}
+	cursor		+= n;
+	delivered	+= n;
+	return n;
+}
+//
+//	statistics, the lag is the amount of data written but not
+//	yet read by the tap
+int64_t	lag		() {
+	return theRing -> written. load (std::memory_order_acquire) - cursor;
+}
+
+int64_t	maximumLag	() {
+	return maxLag;
+}
+
+int64_t	lostSamples	() {
+	return lost;
+}
+
+int64_t	deliveredSamples () {
+	return delivered;
+}
+};
+#endif
@@ -0,0 +1,194 @@
+#
+/*
+ *    Copyright (C) 2020
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of channelScanner
+ *
+ *    channelScanner is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    channelScanner is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with channelScanner; if not, write to the Free Software
+ */
+#include	"shm-ring.h"
+#include	<stdio.h>
+#include	<string.h>
+#include	<unistd.h>
+#include	<fcntl.h>
+#include	<sys/mman.h>
+#include	<sys/stat.h>
+#include	<new>
+#include	<algorithm>
+
+static
+std::string	shmPath	(const std::string &name) {
+	return name. size () > 0 && name [0] == '/' ? name : "/" + name;
+}
+
+	shmRing::shmRing	(const std::string &name,
+	                         uint32_t	size,
+	                         int32_t	sampleRate,
+	                         int32_t	nrBits,
+	                         int32_t	frequency) {
+	static_assert (ATOMIC_LLONG_LOCK_FREE == 2,
+	               "shared memory needs lock free 64 bit atomics");
+	if (((size - 1) & size) != 0)
+	   throw 41;
+	shmName	= shmPath (name);
+	owner	= true;
+	mapSize	= SHM_HEADER_SIZE + (size_t)size * sizeof (std::complex<float>);
+	int fd	= shm_open (shmName. c_str (), O_CREAT | O_RDWR | O_TRUNC, 0644);
+	if (fd < 0) {
+	   fprintf (stderr, "cannot create shared memory %s\n",
+	                                           shmName. c_str ());
+	   throw 42;
+	}
+	if (ftruncate (fd, mapSize) < 0) {
+	   close (fd);
+	   shm_unlink (shmName. c_str ());
+	   throw 43;
+	}
+	map (fd, PROT_READ | PROT_WRITE);
+	header	= new (base) shmHeader;
+	header -> size		= size;
+	header -> sampleRate	= sampleRate;
+	header -> nrBits	= nrBits;
+	header -> frequency. store (frequency);
+	header -> written. store (0);
+	header -> claimed. store (0);
+	header -> alive. store (1);
+	header -> version	= SHM_VERSION;
+//	the magic last, a reader checks it
+	std::atomic_thread_fence (std::memory_order_release);
+	header -> magic		= SHM_MAGIC;
+	mask	= size - 1;
+}
+
+	shmRing::shmRing	(const std::string &name) {
+	shmName	= shmPath (name);
+	owner	= false;
+	int fd	= shm_open (shmName. c_str (), O_RDONLY, 0);
+	if (fd < 0) {
+	   fprintf (stderr, "cannot open shared memory %s\n",
+	                                           shmName. c_str ());
+	   throw 44;
+	}
+struct stat st;
+	if ((fstat (fd, &st) < 0) || (st. st_size < SHM_HEADER_SIZE)) {
+	   close (fd);
+	   throw 45;
+	}
+	mapSize	= st. st_size;
+	map (fd, PROT_READ);
+	header	= reinterpret_cast<shmHeader *>(base);
+	std::atomic_thread_fence (std::memory_order_acquire);
+	if ((header -> magic != SHM_MAGIC) ||
+	    (header -> version != SHM_VERSION) ||
+	    (SHM_HEADER_SIZE + (size_t)header -> size *
+	                sizeof (std::complex<float>) > mapSize)) {
+	   fprintf (stderr, "%s is not a sample stream\n", shmName. c_str ());
+	   munmap (base, mapSize);
+	   throw 46;
+	}
+	mask	= header -> size - 1;
+}
+
+	shmRing::~shmRing	() {
+	if (owner)
+	   header -> alive. store (0);
+	munmap (base, mapSize);
+	if (owner)
+	   shm_unlink (shmName. c_str ());
+}
+
+void	shmRing::map	(int fd, int prot) {
+void	*p	= mmap (nullptr, mapSize, prot, MAP_SHARED, fd, 0);
+	close (fd);
+	if (p == MAP_FAILED) {
+	   if (owner)
+	      shm_unlink (shmName. c_str ());
+	   throw 47;
+	}
+	base	= static_cast<uint8_t *>(p);
+	data	= reinterpret_cast<std::complex<float> *>(base + SHM_HEADER_SIZE);
+}
+//
+//	the writer claims the slots before overwriting them, the
+//	release fence orders the claim before the stores of the data
+void	shmRing::put	(const std::complex<float> *v, int32_t n) {
+	while (n > 0) {
+	   int32_t m	= std::min (n, (int32_t)(header -> size / 4));
+	   uint64_t w	= header -> written. load (std::memory_order_relaxed);
+	   header -> claimed. store (w + m, std::memory_order_relaxed);
+	   std::atomic_thread_fence (std::memory_order_release);
+	   uint32_t index	= w & mask;
+	   int32_t first	= std::min ((int32_t)(header -> size - index), m);
+	   memcpy (&data [index], v, first * sizeof (std::complex<float>));
+	   memcpy (data, &v [first], (m - first) * sizeof (std::complex<float>));
+	   header -> written. store (w + m, std::memory_order_release);
+	   v	+= m;
+	   n	-= m;
+	}
+}
+
+void	shmRing::setFrequency	(int32_t f) {
+	header -> frequency. store (f);
+}
+
+int32_t	shmRing::get	(uint64_t *cursor, std::complex<float> *v,
+	                 int32_t n, int64_t *lost) {
+uint64_t w	= header -> written. load (std::memory_order_acquire);
+uint64_t size	= header -> size;
+
+	if (w - *cursor > size) {
+	   *lost	+= w - size - *cursor;
+	   *cursor	= w - size;
+	}
+	if ((uint64_t)n > w - *cursor)
+	   n	= w - *cursor;
+	if (n <= 0)
+	   return 0;
+
+uint32_t index	= *cursor & mask;
+int32_t	first	= std::min ((int32_t)(size - index), n);
+	memcpy (v, &data [index], first * sizeof (std::complex<float>));
+	memcpy (&v [first], data, (n - first) * sizeof (std::complex<float>));
+	std::atomic_thread_fence (std::memory_order_acquire);
+	if (header -> claimed. load (std::memory_order_relaxed) >
+	                                             *cursor + size) {
+	   *lost	+= n;
+	   *cursor	+= n;
+	   return 0;
+	}
+	*cursor	+= n;
+	return n;
+}
+
+uint64_t shmRing::position	() {
+	return header -> written. load (std::memory_order_acquire);
+}
+
+int32_t	shmRing::frequency	() {
+	return header -> frequency. load ();
+}
+
+int32_t	shmRing::bitDepth	() {
+	return header -> nrBits;
+}
+
+bool	shmRing::alive		() {
+	return header -> alive. load () != 0;
+}
+
+std::string shmRing::name	() {
+	return shmName;
+}
@@ -0,0 +1,95 @@
+#
+/*
+ *    Copyright (C) 2020
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of channelScanner
+ *
+ *    channelScanner is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    channelScanner is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with channelScanner; if not, write to the Free Software
+ *
+ *	The shmRing is a ringbuffer for the 2048000 samples/s stream of
+ *	one device in POSIX shared memory, so that a number of processes
+ *	can use the stream of a single device.
+ *	There is a single writer - the process owning the device - that
+ *	never waits. The readers each keep their own cursor, a sequence
+ *	number counting the samples from the start of the stream. As with
+ *	the ringTap, a reader checks after copying that the writer did not
+ *	claim the slots it copied from, a reader that is too slow loses
+ *	samples, it knows how many.
+ */
+#ifndef	__SHM_RING__
+#define	__SHM_RING__
+
+#include	<stdint.h>
+#include	<atomic>
+#include	<string>
+#include	<complex>
+
+#define	SHM_MAGIC	0x44414251
+#define	SHM_VERSION	1
+#define	SHM_HEADER_SIZE	4096
+
+//	the header, at the start of the shared memory. The atomics are
+//	used by more processes, so they must be lock free
+class	shmHeader {
+public:
+	uint32_t		magic;
+	uint32_t		version;
+	uint32_t		size;		// in samples, a power of 2
+	int32_t			sampleRate;
+	int32_t			nrBits;
+	std::atomic<int32_t>	frequency;
+	std::atomic<int32_t>	alive;
+	char			pad_0 [64];
+	std::atomic<uint64_t>	written;
+	std::atomic<uint64_t>	claimed;
+};
+
+class	shmRing {
+public:
+//	the writer creates the segment
+			shmRing		(const std::string &name,
+	                                 uint32_t	size,
+	                                 int32_t	sampleRate,
+	                                 int32_t	nrBits,
+	                                 int32_t	frequency);
+//	a reader attaches to it
+			shmRing		(const std::string &name);
+			~shmRing	();
+	void		put		(const std::complex<float> *,
+	                                 int32_t);
+	void		setFrequency	(int32_t);
+//	for the reader: copy at most n samples from *cursor on, the
+//	cursor is advanced, samples no longer there are added to *lost
+	int32_t		get		(uint64_t *cursor,
+	                                 std::complex<float> *,
+	                                 int32_t n, int64_t *lost);
+	uint64_t	position	();
+	int32_t		frequency	();
+	int32_t		bitDepth	();
+	bool		alive		();
+	std::string	name		();
+private:
+	std::string	shmName;
+	bool		owner;
+	size_t		mapSize;
+	uint8_t		*base;
+	shmHeader	*header;
+	std::complex<float>	*data;
+	uint32_t	mask;
+	void		map		(int fd, int prot);
+};
+#endif
+
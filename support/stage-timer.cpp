@@ -0,0 +1,119 @@
+#
+/*
+ *    Copyright (C) 2020
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of channelScanner
+ *
+ *    channelScanner is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    channelScanner is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with channelScanner; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include	"stage-timer.h"
+#include	<string.h>
+
+static
+const char *stageNames [NR_STAGES] = {
+	"timeSyncer::sync",
+	"findIndex",
+	"processBlock_0",
+	"symbols (NCO + FreqCorr)",
+	"ofdm decode + process_ficBlock",
+	"tii",
+	"waiting for samples",
+	"frame"
+};
+
+const char	*stageName	(int stage) {
+	if ((stage < 0) || (stage >= NR_STAGES))
+	   return "unknown";
+	return stageNames [stage];
+}
+
+	stageTimer::stageTimer	() {
+	reset ();
+}
+
+	stageTimer::~stageTimer	() {
+}
+
+void	stageTimer::reset	() {
+	locker. lock ();
+	memset (&stats, 0, sizeof (stats));
+	locker. unlock ();
+	for (int i = 0; i < NR_STAGES; i ++)
+	   frameNs [i] = 0;
+	frameStart	= std::chrono::steady_clock::now ();
+}
+
+void	stageTimer::start	(int stage) {
+	startTime [stage]	= std::chrono::steady_clock::now ();
+}
+
+void	stageTimer::stop	(int stage) {
+	frameNs [stage] += std::chrono::duration_cast<std::chrono::nanoseconds>
+	                (std::chrono::steady_clock::now () -
+	                                        startTime [stage]). count ();
+}
+
+void	stageTimer::start	(int stage, int64_t waitNs) {
+	frameNs [STAGE_WAIT] += waitNs;
+	start (stage);
+}
+
+void	stageTimer::stop	(int stage, int64_t waitNs) {
+	stop (stage);
+	frameNs [stage]		-= waitNs;
+	frameNs [STAGE_WAIT]	+= waitNs;
+}
+
+void	stageTimer::add		(int stage, int64_t ns) {
+	frameNs [stage] += ns;
+}
+//
+//	the frame time is the time between two calls of endFrame,
+//	so it includes failed synchronization attempts
+void	stageTimer::endFrame	() {
+std::chrono::steady_clock::time_point now =
+	                                 std::chrono::steady_clock::now ();
+
+	frameNs [STAGE_FRAME] =
+	         std::chrono::duration_cast<std::chrono::nanoseconds>
+	                                      (now - frameStart). count ();
+	frameStart	= now;
+	locker. lock ();
+	stats. frames ++;
+	for (int i = 0; i < NR_STAGES; i ++) {
+	   int64_t us	= frameNs [i] / 1000;
+	   int bucket	= 0;
+	   while ((us > 0) && (bucket < HISTOGRAM_SIZE - 1)) {
+	      us >>= 1;
+	      bucket ++;
+	   }
+	   stats. totalNs [i]	+= frameNs [i];
+	   if (frameNs [i] > stats. maxNs [i])
+	      stats. maxNs [i] = frameNs [i];
+	   stats. histogram [i][bucket] ++;
+	   frameNs [i]	= 0;
+	}
+	locker. unlock ();
+}
+
+void	stageTimer::get		(stageStatistics *s) {
+	locker. lock ();
+	*s	= stats;
+	locker. unlock ();
+}
+
@@ -0,0 +1,82 @@
+#
+/*
+ *    Copyright (C) 2020
+ *    Jan van Katwijk (J.vanKatwijk@gmail.com)
+ *    Lazy Chair Computing
+ *
+ *    This file is part of channelScanner
+ *
+ *    channelScanner is free software; you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation; either version 2 of the License, or
+ *    (at your option) any later version.
+ *
+ *    channelScanner is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with channelScanner; if not, write to the Free Software
+ *    Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *	Timing of the stages in the processing of a frame.
+ *	Within a frame the time per stage is accumulated without locking,
+ *	at the end of the frame the totals are added to the statistics:
+ *	the sum, the maximum and a histogram with buckets of 2^i
+ *	microseconds.
+ */
+#ifndef	__STAGE_TIMER__
+#define	__STAGE_TIMER__
+
+#include	<stdint.h>
+#include	<chrono>
+#include	<mutex>
+
+#define	STAGE_TIMESYNC		0
+#define	STAGE_FINDINDEX		1
+#define	STAGE_BLOCK_0		2
+#define	STAGE_SYMBOLS		3
+#define	STAGE_FIC		4
+#define	STAGE_TII		5
+#define	STAGE_WAIT		6
+#define	STAGE_FRAME		7
+#define	NR_STAGES		8
+
+#define	HISTOGRAM_SIZE		24
+
+class	stageStatistics {
+public:
+	int32_t		frames;
+	int64_t		totalNs		[NR_STAGES];
+	int64_t		maxNs		[NR_STAGES];
+	int32_t		histogram	[NR_STAGES][HISTOGRAM_SIZE];
+};
+
+const char	*stageName	(int);
+
+class	stageTimer {
+public:
+			stageTimer	();
+			~stageTimer	();
+	void		reset		();
+	void		start		(int stage);
+	void		stop		(int stage);
+//	for stages that read samples: waitNs, the time spent waiting
+//	since the previous call, goes to STAGE_WAIT, at stop it is
+//	taken out of the stage
+	void		start		(int stage, int64_t waitNs);
+	void		stop		(int stage, int64_t waitNs);
+	void		add		(int stage, int64_t ns);
+	void		endFrame	();
+	void		get		(stageStatistics *);
+private:
+	std::mutex	locker;
+	std::chrono::steady_clock::time_point	startTime [NR_STAGES];
+	std::chrono::steady_clock::time_point	frameStart;
+	int64_t		frameNs		[NR_STAGES];
+	stageStatistics	stats;
+};
+
+#endif
+
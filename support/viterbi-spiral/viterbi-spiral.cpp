@@ -197,29 +197,31 @@ uint8_t getbit (uint8_t v, int32_t o) {
 //}
 	
 // depends: POLYS, RATE, COMPUTETYPE
-// 	encode was only used for testing purposes
-//void encode (/*const*/ unsigned char *bytes, COMPUTETYPE *symbols, int nbits) {
-//int	i, k;
-//int	polys [RATE] = POLYS;
-//int	sr = 0;
-//
-//// FIXME: this is slowish
-//// -- remember about the padding!
-//	for (i = 0; i < nbits + (K - 1); i++) {
-//	   int b = bytes[i/8];
-//	   int j = i % 8;
-//	   int bit = (b >> (7-j)) & 1;
-//
-//	   sr = (sr << 1) | bit;
-//	   for (k = 0; k < RATE; k++)
-//	      *(symbols++) = parity(sr & polys[k]);
-//	}
-//}
+// 	encode was only used for testing purposes, it is now used
+//	by the synthetic transmitter.
+//	The input is a vector of frameBits bits (one bit per byte),
+//	the encoder is flushed with K - 1 zero bits, so the output
+//	is RATE * (frameBits + (K - 1)) bits
+void	viterbiSpiral::encode (const uint8_t *bits, uint8_t *symbols) {
+int	i, k;
+int	polys [RATE] = POLYS;
+int	sr = 0;
+
+	for (i = 0; i < frameBits + (K - 1); i++) {
+	   int bit = i < frameBits ? (bits [i] & 01) : 0;
+	   sr = ((sr << 1) | bit) & ((1 << K) - 1);
+	   for (k = 0; k < RATE; k++)
+	      *(symbols++) = parity (sr & polys[k]);
+	}
+}
 
 //	Note that our DAB environment maps the softbits to -127 .. 127
 //	we have to map that onto 0 .. 255
 
-void	viterbiSpiral::deconvolve	(int16_t *input, uint8_t *output) {
+//	The generic (C butterfly) code is kept for comparison, it
+//	is selected by passing "spiral = false"
+void	viterbiSpiral::deconvolve	(int16_t *input, uint8_t *output,
+	                                                 bool spiral) {
 uint32_t	i;
 
 	init_viterbi (&vp, 0);
@@ -229,9 +231,9 @@ uint32_t	i;
 //	   if (temp > 255) temp = 255;
 	   symbols [i] = temp;
 	}
-//	if (!spiral)
-//	   update_viterbi_blk_GENERIC (&vp, symbols, frameBits + (K - 1));
-//	else
+	if (!spiral)
+	   update_viterbi_blk_GENERIC (&vp, symbols, frameBits + (K - 1));
+	else
 	   update_viterbi_blk_SPIRAL (&vp, symbols, frameBits + (K - 1));
 
 	chainback_viterbi (&vp, data, frameBits, 0);
@@ -44,7 +44,8 @@ class	viterbiSpiral {
 public:
 		viterbiSpiral	(int16_t);
 		~viterbiSpiral	(void);
-	void	deconvolve	(int16_t *, uint8_t *);
+	void	deconvolve	(int16_t *, uint8_t *, bool spiral = true);
+	void	encode		(const uint8_t *, uint8_t *);
 private:
 
 	struct v	vp;